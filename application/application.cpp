@@ -29,7 +29,7 @@
 #include "../physics/misc/serialization.h"
 
 #include "worlds.h"
-#include "tickerThread.h"
+#include "../util/tickerThread.h"
 #include "worldBuilder.h"
 
 #include "io/serialization.h"
@@ -50,7 +50,7 @@
 
 namespace P3D::Application {
 
-TickerThread physicsThread;
+Util::TickerThread physicsThread;
 PlayerWorld world(1 / TICKS_PER_SECOND);
 Screen screen;
 
@@ -162,7 +162,7 @@ void setupWorld(int argc, const char** args) {
 }
 
 void setupPhysics() {
-	physicsThread = TickerThread(TICKS_PER_SECOND, TICK_SKIP_TIME, [] () {
+	physicsThread = Util::TickerThread(TICKS_PER_SECOND, TICK_SKIP_TIME, [] () {
 		physicsMeasure.mark(PhysicsProcess::OTHER);
 
 		Graphics::AppDebug::logTickStart();
@@ -274,6 +274,10 @@ double getSpeed() {
 	return physicsThread.getSpeed();
 }
 
+double getTickInterpolation() {
+	return physicsThread.getInterpolationAlpha();
+}
+
 void runTick() {
 	physicsThread.runTick();
 }
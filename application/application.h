@@ -19,6 +19,8 @@ void togglePause();
 void runTick();
 void setSpeed(double newSpeed);
 double getSpeed();
+// how far the physics thread is towards its next tick, see TickerThread::getInterpolationAlpha
+double getTickInterpolation();
 void stop(int returnCode);
 void toggleFlying();
 void onEvent(Engine::Event& event);
@@ -33,7 +33,7 @@ void buildBenchmarkWorld(PlayerWorld& world) {
 	for(int i = 0; i < 10; i++) {
 		for(int j = 0; j < 10; j++) {
 			for(int k = 0; k < 10; k++) {
-				world.addPart(new ExtendedPart(boxShape(1.0, 1.0, 1.0), origin.localToGlobal(CFrame(i * 1.00001, j * 1.00001, k * 1.0001)), basicProperties));
+				world.addPart(world.createPart(boxShape(1.0, 1.0, 1.0), origin.localToGlobal(CFrame(i * 1.00001, j * 1.00001, k * 1.0001)), basicProperties));
 			}
 		}
 	}
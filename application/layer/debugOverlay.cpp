@@ -87,14 +87,17 @@ void DebugOverlay::onRender(Engine::Registry64& registry) {
 		PieChart graphicsPie = toPieChart(Graphics::graphicsMeasure, "Graphics", Vec2f(-leftSide + 1.5f, -0.7f), 0.2f);
 		PieChart physicsPie = toPieChart(physicsMeasure, "Physics", Vec2f(-leftSide + 0.3f, -0.7f), 0.2f);
 		PieChart intersectionPie = toPieChart(intersectionStatistics, "Intersections", Vec2f(-leftSide + 2.7f, -0.7f), 0.2f);
+		PieChart tickTaskPie = toPieChart(tickTaskMeasure, "Tick tasks", Vec2f(-leftSide + 3.9f, -0.7f), 0.2f);
 
 		physicsPie.renderText(GUI::font);
 		graphicsPie.renderText(GUI::font);
 		intersectionPie.renderText(GUI::font);
+		tickTaskPie.renderText(GUI::font);
 
 		physicsPie.renderPie();
 		graphicsPie.renderPie();
 		intersectionPie.renderPie();
+		tickTaskPie.renderPie();
 
 		ParallelArray<long long, 17> gjkColIter = GJKCollidesIterationStatistics.history.avg();
 		ParallelArray<long long, 17> gjkNoColIter = GJKNoCollidesIterationStatistics.history.avg();
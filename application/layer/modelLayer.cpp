@@ -6,6 +6,7 @@
 #include "shader/shaders.h"
 #include "extendedPart.h"
 #include "worlds.h"
+#include "application.h"
 
 #include "../engine/ecs/registry.h"
 #include "ecs/components.h"
@@ -150,6 +151,9 @@ void ModelLayer::onRender(Engine::Registry64& registry) {
 	Shaders::instanceShader.setUniform("lightMatrix", ShadowLayer::lighSpaceMatrix);
 	Shaders::instanceShader.updateSunDirection(sunDirection);
 
+	// parts are drawn in between the last two physics ticks, so rendering faster than the physics doesn't stutter
+	double tickInterpolation = getTickInterpolation();
+
 	// Filter on mesh ID and transparency
 	size_t maxMeshCount = 0;
 	std::map<int, size_t> meshCounter;
@@ -197,7 +201,7 @@ void ModelLayer::onRender(Engine::Registry64& registry) {
 			for (auto mesh = meshes.first; mesh != meshes.second; ++mesh) {
 				ExtendedPart* part = mesh->second;
 
-				Mat4f modelMatrix = part->getCFrame().asMat4WithPreScale(part->hitbox.scale);
+				Mat4f modelMatrix = part->getInterpolatedCFrame(tickInterpolation).asMat4WithPreScale(part->hitbox.scale);
 				Comp::Material material = registry.getOr<Comp::Material>(part->entity, Comp::Material());
 				material.albedo += getAlbedoForPart(screen, part);
 
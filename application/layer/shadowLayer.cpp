@@ -67,14 +67,14 @@ void ShadowLayer::onEvent(Engine::Registry64& registry, Engine::Event& event) {
 }
 
 void ShadowLayer::renderScene(Engine::Registry64& registry) {
-	std::vector<ExtendedPart*> visibleParts;
-	screen.world->syncReadOnlyOperation([&visibleParts, &registry] () {
-		for (ExtendedPart& part : screen.world->iterParts())
-			visibleParts.push_back(&part);
-		});
+	double tickInterpolation = getTickInterpolation();
+	// the snapshot of the last tick, so the shadows never wait for the physics thread
+	const WorldSnapshot& snapshot = screen.world->getLatestSnapshot();
 
-	for (ExtendedPart* part : visibleParts) {
-		Ref<Comp::Mesh> mesh = registry.get<Comp::Mesh>(part->entity);
+	for (const PartSnapshot& partSnapshot : snapshot.parts) {
+		// the part itself may be gone, PlayerWorld stores its entity in the snapshot
+		ExtendedPart::Entity entity = static_cast<ExtendedPart::Entity>(partSnapshot.userData);
+		Ref<Comp::Mesh> mesh = registry.get<Comp::Mesh>(entity);
 
 		if (!mesh.valid())
 			continue;
@@ -82,7 +82,7 @@ void ShadowLayer::renderScene(Engine::Registry64& registry) {
 		if (mesh->id == -1)
 			continue;
 
-		Shaders::depthShader.updateModel(part->getCFrame().asMat4WithPreScale(part->hitbox.scale));
+		Shaders::depthShader.updateModel(partSnapshot.getInterpolatedCFrame(tickInterpolation).asMat4WithPreScale(partSnapshot.scale));
 		Graphics::MeshRegistry::meshes[mesh->id]->render(mesh->mode);
 	}
 }
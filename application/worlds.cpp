@@ -89,4 +89,8 @@ void PlayerWorld::onPartRemoved(ExtendedPart* part) {
 	screen.registry.destroy(part->entity);
 }
 
+std::uint64_t PlayerWorld::getSnapshotUserData(const ExtendedPart& part) const {
+	return part.entity;
+}
+
 };
\ No newline at end of file
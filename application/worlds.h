@@ -17,6 +17,8 @@ public:
 	virtual void applyExternalForces() override;
 	virtual void onPartAdded(ExtendedPart* part) override;
 	virtual void onPartRemoved(ExtendedPart* part) override;
+	// the entity of the part, for the layers which render from the snapshot
+	virtual std::uint64_t getSnapshotUserData(const ExtendedPart& part) const override;
 };
 
 };
\ No newline at end of file
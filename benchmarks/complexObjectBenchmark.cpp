@@ -12,6 +12,6 @@ public:
 	void init() {
 		createFloor(50, 50, 10);
 		Polyhedron object = Library::icosahedron;
-		world.addPart(new Part(polyhedronShape(Library::createSphere(1.0, 7)), GlobalCFrame(0, 2.0, 0), basicProperties));
+		world.addPart(world.createPart(polyhedronShape(Library::createSphere(1.0, 7)), GlobalCFrame(0, 2.0, 0), basicProperties));
 	}
 } complexObjectBench;
@@ -0,0 +1,65 @@
+#include "benchmark.h"
+
+#include "../physics/part.h"
+#include "../physics/physical.h"
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/softconstraints/constraintGroup.h"
+#include "../physics/softconstraints/ballConstraint.h"
+#include "../physics/datastructures/tickArena.h"
+#include "../util/log.h"
+
+#include <vector>
+#include <chrono>
+
+/*
+	Time of one ConstraintGroup::apply on chains of ball constraints of increasing length
+	The time per link should stay flat, the solver is linear in the length of the chain
+*/
+class ConstraintChainBenchmark : public Benchmark {
+	struct Result {
+		std::size_t chainLength;
+		double microsecondsPerApply;
+	};
+
+	static constexpr std::size_t REPEATS = 20;
+
+	std::vector<Result> results;
+
+public:
+	ConstraintChainBenchmark() : Benchmark("constraintChain") {}
+
+	void init() override {
+		results.clear();
+	}
+	void run() override {
+		for(std::size_t chainLength = 250; chainLength <= 8000; chainLength *= 2) {
+			std::vector<Part> parts;
+			parts.reserve(chainLength);
+			for(std::size_t i = 0; i < chainLength; i++) {
+				parts.emplace_back(boxShape(1.0, 0.5, 0.5), GlobalCFrame(i * 1.01, 0.003 * (i % 3), 0.0), PartProperties{1.0, 0.5, 0.5});
+				parts.back().ensureHasParent();
+			}
+			BallConstraint ball(Vec3(0.5, 0.0, 0.0), Vec3(-0.5, 0.0, 0.0));
+			ConstraintGroup group;
+			for(std::size_t i = 0; i + 1 < chainLength; i++) {
+				group.add(parts[i].parent, parts[i + 1].parent, &ball);
+			}
+
+			TickArena arena;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(std::size_t repeat = 0; repeat < REPEATS; repeat++) {
+				arena.reset();
+				group.apply(arena);
+			}
+			std::chrono::duration<double, std::micro> taken = std::chrono::steady_clock::now() - start;
+			results.push_back(Result{chainLength, taken.count() / REPEATS});
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("\n%-10s %-16s %-16s\n", "links", "us per apply", "us per link");
+		for(const Result& r : results) {
+			Log::print("%-10d %-16.1f %-16.3f\n", (int) r.chainLength, r.microsecondsPerApply, r.microsecondsPerApply / r.chainLength);
+		}
+	}
+} constraintChainBenchmark;
@@ -0,0 +1,92 @@
+#include "benchmark.h"
+
+#include "../physics/world.h"
+#include "../physics/integrator.h"
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../util/log.h"
+
+#include <chrono>
+#include <vector>
+#include <cmath>
+
+/*
+	Accuracy against throughput of the integrators, on tumbling boxes which only interact with themselves
+
+	Every combination of integrator and deltaT simulates the same number of seconds
+	Accuracy is the drift of the kinetic energy and of the angular momentum, throughput is simulated seconds per second
+*/
+class IntegratorBenchmark : public Benchmark {
+	struct Result {
+		const char* integratorName;
+		double deltaT;
+		double simulatedSecondsPerSecond;
+		double energyDrift;
+		double angularMomentumDrift;
+	};
+
+	std::vector<Result> results;
+
+	static constexpr int BOX_COUNT = 200;
+	static constexpr double SIMULATED_SECONDS = 5.0;
+
+	void runOne(Integrator integrator, const char* integratorName, double deltaT) {
+		WorldPrototype world(deltaT);
+		world.integrator = integrator;
+
+		std::vector<Part> boxes;
+		boxes.reserve(BOX_COUNT);
+		for(int i = 0; i < BOX_COUNT; i++) {
+			// far enough apart to never collide
+			boxes.emplace_back(boxShape(1.0, 2.0 + 0.002 * i, 3.0), GlobalCFrame((i % 25) * 10.0, (i / 25) * 10.0, 0.0), PartProperties{1.0, 0.7, 0.5});
+		}
+		double initialEnergy = 0.0;
+		double initialAngularMomentum = 0.0;
+		for(int i = 0; i < BOX_COUNT; i++) {
+			world.addPart(&boxes[i]);
+			MotorizedPhysical* phys = boxes[i].parent->mainPhysical;
+			phys->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(0.2 + 0.001 * i, 3.0, 0.3));
+			initialEnergy += phys->getKineticEnergy();
+			initialAngularMomentum += length(phys->getTotalAngularMomentum());
+		}
+
+		int ticks = static_cast<int>(SIMULATED_SECONDS / deltaT);
+		auto start = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < ticks; i++) {
+			world.tick();
+		}
+		auto finish = std::chrono::high_resolution_clock::now();
+		double seconds = (finish - start).count() / 1000000000.0;
+
+		double finalEnergy = 0.0;
+		double finalAngularMomentum = 0.0;
+		for(int i = 0; i < BOX_COUNT; i++) {
+			MotorizedPhysical* phys = boxes[i].parent->mainPhysical;
+			finalEnergy += phys->getKineticEnergy();
+			finalAngularMomentum += length(phys->getTotalAngularMomentum());
+		}
+
+		results.push_back(Result{integratorName, deltaT, SIMULATED_SECONDS / seconds,
+			(finalEnergy - initialEnergy) / initialEnergy, (finalAngularMomentum - initialAngularMomentum) / initialAngularMomentum});
+	}
+
+public:
+	IntegratorBenchmark() : Benchmark("integrators") {}
+
+	void init() override {
+		results.clear();
+	}
+	void run() override {
+		double deltaTs[]{0.001, 0.005, 0.02, 0.05};
+		for(double deltaT : deltaTs) {
+			runOne(Integrator::EXPLICIT, "explicit", deltaT);
+			runOne(Integrator::SEMI_IMPLICIT_GYROSCOPIC, "semi-implicit", deltaT);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("%-14s %-8s %-16s %-14s %-14s\n", "integrator", "deltaT", "sim s per s", "energy drift", "|L| drift");
+		for(const Result& r : results) {
+			Log::print("%-14s %-8.3f %-16.2f %+-14.4f %+-14.4f\n", r.integratorName, r.deltaT, r.simulatedSecondsPerSecond, r.energyDrift, r.angularMomentumDrift);
+		}
+	}
+} integratorBenchmark;
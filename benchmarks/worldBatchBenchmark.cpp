@@ -0,0 +1,68 @@
+#include "benchmark.h"
+
+#include "../physics/world.h"
+#include "../physics/worldBatch.h"
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/misc/gravityForce.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../util/threadPool.h"
+#include "../util/log.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+/*
+	Throughput of many small worlds ticked together, in world ticks per second, for an increasing number of threads
+
+	Every world is a small pile of boxes on a floor, a typical size for a parameter sweep
+*/
+class WorldBatchBenchmark : public Benchmark {
+	struct Result {
+		std::size_t threadCount;
+		double worldTicksPerSecond;
+	};
+
+	static constexpr std::size_t WORLD_COUNT = 256;
+	static constexpr std::size_t TICK_COUNT = 200;
+
+	std::vector<Result> results;
+
+public:
+	WorldBatchBenchmark() : Benchmark("worldBatch") {}
+
+	void init() override {
+		results.clear();
+	}
+	void run() override {
+		WorldPrototype templateWorld(0.01);
+		DirectionalGravity gravity(Vec3(0, -10, 0));
+		templateWorld.addExternalForce(&gravity);
+
+		std::vector<std::unique_ptr<Part>> parts;
+		parts.push_back(std::make_unique<Part>(boxShape(10.0, 1.0, 10.0), GlobalCFrame(0.0, -0.5, 0.0), PartProperties{1.0, 0.7, 0.5}));
+		templateWorld.addTerrainPart(parts.back().get());
+		Shape sharedBox = polyhedronShape(Library::createBox(1.0, 1.0, 1.0));
+		for(int i = 0; i < 8; i++) {
+			parts.push_back(std::make_unique<Part>(sharedBox, GlobalCFrame((i % 4) * 1.5, 0.5 + (i / 4) * 1.2, 0.0), PartProperties{1.0, 0.7, 0.5}));
+			templateWorld.addPart(parts.back().get());
+		}
+
+		std::size_t hardwareThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+		for(std::size_t threadCount = 1; threadCount <= hardwareThreads; threadCount *= 2) {
+			Util::ThreadPool threadPool(threadCount);
+			WorldBatch batch(templateWorld, WORLD_COUNT, threadCount == 1 ? nullptr : &threadPool);
+			batch.tick(TICK_COUNT);
+			results.push_back(Result{threadCount, batch.getWorldTicksPerSecond()});
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("\n%d worlds, %d ticks\n", (int) WORLD_COUNT, (int) TICK_COUNT);
+		Log::print("%-10s %-16s\n", "threads", "world ticks/s");
+		for(const Result& r : results) {
+			Log::print("%-10d %-16.0f\n", (int) r.threadCount, r.worldTicksPerSecond);
+		}
+	}
+} worldBatchBenchmark;
@@ -10,6 +10,7 @@
 
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/shapeCreation.h"
+#include "../physics/geometry/shapeClassRegistry.h"
 #include "../physics/math/linalg/commonMatrices.h"
 
 #include "../physics/misc/shapeLibrary.h"
@@ -169,14 +170,22 @@ void WorldBenchmark::printResults(double timeTakenMillis) {
 	setColor(TerminalColor::MAGENTA);
 	std::cout << "[Intersection Statistics]\n";
 	printBreakdown(intersectionStatistics.history.avg().values, intersectionStatistics.labels, intersectionStatistics.size(), "");
+
+	ShapeClassRegistryStatistics shapeClasses = ShapeClassRegistry::global().getStatistics();
+	setColor(TerminalColor::WHITE);
+	std::cout << "\n";
+	setColor(TerminalColor::MAGENTA);
+	std::cout << "[Shape Classes]\n";
 	setColor(TerminalColor::WHITE);
+	Log::print("%d polyhedron shapes share %d shape classes\n", (int) shapeClasses.requestCount, (int) shapeClasses.shapeClassCount);
+	Log::print("%.1fKB stored, %.1fKB saved by sharing\n", shapeClasses.bytesStored / 1024.0, shapeClasses.bytesSaved / 1024.0);
 }
 
 
 void WorldBenchmark::createFloor(double w, double h, double wallHeight) {
-	world.addTerrainPart(new Part(boxShape(w, 1.0, h), GlobalCFrame(0.0, 0.0, 0.0), basicProperties));
-	world.addTerrainPart(new Part(boxShape(0.8, wallHeight, h), GlobalCFrame(w, wallHeight/2, 0.0), basicProperties));
-	world.addTerrainPart(new Part(boxShape(0.8, wallHeight, h), GlobalCFrame(-w, wallHeight / 2, 0.0), basicProperties));
-	world.addTerrainPart(new Part(boxShape(w, wallHeight, 0.8), GlobalCFrame(0.0, wallHeight / 2, h), basicProperties));
-	world.addTerrainPart(new Part(boxShape(w, wallHeight, 0.8), GlobalCFrame(0.0, wallHeight / 2, -h), basicProperties));
+	world.addTerrainPart(world.createPart(boxShape(w, 1.0, h), GlobalCFrame(0.0, 0.0, 0.0), basicProperties));
+	world.addTerrainPart(world.createPart(boxShape(0.8, wallHeight, h), GlobalCFrame(w, wallHeight/2, 0.0), basicProperties));
+	world.addTerrainPart(world.createPart(boxShape(0.8, wallHeight, h), GlobalCFrame(-w, wallHeight / 2, 0.0), basicProperties));
+	world.addTerrainPart(world.createPart(boxShape(w, wallHeight, 0.8), GlobalCFrame(0.0, wallHeight / 2, h), basicProperties));
+	world.addTerrainPart(world.createPart(boxShape(w, wallHeight, 0.8), GlobalCFrame(0.0, wallHeight / 2, -h), basicProperties));
 }
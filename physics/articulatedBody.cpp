@@ -0,0 +1,55 @@
+#include "articulatedBody.h"
+
+#include "physical.h"
+#include "inertia.h"
+
+static void appendSubtree(std::vector<ArticulatedBodyWorkspace::Node>& nodes, const ConnectedPhysical& conPhys, const RelativeMotion& motionOfSelf) {
+	nodes.push_back(ArticulatedBodyWorkspace::Node{&conPhys, motionOfSelf.extendEnd(conPhys.rigidBody.localCenterOfMass)});
+	for(const ConnectedPhysical& child : conPhys.childPhysicals) {
+		appendSubtree(nodes, child, motionOfSelf + child.getRelativeMotionBetweenParentAndSelf());
+	}
+}
+
+void ArticulatedBodyWorkspace::refresh(const MotorizedPhysical& phys) {
+	// outwards: the motion of every physical relative to the main physical
+	nodes.clear();
+	for(const ConnectedPhysical& child : phys.childPhysicals) {
+		appendSubtree(nodes, child, child.getRelativeMotionBetweenParentAndSelf());
+	}
+
+	// inwards: the sums over all physicals, in the same order as COMMotionTree
+	const RigidBody& mainBody = phys.rigidBody;
+	double mass = mainBody.mass;
+	Vec3 weightedCenterOfMass = mainBody.localCenterOfMass * mainBody.mass;
+	TranslationalMotion weightedMotion(Vec3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+	for(const Node& node : nodes) {
+		double nodeMass = node.phys->rigidBody.mass;
+		weightedMotion += node.motion.relativeMotion.translation * nodeMass;
+		weightedCenterOfMass += node.motion.locationOfRelativeMotion.getPosition() * nodeMass;
+		mass += nodeMass;
+	}
+	this->totalMass = mass;
+	this->centerOfMass = weightedCenterOfMass * (1 / mass);
+	this->motionOfCenterOfMass = weightedMotion * (1 / mass);
+
+	Vec3 mainCOMOffset = mainBody.localCenterOfMass - this->centerOfMass;
+	SymmetricMat3 totalInertia = getTranslatedInertiaAroundCenterOfMass(mainBody.inertia, mainBody.mass, mainCOMOffset);
+	Vec3 totalAngularMomentum = getAngularMomentumFromOffsetOnlyVelocity(mainCOMOffset, -this->motionOfCenterOfMass.getVelocity(), mainBody.mass);
+	for(Node& node : nodes) {
+		node.motion.locationOfRelativeMotion -= this->centerOfMass;
+		node.motion.relativeMotion.translation -= this->motionOfCenterOfMass;
+
+		const RigidBody& body = node.phys->rigidBody;
+		const CFrame& location = node.motion.locationOfRelativeMotion;
+		const Motion& relativeMotion = node.motion.relativeMotion;
+		totalInertia += getTransformedInertiaAroundCenterOfMass(body.inertia, body.mass, location);
+		totalAngularMomentum += getAngularMomentumFromOffset(
+			location.getPosition(),
+			relativeMotion.getVelocity(),
+			relativeMotion.getAngularVelocity(),
+			location.getRotation().localToGlobal(body.inertia),
+			body.mass);
+	}
+	this->inertia = totalInertia;
+	this->internalAngularMomentum = totalAngularMomentum;
+}
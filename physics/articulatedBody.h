@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "math/linalg/vec.h"
+#include "math/linalg/mat.h"
+#include "motion.h"
+#include "relativeMotion.h"
+
+class MotorizedPhysical;
+class ConnectedPhysical;
+
+/*
+	Mass properties of a MotorizedPhysical and its tree of ConnectedPhysicals, computed in two linear passes over a flattened copy of the tree
+
+	The first pass walks the tree from the main physical outwards, and composes the motion of each physical relative to the main physical from
+	that of its parent and its HardPhysicalConnection. The second pass sums the mass, center of mass, inertia and internal angular momentum
+	All joints are driven by their HardConstraint, so there are no free joint coordinates to solve for, this gives the same results as a COMMotionTree
+
+	The storage is kept between refreshes, so a MotorizedPhysical only allocates when its tree grows
+	Everything is expressed in the local space of the main physical, relative to the center of mass of the whole tree
+*/
+class ArticulatedBodyWorkspace {
+public:
+	struct Node {
+		const ConnectedPhysical* phys;
+		// motion of the center of mass of phys, relative to the main physical
+		RelativeMotion motion;
+	};
+
+private:
+	// depth first, in the same order as MotorizedPhysical::mutuallyRecurse
+	std::vector<Node> nodes;
+
+public:
+	double totalMass = 0.0;
+	Vec3 centerOfMass = Vec3(0.0, 0.0, 0.0);
+	TranslationalMotion motionOfCenterOfMass;
+	SymmetricMat3 inertia;
+	Vec3 internalAngularMomentum = Vec3(0.0, 0.0, 0.0);
+
+	// recomputes everything for the current state of the constraints of phys
+	void refresh(const MotorizedPhysical& phys);
+
+	inline std::size_t size() const { return nodes.size(); }
+	inline const Node& operator[](std::size_t index) const { return nodes[index]; }
+};
@@ -650,6 +650,12 @@ inline static void optimizeNodePairVertical(TreeNode& node, TreeNode& group) {
 void TreeNode::improveStructure() {
 	if (!isLeafNode()) {
 		for (int i = 0; i < nodeCount; i++) subTrees[i].improveStructure();
+		improveStructureOfSubTrees();
+	}
+}
+
+void TreeNode::improveStructureOfSubTrees() {
+	if (!isLeafNode()) {
 		// horizontal structure improvement
 		for (int i = 0; i < nodeCount - 1; i++) {
 			TreeNode& A = subTrees[i];
@@ -75,6 +75,8 @@ struct TreeNode {
 	bool recursiveFindAndReplaceObject(const void* find, void* replaceWith, const Bounds& bounds) noexcept;
 
 	void improveStructure();
+	// the part of improveStructure which rearranges the subTrees of this node between each other, without improving within them
+	void improveStructureOfSubTrees();
 
 	size_t getNumberOfObjectsInNode() const;
 	size_t getLengthOfLongestBranch() const;
@@ -511,6 +513,27 @@ struct BoundsTree {
 
 	inline void improveStructure() { if(!isEmpty()) rootNode.improveStructure(); }
 	inline void maxImproveStructure() { for(int i = 0; i < 5; i++) improveStructure(); }
+
+	/*
+		recalculateBounds followed by improveStructure, split up so it can be spread over threads
+		The branches of the root don't depend on each other, refreshBranch may run for each of them at once, followed by refreshRoot
+		The result is the same as that of recalculateBounds and improveStructure
+	*/
+	inline void refreshBranch(int branchIndex) {
+		if(isEmpty() || rootNode.isLeafNode() || branchIndex >= rootNode.nodeCount) return;
+		TreeNode& branch = rootNode.subTrees[branchIndex];
+		recursivelyRecalculateBoundsOfNode(branch);
+		branch.improveStructure();
+	}
+	inline void refreshRoot() {
+		if(isEmpty()) return;
+		if(rootNode.isLeafNode()) {
+			rootNode.bounds = static_cast<Boundable*>(rootNode.object)->getBounds();
+		} else {
+			rootNode.recalculateBoundsFromSubBounds();
+			rootNode.improveStructureOfSubTrees();
+		}
+	}
 	
 	inline size_t getNumberOfObjects() const {
 		if(isEmpty()) {
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+	Counters of an OperationQueue, they may be read from any thread while the queue is in use
+
+	pushRetries counts the times a producer lost the race for a slot to another producer, which is the contention on the queue
+	Latency is the time between pushing an operation and running it, measured when the operation is drained
+*/
+struct OperationQueueStatistics {
+	std::atomic<std::uint64_t> pushes{0};
+	std::atomic<std::uint64_t> pushRetries{0};
+	std::atomic<std::uint64_t> rejectedPushes{0};
+	std::atomic<std::uint64_t> heapClosures{0};
+	std::atomic<std::uint64_t> drainedOperations{0};
+	std::atomic<std::uint64_t> totalLatencyNanos{0};
+	std::atomic<std::uint64_t> maxLatencyNanos{0};
+
+	inline double getAverageLatencyNanos() const {
+		std::uint64_t drained = drainedOperations.load(std::memory_order_relaxed);
+		return drained == 0 ? 0.0 : static_cast<double>(totalLatencyNanos.load(std::memory_order_relaxed)) / drained;
+	}
+};
+
+/*
+	Bounded multi-producer single-consumer queue of void() closures, which doesn't lock and doesn't allocate after construction
+
+	Every slot carries a sequence number, a producer claims a slot by advancing the enqueue position with a CAS and publishes it
+	by bumping the sequence of the slot, the consumer frees it again by bumping the sequence one lap further
+	Closures of up to InlineSize bytes are stored in the slot itself, larger ones are moved to the heap, heapClosures counts these
+
+	tryPush may be called from any thread, drain must only be called from one thread at a time
+	capacity is rounded up to a power of two
+*/
+template<std::size_t InlineSize = 64>
+class OperationQueue {
+	struct Slot {
+		std::atomic<std::size_t> sequence;
+		void (*run)(void* storage) = nullptr;
+		void (*destroy)(void* storage) = nullptr;
+		std::int64_t pushTime = 0;
+		alignas(std::max_align_t) unsigned char storage[InlineSize];
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	std::size_t capacity;
+	std::size_t mask;
+
+	// written by all producers, kept on its own cache line away from the consumer
+	alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+	alignas(64) std::size_t dequeuePosition = 0;
+
+	OperationQueueStatistics statistics;
+
+	static std::int64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// runs the closure and destroys it, so the consumer never touches its type
+	template<typename Func>
+	static void runInline(void* storage) {
+		Func* func = std::launder(reinterpret_cast<Func*>(storage));
+		(*func)();
+		func->~Func();
+	}
+	template<typename Func>
+	static void runOnHeap(void* storage) {
+		std::unique_ptr<Func> func(*std::launder(reinterpret_cast<Func**>(storage)));
+		(*func)();
+	}
+	// destroys the closure without running it
+	template<typename Func>
+	static void destroyInline(void* storage) {
+		std::launder(reinterpret_cast<Func*>(storage))->~Func();
+	}
+	template<typename Func>
+	static void destroyOnHeap(void* storage) {
+		delete *std::launder(reinterpret_cast<Func**>(storage));
+	}
+
+public:
+	explicit OperationQueue(std::size_t capacity) {
+		std::size_t roundedCapacity = 2;
+		while(roundedCapacity < capacity) roundedCapacity *= 2;
+		this->capacity = roundedCapacity;
+		this->mask = roundedCapacity - 1;
+		this->slots.reset(new Slot[roundedCapacity]);
+		for(std::size_t i = 0; i < roundedCapacity; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+	/*
+		Closures which haven't been drained are destroyed without being run
+		Owners which need the pending operations to happen must call drain() first
+	*/
+	~OperationQueue() {
+		while(slots[dequeuePosition & mask].sequence.load(std::memory_order_acquire) == dequeuePosition + 1) {
+			Slot& slot = slots[dequeuePosition & mask];
+			slot.destroy(slot.storage);
+			slot.sequence.store(dequeuePosition + capacity, std::memory_order_relaxed);
+			dequeuePosition++;
+		}
+	}
+
+	OperationQueue(const OperationQueue&) = delete;
+	OperationQueue& operator=(const OperationQueue&) = delete;
+
+	/*
+		Adds func to the queue, returns false without touching func if the queue is full
+	*/
+	template<typename Func>
+	bool tryPush(Func&& func) {
+		using Closure = typename std::decay<Func>::type;
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Slot* slot;
+		while(true) {
+			slot = &slots[position & mask];
+			std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if(difference == 0) {
+				if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+				statistics.pushRetries.fetch_add(1, std::memory_order_relaxed);
+			} else if(difference < 0) {
+				// the consumer hasn't freed this slot yet, the queue is full
+				statistics.rejectedPushes.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+				statistics.pushRetries.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		if constexpr(sizeof(Closure) <= InlineSize && alignof(Closure) <= alignof(std::max_align_t)) {
+			new(slot->storage) Closure(std::forward<Func>(func));
+			slot->run = &runInline<Closure>;
+			slot->destroy = &destroyInline<Closure>;
+		} else {
+			new(slot->storage) Closure*(new Closure(std::forward<Func>(func)));
+			slot->run = &runOnHeap<Closure>;
+			slot->destroy = &destroyOnHeap<Closure>;
+			statistics.heapClosures.fetch_add(1, std::memory_order_relaxed);
+		}
+		slot->pushTime = now();
+		statistics.pushes.fetch_add(1, std::memory_order_relaxed);
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+		Runs the operations which were pushed before the call, in the order in which their slots were claimed
+		Operations pushed while draining are left for the next call, so busy producers can't keep the consumer here
+		Returns the number of operations run
+	*/
+	std::size_t drain() {
+		std::size_t end = enqueuePosition.load(std::memory_order_acquire);
+		std::size_t count = 0;
+		std::uint64_t totalLatency = 0;
+		std::uint64_t maxLatency = 0;
+		std::int64_t drainTime = now();
+		while(dequeuePosition != end) {
+			Slot& slot = slots[dequeuePosition & mask];
+			// a producer which claimed this slot may not have published it yet
+			if(slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) break;
+
+			std::uint64_t latency = static_cast<std::uint64_t>(std::max<std::int64_t>(drainTime - slot.pushTime, 0));
+			totalLatency += latency;
+			if(latency > maxLatency) maxLatency = latency;
+
+			slot.run(slot.storage);
+			slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+			dequeuePosition++;
+			count++;
+		}
+
+		statistics.drainedOperations.fetch_add(count, std::memory_order_relaxed);
+		statistics.totalLatencyNanos.fetch_add(totalLatency, std::memory_order_relaxed);
+		if(maxLatency > statistics.maxLatencyNanos.load(std::memory_order_relaxed)) {
+			statistics.maxLatencyNanos.store(maxLatency, std::memory_order_relaxed);
+		}
+		return count;
+	}
+
+	inline std::size_t getCapacity() const { return capacity; }
+	inline const OperationQueueStatistics& getStatistics() const { return statistics; }
+};
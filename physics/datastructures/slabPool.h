@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <functional>
+#include <new>
+#include <cstddef>
+#include <assert.h>
+
+#include "alignedPtr.h"
+
+/*
+	Allocates objects of type T from slabs of ObjectsPerSlab objects, objects never move once created
+
+	Objects are handed out from the end of the newest slab, so objects created together sit next to each other in memory,
+	destroyed objects go on a free list and their slots are reused first
+	Slabs are only given back to the heap when the pool is destroyed or by releaseMemory(), so a pool which is emptied and
+	filled again, as a world which is cleared and rebuilt, no longer touches the heap, clear() empties the whole pool at once
+
+	Objects still alive when the pool is destroyed are not destructed, their memory is simply released
+	Not thread safe
+*/
+template<typename T, std::size_t ObjectsPerSlab = 256>
+class SlabPool {
+	union Slot {
+		Slot* nextFree;
+		alignas(T) unsigned char object[sizeof(T)];
+	};
+
+	// sorted by address, for owns()
+	std::vector<Slot*> slabs;
+	Slot* freeList = nullptr;
+	// slots of the newest slab that were never handed out
+	Slot* unusedBegin = nullptr;
+	Slot* unusedEnd = nullptr;
+	std::size_t liveCount = 0;
+
+	// position of the slot over all slabs, in address order
+	std::size_t getSlotIndex(const Slot* slot) const {
+		typename std::vector<Slot*>::const_iterator found = std::upper_bound(slabs.begin(), slabs.end(), slot, std::less<const Slot*>()) - 1;
+		return (found - slabs.begin()) * ObjectsPerSlab + (slot - *found);
+	}
+
+	void addSlab() {
+		Slot* slab = static_cast<Slot*>(createAligned(sizeof(Slot) * ObjectsPerSlab, alignof(Slot)));
+		slabs.insert(std::upper_bound(slabs.begin(), slabs.end(), slab, std::less<Slot*>()), slab);
+		unusedBegin = slab;
+		unusedEnd = slab + ObjectsPerSlab;
+	}
+
+public:
+	SlabPool() = default;
+	~SlabPool() {
+		for(Slot* slab : slabs) {
+			deleteAligned(slab);
+		}
+	}
+
+	SlabPool(const SlabPool&) = delete;
+	SlabPool& operator=(const SlabPool&) = delete;
+
+	// memory for one T, to be constructed by the caller
+	void* allocate() {
+		liveCount++;
+		if(freeList != nullptr) {
+			Slot* slot = freeList;
+			freeList = slot->nextFree;
+			return slot;
+		}
+		if(unusedBegin == unusedEnd) {
+			addSlab();
+		}
+		return unusedBegin++;
+	}
+	// gives memory from allocate() back, the object in it must already be destructed
+	void deallocate(void* ptr) {
+		assert(owns(ptr));
+		Slot* slot = static_cast<Slot*>(ptr);
+		slot->nextFree = freeList;
+		freeList = slot;
+		liveCount--;
+	}
+
+	template<typename... Args>
+	T* create(Args&&... args) {
+		void* memory = allocate();
+		try {
+			return new(memory) T(std::forward<Args>(args)...);
+		} catch(...) {
+			deallocate(memory);
+			throw;
+		}
+	}
+	void destroy(T* object) {
+		object->~T();
+		deallocate(object);
+	}
+
+	// whether the object was allocated from this pool, in time logarithmic in the number of slabs
+	bool owns(const void* object) const {
+		const Slot* slot = static_cast<const Slot*>(object);
+		typename std::vector<Slot*>::const_iterator found = std::upper_bound(slabs.begin(), slabs.end(), slot, std::less<const Slot*>());
+		if(found == slabs.begin()) return false;
+		const Slot* slab = *(found - 1);
+		return !std::less<const Slot*>()(slot, slab) && std::less<const Slot*>()(slot, slab + ObjectsPerSlab);
+	}
+
+	/*
+		Destroys all objects which are still alive, in one pass over the slabs, and makes every slot free again
+		The slabs are kept, slots are handed out again in address order
+	*/
+	void clear() {
+		std::vector<bool> isFree(slabs.size() * ObjectsPerSlab, false);
+		for(Slot* slot = freeList; slot != nullptr; slot = slot->nextFree) {
+			isFree[getSlotIndex(slot)] = true;
+		}
+		for(Slot* slot = unusedBegin; slot != unusedEnd; slot++) {
+			isFree[getSlotIndex(slot)] = true;
+		}
+		for(std::size_t i = 0; i < isFree.size(); i++) {
+			if(!isFree[i]) {
+				reinterpret_cast<T*>(slabs[i / ObjectsPerSlab][i % ObjectsPerSlab].object)->~T();
+			}
+		}
+
+		freeList = nullptr;
+		for(std::size_t i = isFree.size(); i-- > 0;) {
+			Slot* slot = &slabs[i / ObjectsPerSlab][i % ObjectsPerSlab];
+			slot->nextFree = freeList;
+			freeList = slot;
+		}
+		unusedBegin = nullptr;
+		unusedEnd = nullptr;
+		liveCount = 0;
+	}
+
+	// gives all slabs back to the heap, only allowed when no objects are alive
+	void releaseMemory() {
+		assert(liveCount == 0);
+		for(Slot* slab : slabs) {
+			deleteAligned(slab);
+		}
+		slabs.clear();
+		freeList = nullptr;
+		unusedBegin = nullptr;
+		unusedEnd = nullptr;
+	}
+
+	inline std::size_t getLiveCount() const { return liveCount; }
+	inline std::size_t getSlabCount() const { return slabs.size(); }
+};
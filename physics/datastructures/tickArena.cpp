@@ -0,0 +1,69 @@
+#include "tickArena.h"
+
+#include "alignedPtr.h"
+
+#include <assert.h>
+
+static std::size_t roundUp(std::size_t size, std::size_t alignment) {
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+TickArena::TickArena(std::size_t initialCapacity) {
+	if(initialCapacity != 0) {
+		capacity = roundUp(initialCapacity, MAX_ALIGNMENT);
+		block = static_cast<char*>(createAligned(capacity, MAX_ALIGNMENT));
+		heapAllocationCount++;
+	}
+}
+
+TickArena::~TickArena() {
+	for(void* overflowBlock : overflowBlocks) {
+		deleteAligned(overflowBlock);
+	}
+	if(block != nullptr) {
+		deleteAligned(block);
+	}
+}
+
+void* TickArena::allocate(std::size_t size, std::size_t alignment) {
+	assert(alignment != 0 && alignment <= MAX_ALIGNMENT && (alignment & (alignment - 1)) == 0);
+	if(size == 0) size = 1;
+
+	// reserving alignment - 1 extra bytes lets us align without a compare-exchange loop
+	std::size_t reserved = size + alignment - 1;
+	std::size_t offset = used.fetch_add(reserved, std::memory_order_relaxed);
+	if(offset + reserved <= capacity) {
+		return block + roundUp(offset, alignment);
+	}
+	return allocateOverflow(size, alignment);
+}
+
+void* TickArena::allocateOverflow(std::size_t size, std::size_t alignment) {
+	std::size_t blockSize = roundUp(size, MAX_ALIGNMENT);
+	std::lock_guard<std::mutex> lg(overflowLock);
+	void* overflowBlock = createAligned(blockSize, MAX_ALIGNMENT);
+	overflowBlocks.push_back(overflowBlock);
+	overflowSize += blockSize + alignment;
+	heapAllocationCount++;
+	return overflowBlock;
+}
+
+void TickArena::reset() {
+	if(overflowSize != 0) {
+		for(void* overflowBlock : overflowBlocks) {
+			deleteAligned(overflowBlock);
+		}
+		overflowBlocks.clear();
+
+		// grow with some slack, so slowly growing worlds don't reallocate every tick
+		std::size_t newCapacity = roundUp(capacity + overflowSize + overflowSize / 2, MAX_ALIGNMENT);
+		if(block != nullptr) {
+			deleteAligned(block);
+		}
+		block = static_cast<char*>(createAligned(newCapacity, MAX_ALIGNMENT));
+		capacity = newCapacity;
+		overflowSize = 0;
+		heapAllocationCount++;
+	}
+	used.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/*
+	Bump allocator for scratch memory that only lives for a single tick
+
+	allocate() is lock free as long as the current block has room, so it may be called from several islands at once
+	When a tick needs more than the block holds the rest comes from overflow blocks, reset() then grows the block to fit all of it
+	Once the arena has seen its largest tick it no longer touches the heap, getHeapAllocationCount() can be used to check this
+*/
+class TickArena {
+	char* block = nullptr;
+	std::size_t capacity = 0;
+	std::atomic<std::size_t> used{0};
+
+	std::mutex overflowLock;
+	std::vector<void*> overflowBlocks;
+	std::size_t overflowSize = 0;
+
+	std::size_t heapAllocationCount = 0;
+
+	void* allocateOverflow(std::size_t size, std::size_t alignment);
+public:
+	static constexpr std::size_t MAX_ALIGNMENT = 64;
+
+	explicit TickArena(std::size_t initialCapacity = 0);
+	~TickArena();
+
+	TickArena(const TickArena&) = delete;
+	TickArena& operator=(const TickArena&) = delete;
+	TickArena(TickArena&&) = delete;
+	TickArena& operator=(TickArena&&) = delete;
+
+	void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+	// memory is left uninitialized, only for types which don't need a destructor
+	template<typename T>
+	T* allocate(std::size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "TickArena never runs destructors");
+		static_assert(alignof(T) <= MAX_ALIGNMENT, "Type is aligned stricter than the arena supports");
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/*
+		Frees everything allocated since the last reset
+		Must not run concurrently with allocate()
+	*/
+	void reset();
+
+	inline std::size_t getCapacity() const { return capacity; }
+	inline std::size_t getUsed() const { return used.load(std::memory_order_relaxed); }
+	// number of times the arena itself went to the heap since it was created
+	inline std::size_t getHeapAllocationCount() const { return heapAllocationCount; }
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <assert.h>
+
+/*
+	Disjoint set forest over the indices [0, size)
+	Memory is kept between resets, so rebuilding it every tick does not allocate once it has grown
+*/
+class UnionFind {
+	std::vector<std::size_t> parents;
+	std::vector<std::size_t> sizes;
+public:
+	UnionFind() = default;
+	explicit UnionFind(std::size_t size) { reset(size); }
+
+	void reset(std::size_t size) {
+		parents.resize(size);
+		sizes.resize(size);
+		for(std::size_t i = 0; i < size; i++) {
+			parents[i] = i;
+			sizes[i] = 1;
+		}
+	}
+
+	std::size_t find(std::size_t index) {
+		assert(index < parents.size());
+		while(parents[index] != index) {
+			parents[index] = parents[parents[index]];
+			index = parents[index];
+		}
+		return index;
+	}
+
+	// returns the new representative of the merged set
+	std::size_t unite(std::size_t a, std::size_t b) {
+		std::size_t rootA = find(a);
+		std::size_t rootB = find(b);
+		if(rootA == rootB) return rootA;
+		if(sizes[rootA] < sizes[rootB]) {
+			std::swap(rootA, rootB);
+		}
+		parents[rootB] = rootA;
+		sizes[rootA] += sizes[rootB];
+		return rootA;
+	}
+
+	bool isSameSet(std::size_t a, std::size_t b) {
+		return find(a) == find(b);
+	}
+
+	inline std::size_t size() const { return parents.size(); }
+};
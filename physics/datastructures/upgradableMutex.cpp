@@ -0,0 +1,115 @@
+#include "upgradableMutex.h"
+
+#include <chrono>
+#include <assert.h>
+
+// waits on condition until canEnter holds, only the locks which actually had to wait are timed
+template<typename CanEnter>
+static void waitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, const CanEnter& canEnter, std::atomic<std::uint64_t>& waits, std::atomic<std::uint64_t>& totalWaitNanos, std::atomic<std::uint64_t>& maxWaitNanos) {
+	if(canEnter()) return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	condition.wait(lock, canEnter);
+	std::uint64_t waitNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	// the statistics only change under the lock, the atomics are for readers of the statistics
+	waits.fetch_add(1, std::memory_order_relaxed);
+	totalWaitNanos.fetch_add(waitNanos, std::memory_order_relaxed);
+	if(waitNanos > maxWaitNanos.load(std::memory_order_relaxed)) {
+		maxWaitNanos.store(waitNanos, std::memory_order_relaxed);
+	}
+}
+
+bool UpgradableMutex::readersMayEnterNow() const {
+	return !hasWriter && !upgradePending && (waitingWriterCount == 0 || hasUpgradableOwner);
+}
+bool UpgradableMutex::writersMayEnterNow() const {
+	return !hasWriter && !hasUpgradableOwner && readerCount == 0;
+}
+
+void UpgradableMutex::lock() {
+	std::unique_lock<std::mutex> lock(stateLock);
+	waitingWriterCount++;
+	waitUntil(lock, writersMayEnter, [this]() { return writersMayEnterNow(); }, statistics.exclusiveWaits, statistics.totalExclusiveWaitNanos, statistics.maxExclusiveWaitNanos);
+	waitingWriterCount--;
+	hasWriter = true;
+	statistics.exclusiveLocks.fetch_add(1, std::memory_order_relaxed);
+}
+bool UpgradableMutex::try_lock() {
+	std::lock_guard<std::mutex> lock(stateLock);
+	if(!writersMayEnterNow()) return false;
+	hasWriter = true;
+	statistics.exclusiveLocks.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+void UpgradableMutex::unlock() {
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		assert(hasWriter);
+		hasWriter = false;
+	}
+	readersMayEnter.notify_all();
+	writersMayEnter.notify_all();
+}
+
+void UpgradableMutex::lock_shared() {
+	std::unique_lock<std::mutex> lock(stateLock);
+	waitUntil(lock, readersMayEnter, [this]() { return readersMayEnterNow(); }, statistics.sharedWaits, statistics.totalSharedWaitNanos, statistics.maxSharedWaitNanos);
+	readerCount++;
+	statistics.sharedLocks.fetch_add(1, std::memory_order_relaxed);
+}
+bool UpgradableMutex::try_lock_shared() {
+	std::lock_guard<std::mutex> lock(stateLock);
+	if(!readersMayEnterNow()) return false;
+	readerCount++;
+	statistics.sharedLocks.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+void UpgradableMutex::unlock_shared() {
+	bool wasLastReader;
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		assert(readerCount > 0);
+		readerCount--;
+		wasLastReader = readerCount == 0;
+	}
+	if(wasLastReader) {
+		writersMayEnter.notify_all();
+	}
+}
+
+void UpgradableMutex::lock_upgradable() {
+	std::unique_lock<std::mutex> lock(stateLock);
+	waitUntil(lock, readersMayEnter, [this]() { return !hasWriter && !hasUpgradableOwner && waitingWriterCount == 0; }, statistics.upgradableWaits, statistics.totalUpgradableWaitNanos, statistics.maxUpgradableWaitNanos);
+	hasUpgradableOwner = true;
+	statistics.upgradableLocks.fetch_add(1, std::memory_order_relaxed);
+}
+void UpgradableMutex::unlock_upgradable() {
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		assert(hasUpgradableOwner && !upgradePending);
+		hasUpgradableOwner = false;
+	}
+	readersMayEnter.notify_all();
+	writersMayEnter.notify_all();
+}
+
+void UpgradableMutex::upgrade() {
+	std::unique_lock<std::mutex> lock(stateLock);
+	assert(hasUpgradableOwner && !hasWriter);
+	upgradePending = true;
+	waitUntil(lock, writersMayEnter, [this]() { return readerCount == 0; }, statistics.upgradeWaits, statistics.totalUpgradeWaitNanos, statistics.maxUpgradeWaitNanos);
+	upgradePending = false;
+	hasUpgradableOwner = false;
+	hasWriter = true;
+	statistics.upgrades.fetch_add(1, std::memory_order_relaxed);
+}
+void UpgradableMutex::downgrade() {
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		assert(hasWriter);
+		hasWriter = false;
+		hasUpgradableOwner = true;
+	}
+	readersMayEnter.notify_all();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/*
+	Time spent waiting for an UpgradableMutex, per kind of lock
+	Only locks which had to wait are counted in the waits, the locks which got in right away only in the lock counts
+*/
+struct LockStatistics {
+	std::atomic<std::uint64_t> sharedLocks{0};
+	std::atomic<std::uint64_t> exclusiveLocks{0};
+	std::atomic<std::uint64_t> upgradableLocks{0};
+	std::atomic<std::uint64_t> upgrades{0};
+
+	std::atomic<std::uint64_t> sharedWaits{0};
+	std::atomic<std::uint64_t> exclusiveWaits{0};
+	std::atomic<std::uint64_t> upgradableWaits{0};
+	std::atomic<std::uint64_t> upgradeWaits{0};
+
+	std::atomic<std::uint64_t> totalSharedWaitNanos{0};
+	std::atomic<std::uint64_t> totalExclusiveWaitNanos{0};
+	std::atomic<std::uint64_t> totalUpgradableWaitNanos{0};
+	std::atomic<std::uint64_t> totalUpgradeWaitNanos{0};
+
+	std::atomic<std::uint64_t> maxSharedWaitNanos{0};
+	std::atomic<std::uint64_t> maxExclusiveWaitNanos{0};
+	std::atomic<std::uint64_t> maxUpgradableWaitNanos{0};
+	std::atomic<std::uint64_t> maxUpgradeWaitNanos{0};
+};
+
+/*
+	Reader-writer lock with a third kind of lock, the upgradable lock, and which prefers writers
+
+	The upgradable lock is shared with readers but excludes writers and other upgradable locks, so the thread holding it can
+	turn it into an exclusive lock with upgrade() without anyone changing what it read in between
+	downgrade() turns the exclusive lock back into an upgradable one, letting readers in again
+
+	As soon as a writer or an upgrade is waiting, new readers and upgradable locks wait behind it, so a stream of readers
+	can't starve the writers, a writer waits at most for the readers which were already in
+	The exception is a writer held up by an upgradable lock, readers still get in until that lock is released or upgraded,
+	the writer couldn't have used that time anyway
+	Not recursive: a thread holding any lock may not lock again, a reader waiting for its own lock deadlocks behind a waiting writer
+
+	Meets the requirements of SharedMutex, so it works with std::lock_guard, std::unique_lock and std::shared_lock
+*/
+class UpgradableMutex {
+	std::mutex stateLock;
+	std::condition_variable readersMayEnter;
+	std::condition_variable writersMayEnter;
+
+	std::size_t readerCount = 0;
+	// writers blocked in lock()
+	std::size_t waitingWriterCount = 0;
+	bool hasWriter = false;
+	bool hasUpgradableOwner = false;
+	// the upgradable owner is waiting in upgrade() for the readers to leave
+	bool upgradePending = false;
+
+	bool readersMayEnterNow() const;
+	bool writersMayEnterNow() const;
+
+	LockStatistics statistics;
+
+public:
+	UpgradableMutex() = default;
+	UpgradableMutex(const UpgradableMutex&) = delete;
+	UpgradableMutex& operator=(const UpgradableMutex&) = delete;
+
+	void lock();
+	bool try_lock();
+	void unlock();
+
+	void lock_shared();
+	bool try_lock_shared();
+	void unlock_shared();
+
+	void lock_upgradable();
+	void unlock_upgradable();
+
+	// upgradable to exclusive, waits for the readers which are in to leave
+	void upgrade();
+	// exclusive to upgradable
+	void downgrade();
+
+	inline const LockStatistics& getStatistics() const { return statistics; }
+};
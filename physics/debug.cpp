@@ -7,20 +7,45 @@
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <mutex>
 
 #include "../util/log.h"
 #include "misc/toString.h"
 
 namespace Debug {
-	void(*logVecAction)(Position, Vec3, VectorType) = [](Position, Vec3, VectorType) {};
-	void(*logPointAction)(Position, PointType) = [](Position, PointType) {};
-	void(*logCFrameAction)(CFrame, CFrameType) = [](CFrame, CFrameType) {};
-	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = [](const Polyhedron&, const GlobalCFrame&) {};
+	static void noVectorLog(Position, Vec3, VectorType) {}
+	static void noPointLog(Position, PointType) {}
+	static void noCFrameLog(CFrame, CFrameType) {}
+	static void noShapeLog(const Polyhedron&, const GlobalCFrame&) {}
+
+	void(*logVecAction)(Position, Vec3, VectorType) = noVectorLog;
+	void(*logPointAction)(Position, PointType) = noPointLog;
+	void(*logCFrameAction)(CFrame, CFrameType) = noCFrameLog;
+	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = noShapeLog;
+
+	// islands may be stepped on several threads, installed loggers are serialized so they don't have to be thread safe themselves
+	static std::recursive_mutex logMutex;
 	
-	void logVector(Position origin, Vec3 vec, VectorType type) { logVecAction(origin, vec, type); };
-	void logPoint(Position point, PointType type) { logPointAction(point, type); }
-	void logCFrame(CFrame frame, CFrameType type) { logCFrameAction(frame, type); };
-	void logShape(const Polyhedron& shape, const GlobalCFrame& location) { logShapeAction(shape, location); };
+	void logVector(Position origin, Vec3 vec, VectorType type) {
+		if(logVecAction == noVectorLog) return;
+		std::lock_guard<std::recursive_mutex> lg(logMutex);
+		logVecAction(origin, vec, type);
+	};
+	void logPoint(Position point, PointType type) {
+		if(logPointAction == noPointLog) return;
+		std::lock_guard<std::recursive_mutex> lg(logMutex);
+		logPointAction(point, type);
+	}
+	void logCFrame(CFrame frame, CFrameType type) {
+		if(logCFrameAction == noCFrameLog) return;
+		std::lock_guard<std::recursive_mutex> lg(logMutex);
+		logCFrameAction(frame, type);
+	};
+	void logShape(const Polyhedron& shape, const GlobalCFrame& location) {
+		if(logShapeAction == noShapeLog) return;
+		std::lock_guard<std::recursive_mutex> lg(logMutex);
+		logShapeAction(shape, location);
+	};
 
 	void setVectorLogAction(void(*logger)(Position origin, Vec3 vec, VectorType type)) { logVecAction = logger; };
 	void setPointLogAction(void(*logger)(Position point, PointType type)) { logPointAction = logger; }
@@ -1,4 +1,5 @@
 #include "elasticLink.h"
+#include "softLinkBatch.h"
 #include <cstdlib>
 
 
@@ -10,6 +11,10 @@ ElasticLink::ElasticLink(AttachedPart part1, AttachedPart part2, const double re
 
 }
 
+void ElasticLink::gatherInto(SoftLinkBatch& batch, std::size_t index) const {
+	batch.gather(index, *this, this->restLength, this->stiffness, true);
+}
+
 void ElasticLink::update() {
 	auto optionalVec3 = forceAppliedToTheLink();
 
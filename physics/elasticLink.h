@@ -15,6 +15,8 @@ public:
 
 	ElasticLink(AttachedPart part1, AttachedPart part2, const double restLength, const double stiffness);
 	void update() override;
+	bool isBatched() const override { return true; }
+	void gatherInto(SoftLinkBatch& batch, std::size_t index) const override;
 
 private:
 	std::optional<Vec3> forceAppliedToTheLink();
@@ -0,0 +1,44 @@
+#include "externalForceBatch.h"
+
+#include "physical.h"
+#include "datastructures/tickArena.h"
+
+#include <assert.h>
+
+void ExternalForceBatch::allocate(TickArena& arena, MotorizedPhysical* const* physicals, std::size_t count) {
+	this->physicals = physicals;
+	this->count = count;
+	this->paddedCount = (count + LANES - 1) / LANES * LANES;
+
+	double** columns[]{&mass, &centerOfMassX, &centerOfMassY, &centerOfMassZ, &velocityX, &velocityY, &velocityZ, &forceX, &forceY, &forceZ};
+	for(double** column : columns) {
+		*column = static_cast<double*>(arena.allocate(sizeof(double) * paddedCount, ALIGNMENT));
+		for(std::size_t i = count; i < paddedCount; i++) {
+			(*column)[i] = 0.0;
+		}
+	}
+}
+
+void ExternalForceBatch::gather(std::size_t index, const MotorizedPhysical& phys) {
+	assert(index < count);
+	mass[index] = phys.totalMass;
+
+	Vec3 centerOfMass = castPositionToVec3(phys.getCenterOfMass());
+	centerOfMassX[index] = centerOfMass.x;
+	centerOfMassY[index] = centerOfMass.y;
+	centerOfMassZ[index] = centerOfMass.z;
+
+	Vec3 velocity = phys.motionOfCenterOfMass.getVelocity();
+	velocityX[index] = velocity.x;
+	velocityY[index] = velocity.y;
+	velocityZ[index] = velocity.z;
+
+	forceX[index] = 0.0;
+	forceY[index] = 0.0;
+	forceZ[index] = 0.0;
+}
+
+void ExternalForceBatch::scatter(std::size_t index, MotorizedPhysical& phys) const {
+	assert(index < count);
+	phys.totalForce += Vec3(forceX[index], forceY[index], forceZ[index]);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+#include "math/laneOps.h"
+
+class MotorizedPhysical;
+class TickArena;
+
+/*
+	Structure-of-arrays copy of the state of all physicals of a world that ExternalForces work on, for applying them in one pass
+
+	The inputs are gathered from world.physicals, in the same order, forces add their contribution to forceX, forceY and forceZ
+	Every column is padded to a multiple of LANES and aligned to ALIGNMENT, so forces can work on LANES bodies at once, padding bodies have mass 0
+	Centers of mass are stored relative to the origin as doubles, which loses precision far away from it, in exchange for fast loads
+*/
+struct ExternalForceBatch {
+	static constexpr std::size_t LANES = BATCH_LANES;
+	static constexpr std::size_t ALIGNMENT = BATCH_ALIGNMENT;
+
+	std::size_t count = 0;
+	std::size_t paddedCount = 0;
+
+	/*
+		physicals[i] is body i, for forces which act on single parts instead of the center of mass
+		Such a force may only change the physicals of the range it was given
+	*/
+	MotorizedPhysical* const* physicals = nullptr;
+
+	double* mass = nullptr;
+	double* centerOfMassX = nullptr;
+	double* centerOfMassY = nullptr;
+	double* centerOfMassZ = nullptr;
+	double* velocityX = nullptr;
+	double* velocityY = nullptr;
+	double* velocityZ = nullptr;
+
+	double* forceX = nullptr;
+	double* forceY = nullptr;
+	double* forceZ = nullptr;
+
+	// previous contents are lost, the padding bodies are zeroed
+	void allocate(TickArena& arena, MotorizedPhysical* const* physicals, std::size_t count);
+
+	// fills in the inputs of body index and sets its force to 0
+	void gather(std::size_t index, const MotorizedPhysical& phys);
+	// adds the accumulated force of body index to phys.totalForce
+	void scatter(std::size_t index, MotorizedPhysical& phys) const;
+};
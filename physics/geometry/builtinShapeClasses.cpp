@@ -231,7 +231,7 @@ void CylinderClass::setScaleY(double newY, DiagonalMat3& scale) const {
 	scale[1] = newY;
 }
 
-PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly) : poly(poly), ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID) {}
+PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly) : ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID), poly(std::move(poly)) {}
 
 bool PolyhedronShapeClass::containsPoint(Vec3 point) const {
 	return poly.containsPoint(point);
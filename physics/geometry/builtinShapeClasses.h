@@ -70,4 +70,6 @@ public:
 	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const override;
 	virtual Polyhedron asPolyhedron() const override;
+
+	inline const Polyhedron& getPolyhedron() const { return poly; }
 };
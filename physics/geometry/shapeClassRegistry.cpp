@@ -0,0 +1,90 @@
+#include "shapeClassRegistry.h"
+
+#include "polyhedron.h"
+#include "builtinShapeClasses.h"
+
+#include <cstring>
+#include <cstdint>
+
+// FNV-1a over the bit patterns of the values, so that equal polyhedra, which are compared bitwise, always hash equally
+static void hashValue(std::uint64_t& hash, std::uint32_t value) {
+	for(int i = 0; i < 4; i++) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 0x100000001B3;
+	}
+}
+static std::uint32_t bitsOf(float value) {
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	return bits;
+}
+
+std::size_t hashPolyhedron(const Polyhedron& poly) {
+	std::uint64_t hash = 0xCBF29CE484222325;
+	hashValue(hash, static_cast<std::uint32_t>(poly.vertexCount));
+	hashValue(hash, static_cast<std::uint32_t>(poly.triangleCount));
+	for(Vec3f vertex : poly.iterVertices()) {
+		hashValue(hash, bitsOf(vertex.x));
+		hashValue(hash, bitsOf(vertex.y));
+		hashValue(hash, bitsOf(vertex.z));
+	}
+	for(Triangle triangle : poly.iterTriangles()) {
+		hashValue(hash, static_cast<std::uint32_t>(triangle.firstIndex));
+		hashValue(hash, static_cast<std::uint32_t>(triangle.secondIndex));
+		hashValue(hash, static_cast<std::uint32_t>(triangle.thirdIndex));
+	}
+	return static_cast<std::size_t>(hash);
+}
+
+bool polyhedraAreIdentical(const Polyhedron& first, const Polyhedron& second) {
+	if(first.vertexCount != second.vertexCount || first.triangleCount != second.triangleCount) return false;
+	for(int i = 0; i < first.vertexCount; i++) {
+		Vec3f a = first.getVertex(i);
+		Vec3f b = second.getVertex(i);
+		if(bitsOf(a.x) != bitsOf(b.x) || bitsOf(a.y) != bitsOf(b.y) || bitsOf(a.z) != bitsOf(b.z)) return false;
+	}
+	for(int i = 0; i < first.triangleCount; i++) {
+		if(!(first.getTriangle(i) == second.getTriangle(i))) return false;
+	}
+	return true;
+}
+
+static std::size_t getShapeClassSize(const PolyhedronShapeClass& shapeClass) {
+	return sizeof(PolyhedronShapeClass) + shapeClass.getPolyhedron().getBufferSize();
+}
+
+ShapeClassRegistry::~ShapeClassRegistry() {}
+
+PolyhedronShapeClass* ShapeClassRegistry::intern(Polyhedron&& normalizedPoly) {
+	std::size_t hash = hashPolyhedron(normalizedPoly);
+
+	std::lock_guard<std::mutex> lock(registryLock);
+	statistics.requestCount++;
+
+	auto candidates = polyhedra.equal_range(hash);
+	for(auto iter = candidates.first; iter != candidates.second; ++iter) {
+		PolyhedronShapeClass* candidate = iter->second.get();
+		if(polyhedraAreIdentical(candidate->getPolyhedron(), normalizedPoly)) {
+			statistics.reuseCount++;
+			statistics.bytesSaved += getShapeClassSize(*candidate);
+			return candidate;
+		}
+	}
+
+	PolyhedronShapeClass* newShapeClass = new PolyhedronShapeClass(std::move(normalizedPoly));
+	polyhedra.emplace(hash, std::unique_ptr<PolyhedronShapeClass>(newShapeClass));
+	statistics.shapeClassCount++;
+	statistics.bytesStored += getShapeClassSize(*newShapeClass);
+	return newShapeClass;
+}
+
+ShapeClassRegistryStatistics ShapeClassRegistry::getStatistics() const {
+	std::lock_guard<std::mutex> lock(registryLock);
+	return statistics;
+}
+
+ShapeClassRegistry& ShapeClassRegistry::global() {
+	// never destroyed, static Shapes may still refer to its shape classes while the program exits
+	static ShapeClassRegistry* registry = new ShapeClassRegistry();
+	return *registry;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+class Polyhedron;
+class PolyhedronShapeClass;
+
+struct ShapeClassRegistryStatistics {
+	// calls to intern()
+	std::size_t requestCount = 0;
+	// requests answered with a shape class that already existed
+	std::size_t reuseCount = 0;
+	std::size_t shapeClassCount = 0;
+	// memory held by the interned shape classes
+	std::size_t bytesStored = 0;
+	// memory that would have been taken by the copies handed out for the reused requests
+	std::size_t bytesSaved = 0;
+};
+
+/*
+	Interns PolyhedronShapeClasses by their geometry: asking for a polyhedron equal to one interned before returns the same shape class
+	so a scene with thousands of identical hulls keeps one copy of their vertices, which also stays in cache during support mapping
+
+	Polyhedra are hashed on their vertices and triangles, and only considered equal when all vertices and triangles are bitwise identical,
+	in the same order, two meshes describing the same shape differently are interned separately
+	The polyhedron should already be normalized to the -1..1 box of ShapeClass, as polyhedronShape does
+
+	Interned shape classes are never freed, shapes refering to them may live anywhere
+	Thread safe
+*/
+class ShapeClassRegistry {
+	mutable std::mutex registryLock;
+	std::unordered_multimap<std::size_t, std::unique_ptr<PolyhedronShapeClass>> polyhedra;
+	ShapeClassRegistryStatistics statistics;
+
+public:
+	ShapeClassRegistry() = default;
+	~ShapeClassRegistry();
+	ShapeClassRegistry(const ShapeClassRegistry&) = delete;
+	ShapeClassRegistry& operator=(const ShapeClassRegistry&) = delete;
+
+	PolyhedronShapeClass* intern(Polyhedron&& normalizedPoly);
+
+	ShapeClassRegistryStatistics getStatistics() const;
+
+	// the registry used by polyhedronShape and the deserializer
+	static ShapeClassRegistry& global();
+};
+
+std::size_t hashPolyhedron(const Polyhedron& poly);
+bool polyhedraAreIdentical(const Polyhedron& first, const Polyhedron& second);
@@ -5,6 +5,7 @@
 #include "../misc/shapeLibrary.h"
 #include "../math/linalg/trigonometry.h"
 #include "builtinShapeClasses.h"
+#include "shapeClassRegistry.h"
 
 Shape sphereShape(double radius) {
 	return Shape(&SphereClass::instance, radius * 2, radius * 2, radius * 2);
@@ -23,7 +24,7 @@ Shape polyhedronShape(const Polyhedron& poly) {
 	Vec3 center = bounds.getCenter();
 	DiagonalMat3 scale{2 / bounds.getWidth(), 2 / bounds.getHeight(), 2 / bounds.getDepth()};
 
-	PolyhedronShapeClass* shapeClass = new PolyhedronShapeClass(poly.translatedAndScaled(-center, scale));
+	PolyhedronShapeClass* shapeClass = ShapeClassRegistry::global().intern(poly.translatedAndScaled(-center, scale));
 
 	return Shape(shapeClass, bounds.getWidth(), bounds.getHeight(), bounds.getDepth());
 }
@@ -122,6 +122,10 @@ Triangle MeshPrototype::getTriangle(int index) const {
 	size_t offset = getOffset(triangleCount);
 	return Triangle{triangles[index], triangles[index + offset], triangles[index + 2 * offset]};
 }
+
+std::size_t MeshPrototype::getBufferSize() const {
+	return getOffset(vertexCount) * 3 * sizeof(float) + getOffset(triangleCount) * 3 * sizeof(int);
+}
 #pragma endregion
 
 #pragma region EditableMesh
@@ -75,6 +75,9 @@ public:
 
 	Vec3f getVertex(int index) const;
 	Triangle getTriangle(int index) const;
+
+	// bytes taken by the vertex and triangle buffers
+	std::size_t getBufferSize() const;
 };
 
 class EditableMesh : public MeshPrototype {
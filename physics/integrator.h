@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+	How a MotorizedPhysical turns its accumulated forces and moments into new velocities
+*/
+enum class Integrator : char {
+	// use the integrator of the world the physical is in, EXPLICIT outside of a world
+	WORLD_DEFAULT,
+	// velocities only change through forces and moments, a spinning body keeps its global angular velocity
+	EXPLICIT,
+	/*
+		Semi-implicit Euler with an implicit gyroscopic moment -w x Iw
+		The new angular velocity is found with one Newton step in local space, which keeps tumbling bodies stable at large deltaT
+	*/
+	SEMI_IMPLICIT_GYROSCOPIC
+};
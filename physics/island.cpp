@@ -0,0 +1,224 @@
+#include "island.h"
+
+#include "world.h"
+#include "physical.h"
+#include "softLink.h"
+#include "softconstraints/constraintGroup.h"
+#include "datastructures/tickArena.h"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr std::size_t NO_ISLAND = std::numeric_limits<std::size_t>::max();
+
+void IslandSet::clear() {
+	islandCount = 0;
+	scheduleOrder.clear();
+}
+
+static std::size_t getPhysicalIndex(const WorldPrototype& world, const Physical* phys) {
+	if(phys == nullptr) return NO_ISLAND;
+	const MotorizedPhysical* mainPhys = phys->mainPhysical;
+	if(mainPhys->world != &world) return NO_ISLAND;
+	return mainPhys->indexInWorld;
+}
+
+std::size_t IslandSet::getIslandIndexFor(const WorldPrototype& world, const Physical* phys) const {
+	std::size_t physIndex = getPhysicalIndex(world, phys);
+	if(physIndex == NO_ISLAND) return NO_ISLAND;
+	return islandOfPhysical[physIndex];
+}
+
+template<typename T>
+static std::size_t listSize(const ListIter<T>& list) {
+	return list.fin - list.start;
+}
+
+/*
+	Gives every island a list with room for as many items as islandOfItem assigns to it, all in one block from the arena
+	The lists start out empty, fill them with pushItem
+*/
+template<typename T>
+static void layoutLists(TickArena& arena, Island* islands, std::size_t islandCount, ListIter<T> Island::* list, const std::size_t* islandOfItem, std::size_t itemCount) {
+	std::size_t* counts = arena.allocate<std::size_t>(islandCount);
+	for(std::size_t i = 0; i < islandCount; i++) {
+		counts[i] = 0;
+	}
+	for(std::size_t i = 0; i < itemCount; i++) {
+		counts[islandOfItem[i]]++;
+	}
+	T* block = arena.allocate<T>(itemCount);
+	for(std::size_t i = 0; i < islandCount; i++) {
+		(islands[i].*list).start = block;
+		(islands[i].*list).fin = block;
+		block += counts[i];
+	}
+}
+
+template<typename T>
+static void pushItem(ListIter<T>& list, const T& item) {
+	*list.fin = item;
+	++list.fin;
+}
+
+void IslandSet::build(WorldPrototype& world, bool includeColissions) {
+	this->clear();
+
+	TickArena& arena = world.tickArena;
+
+	std::vector<MotorizedPhysical*>& physicals = world.physicals;
+	std::size_t physicalCount = physicals.size();
+
+	for(std::size_t i = 0; i < physicalCount; i++) {
+		physicals[i]->indexInWorld = i;
+	}
+	for(std::size_t i = 0; i < world.springLinks.size(); i++) {
+		world.springLinks[i]->indexInWorld = i;
+	}
+
+	unionFind.reset(physicalCount);
+
+	auto uniteAll = [this, &world](const Physical* a, const Physical* b) {
+		std::size_t indexA = getPhysicalIndex(world, a);
+		std::size_t indexB = getPhysicalIndex(world, b);
+		if(indexA != NO_ISLAND && indexB != NO_ISLAND) {
+			unionFind.unite(indexA, indexB);
+		}
+	};
+
+	const std::vector<Colission>& partColissions = world.curColissions.freePartColissions;
+	const std::vector<Colission>& terrainColissions = world.curColissions.freeTerrainColissions;
+	std::size_t partColissionCount = includeColissions ? partColissions.size() : 0;
+	std::size_t terrainColissionCount = includeColissions ? terrainColissions.size() : 0;
+
+	for(std::size_t i = 0; i < partColissionCount; i++) {
+		uniteAll(partColissions[i].p1->parent, partColissions[i].p2->parent);
+	}
+	for(const ConstraintGroup& group : world.constraints) {
+		const Physical* firstInWorld = nullptr;
+		for(const PhysicalConstraint& c : group.constraints) {
+			uniteAll(c.physA, c.physB);
+			if(firstInWorld == nullptr) {
+				if(getPhysicalIndex(world, c.physA) != NO_ISLAND) firstInWorld = c.physA;
+				else if(getPhysicalIndex(world, c.physB) != NO_ISLAND) firstInWorld = c.physB;
+			} else {
+				uniteAll(firstInWorld, c.physA);
+				uniteAll(firstInWorld, c.physB);
+			}
+		}
+	}
+	for(const SoftLink* link : world.springLinks) {
+		uniteAll(link->getPart1()->parent, link->getPart2()->parent);
+	}
+
+	// islands are numbered in order of their first physical, which keeps the assignment stable between runs
+	islandOfRoot.assign(physicalCount, NO_ISLAND);
+	islandOfPhysical.resize(physicalCount);
+	for(std::size_t i = 0; i < physicalCount; i++) {
+		std::size_t root = unionFind.find(i);
+		std::size_t& islandIndex = islandOfRoot[root];
+		if(islandIndex == NO_ISLAND) {
+			islandIndex = islandCount++;
+		}
+		islandOfPhysical[i] = islandIndex;
+	}
+
+	std::size_t constraintCount = world.constraints.size();
+	std::size_t linkCount = world.springLinks.size();
+
+	std::size_t* islandOfPartColission = arena.allocate<std::size_t>(partColissionCount);
+	std::size_t* islandOfTerrainColission = arena.allocate<std::size_t>(terrainColissionCount);
+	std::size_t* islandOfConstraint = arena.allocate<std::size_t>(constraintCount);
+	std::size_t* islandOfLink = arena.allocate<std::size_t>(linkCount);
+
+	bool needsLooseIsland = false;
+	auto assign = [&needsLooseIsland](std::size_t islandIndex) {
+		if(islandIndex == NO_ISLAND) needsLooseIsland = true;
+		return islandIndex;
+	};
+	for(std::size_t i = 0; i < partColissionCount; i++) {
+		islandOfPartColission[i] = assign(getIslandIndexFor(world, partColissions[i].p1->parent));
+	}
+	for(std::size_t i = 0; i < terrainColissionCount; i++) {
+		islandOfTerrainColission[i] = assign(getIslandIndexFor(world, terrainColissions[i].p1->parent));
+	}
+	for(std::size_t i = 0; i < constraintCount; i++) {
+		std::size_t islandIndex = NO_ISLAND;
+		for(const PhysicalConstraint& c : world.constraints[i].constraints) {
+			islandIndex = getIslandIndexFor(world, c.physA);
+			if(islandIndex != NO_ISLAND) break;
+			islandIndex = getIslandIndexFor(world, c.physB);
+			if(islandIndex != NO_ISLAND) break;
+		}
+		islandOfConstraint[i] = assign(islandIndex);
+	}
+	for(std::size_t i = 0; i < linkCount; i++) {
+		const SoftLink* link = world.springLinks[i];
+		std::size_t islandIndex = getIslandIndexFor(world, link->getPart1()->parent);
+		if(islandIndex == NO_ISLAND) islandIndex = getIslandIndexFor(world, link->getPart2()->parent);
+		islandOfLink[i] = assign(islandIndex);
+	}
+
+	// the loose island holds contacts, constraints and links which don't touch any physical of this world, it has no physicals itself
+	if(needsLooseIsland) {
+		std::size_t looseIsland = islandCount++;
+		auto resolve = [looseIsland](std::size_t* islandOfItem, std::size_t itemCount) {
+			for(std::size_t i = 0; i < itemCount; i++) {
+				if(islandOfItem[i] == NO_ISLAND) islandOfItem[i] = looseIsland;
+			}
+		};
+		resolve(islandOfPartColission, partColissionCount);
+		resolve(islandOfTerrainColission, terrainColissionCount);
+		resolve(islandOfConstraint, constraintCount);
+		resolve(islandOfLink, linkCount);
+	}
+
+	if(islands.size() < islandCount) {
+		islands.resize(islandCount);
+	}
+	layoutLists(arena, islands.data(), islandCount, &Island::physicals, islandOfPhysical.data(), physicalCount);
+	layoutLists(arena, islands.data(), islandCount, &Island::freePartColissions, islandOfPartColission, partColissionCount);
+	layoutLists(arena, islands.data(), islandCount, &Island::freeTerrainColissions, islandOfTerrainColission, terrainColissionCount);
+	layoutLists(arena, islands.data(), islandCount, &Island::constraints, islandOfConstraint, constraintCount);
+	layoutLists(arena, islands.data(), islandCount, &Island::springLinks, islandOfLink, linkCount);
+
+	for(std::size_t i = 0; i < physicalCount; i++) {
+		pushItem(islands[islandOfPhysical[i]].physicals, physicals[i]);
+	}
+	// an island is due once any of its physicals has waited for the divisor of the fastest one, the loose island has no physicals and is always due
+	for(std::size_t i = 0; i < islandCount; i++) {
+		Island& island = islands[i];
+		std::size_t divisor = 1;
+		std::size_t maxSkippedTicks = 0;
+		if(listSize(island.physicals) != 0) {
+			divisor = std::numeric_limits<std::size_t>::max();
+			for(const MotorizedPhysical* phys : island.physicals) {
+				divisor = std::min(divisor, phys->tickDivisor);
+				maxSkippedTicks = std::max(maxSkippedTicks, phys->skippedTicks);
+			}
+		}
+		island.isDue = maxSkippedTicks + 1 >= divisor;
+	}
+	for(std::size_t i = 0; i < partColissionCount; i++) {
+		pushItem(islands[islandOfPartColission[i]].freePartColissions, partColissions[i]);
+	}
+	for(std::size_t i = 0; i < terrainColissionCount; i++) {
+		pushItem(islands[islandOfTerrainColission[i]].freeTerrainColissions, terrainColissions[i]);
+	}
+	for(std::size_t i = 0; i < constraintCount; i++) {
+		pushItem(islands[islandOfConstraint[i]].constraints, static_cast<const ConstraintGroup*>(&world.constraints[i]));
+	}
+	for(std::size_t i = 0; i < linkCount; i++) {
+		pushItem(islands[islandOfLink[i]].springLinks, world.springLinks[i]);
+	}
+
+	scheduleOrder.resize(islandCount);
+	for(std::size_t i = 0; i < islandCount; i++) {
+		scheduleOrder[i] = i;
+	}
+	std::sort(scheduleOrder.begin(), scheduleOrder.end(), [this](std::size_t a, std::size_t b) {
+		std::size_t workA = listSize(islands[a].physicals) + listSize(islands[a].freePartColissions);
+		std::size_t workB = listSize(islands[b].physicals) + listSize(islands[b].freePartColissions);
+		return (workA != workB) ? workA > workB : a < b;
+	});
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "part.h"
+#include "colissionBuffer.h"
+#include "datastructures/buffers.h"
+#include "datastructures/unionFind.h"
+
+struct ConstraintGroup;
+class SoftLink;
+struct SoftLinkBatch;
+class TickArena;
+
+/*
+	A set of physicals which can influence each other this tick, through contacts, ConstraintGroups or SoftLinks
+	Islands never share a MotorizedPhysical, so different islands can be stepped on different threads
+
+	The lists point into the world's TickArena, and are only valid during the tick they were built in
+*/
+struct Island {
+	ListIter<MotorizedPhysical*> physicals;
+	ListIter<Colission> freePartColissions;
+	ListIter<Colission> freeTerrainColissions;
+	ListIter<const ConstraintGroup*> constraints;
+	ListIter<SoftLink*> springLinks;
+
+	/*
+		Islands which are not due are skipped this tick, see MotorizedPhysical::tickDivisor
+		An island runs at the rate of its fastest physical, so slow physicals which touch faster ones are updated at the faster rate
+	*/
+	bool isDue = true;
+
+	// steps the physicals which skipped ticks over them, must come before handleColissions and handleConstraints
+	void catchUpSkippedTicks(double deltaT);
+	void handleColissions();
+	void handleConstraints(TickArena& arena);
+	// the physicals themselves are updated world-wide, see WorldPrototype::update
+	// batched links take their force from batch, in the order of springLinks
+	void updateSpringLinks(const SoftLinkBatch& batch);
+};
+
+/*
+	Splits the world into Islands each tick, using union-find over contacts, ConstraintGroups and SoftLinks
+
+	Items keep their relative order from the world's lists, so stepping the islands one by one gives the same result as the old global lists
+*/
+class IslandSet {
+	std::vector<Island> islands;
+	std::size_t islandCount = 0;
+	std::vector<std::size_t> scheduleOrder;
+
+	UnionFind unionFind;
+	std::vector<std::size_t> islandOfPhysical;
+	std::vector<std::size_t> islandOfRoot;
+
+	std::size_t getIslandIndexFor(const WorldPrototype& world, const Physical* phys) const;
+public:
+	/*
+		All lists are allocated from world.tickArena
+		includeColissions can be turned off when world.curColissions is no longer valid, the islands then only contain physicals, constraints and links
+	*/
+	void build(WorldPrototype& world, bool includeColissions = true);
+	void clear();
+
+	inline std::size_t size() const { return islandCount; }
+	inline bool isPhysicalDue(std::size_t physicalIndex) const { return islands[islandOfPhysical[physicalIndex]].isDue; }
+	inline Island& operator[](std::size_t index) { return islands[index]; }
+	inline const Island& operator[](std::size_t index) const { return islands[index]; }
+
+	// indices of the islands sorted from most to least work, for scheduling the largest islands first
+	inline const std::vector<std::size_t>& getScheduleOrder() const { return scheduleOrder; }
+};
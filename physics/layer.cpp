@@ -47,11 +47,53 @@ void WorldLayer::refresh() {
 	tree.improveStructure();
 }
 
+void WorldLayer::refreshBranch(int branchIndex) {
+	tree.refreshBranch(branchIndex);
+}
+void WorldLayer::refreshRoot() {
+	tree.refreshRoot();
+}
+
+void WorldLayer::notifyStructureChanged() {
+	if(parent->world != nullptr) {
+		parent->world->structureVersion++;
+	}
+}
+void WorldLayer::notifyRegrouped() {
+	notifyStructureChanged();
+	if(WorldRegions* regions = getRegions()) {
+		regions->invalidate();
+	}
+}
+
+WorldRegions* WorldLayer::getRegions() const {
+	if(parent->world == nullptr || this != &parent->subLayers[ColissionLayer::FREE_PARTS_LAYER]) return nullptr;
+	return &parent->world->regions;
+}
+
+// any part of the group, the first leaf of the node
+static Part* getPartOfGroup(const TreeNode& node) {
+	const TreeNode* leaf = &node;
+	while(!leaf->isLeafNode()) {
+		leaf = &leaf->subTrees[0];
+	}
+	return static_cast<Part*>(leaf->object);
+}
+
 void WorldLayer::addNode(TreeNode&& newNode) {
+	Part* partOfGroup = getPartOfGroup(newNode);
 	tree.add(std::move(newNode));
+	notifyStructureChanged();
+	if(WorldRegions* regions = getRegions()) {
+		regions->notifyGroupAdded(partOfGroup, parent->getID());
+	}
 }
 void WorldLayer::addPart(Part* newPart) {
 	tree.add(newPart, newPart->getBounds());
+	notifyStructureChanged();
+	if(WorldRegions* regions = getRegions()) {
+		regions->notifyGroupAdded(newPart, parent->getID());
+	}
 }
 
 static TreeNode createNodeFor(MotorizedPhysical* phys, bool makeGroupHead) {
@@ -63,6 +105,7 @@ static TreeNode createNodeFor(MotorizedPhysical* phys, bool makeGroupHead) {
 }
 
 void WorldLayer::addIntoGroup(Part* newPart, Part* group) {
+	notifyRegrouped();
 	assert(newPart->layer == nullptr);
 	assert(group->layer == this);
 #ifndef NDEBUG
@@ -86,37 +129,52 @@ void WorldLayer::addIntoGroup(Part* newPart, Part* group) {
 
 void WorldLayer::moveOutOfGroup(Part* part) {
 	this->tree.moveOutOfGroup(part, part->getBounds());
+	notifyRegrouped();
 }
 
 void WorldLayer::removePart(Part* partToRemove) {
+	if(WorldRegions* regions = getRegions()) {
+		regions->notifyPartRemoved(partToRemove, parent->getID());
+	}
 	tree.remove(partToRemove, partToRemove->getBounds());
+	notifyStructureChanged();
 	parent->world->onPartRemoved(partToRemove);
 }
 
 void WorldLayer::notifyPartBoundsUpdated(const Part* updatedPart, const Bounds& oldBounds) {
 	tree.updateObjectBounds(updatedPart, oldBounds);
+	if(WorldRegions* regions = getRegions()) {
+		regions->notifyPartBoundsUpdated(updatedPart, oldBounds, parent->getID());
+	}
 }
 void WorldLayer::notifyPartGroupBoundsUpdated(const Part* mainPart, const Bounds& oldMainPartBounds) {
 	tree.updateObjectGroupBounds(mainPart, oldMainPartBounds);
+	if(WorldRegions* regions = getRegions()) {
+		regions->notifyGroupBoundsUpdated(mainPart, oldMainPartBounds, parent->getID());
+	}
 }
 
 void WorldLayer::notifyPartStdMoved(Part* oldPartPtr, Part* newPartPtr) noexcept {
 	bool success = tree.findAndReplaceObject(oldPartPtr, newPartPtr, newPartPtr->getBounds());
 	assert(success);
+	notifyRegrouped();
 }
 
 void WorldLayer::mergeGroupsOf(Part* first, Part* second) {
 	this->tree.mergeGroupsOf(first, first->getBounds(), second, second->getBounds());
+	notifyRegrouped();
 }
 
 // TODO can be optimized, this only needs to move the single partToMove node
 void WorldLayer::moveIntoGroup(Part* partToMove, Part* group) {
 	this->tree.mergeGroupsOf(partToMove, partToMove->getBounds(), group, group->getBounds());
+	notifyRegrouped();
 }
 
 // TODO can be optimized, this only needs to move the single part nodes
 void WorldLayer::joinPartsIntoNewGroup(Part* p1, Part* p2) {
 	this->tree.mergeGroupsOf(p1, p1->getBounds(), p2, p2->getBounds());
+	notifyRegrouped();
 }
 
 int WorldLayer::getID() const {
@@ -261,6 +319,13 @@ void ColissionLayer::getInternalColissions(ColissionBuffer& curColissions) const
 	recursiveFindColissionsInternal(curColissions.freePartColissions, subLayers[0].tree.rootNode);
 	recursiveFindColissionsBetween(curColissions.freeTerrainColissions, subLayers[0].tree.rootNode, subLayers[1].tree.rootNode);
 }
+void findColissionsInternal(const TreeNode& trunkNode, std::vector<Colission>& colissions) {
+	recursiveFindColissionsInternal(colissions, trunkNode);
+}
+void findColissionsBetween(const TreeNode& first, const TreeNode& second, std::vector<Colission>& colissions) {
+	recursiveFindColissionsBetween(colissions, first, second);
+}
+
 void getColissionsBetween(const ColissionLayer& a, const ColissionLayer& b, ColissionBuffer& curColissions) {
 	recursiveFindColissionsBetween(curColissions.freePartColissions, a.subLayers[0].tree.rootNode, b.subLayers[0].tree.rootNode);
 	recursiveFindColissionsBetween(curColissions.freeTerrainColissions, a.subLayers[0].tree.rootNode, b.subLayers[1].tree.rootNode);
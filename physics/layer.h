@@ -7,9 +7,17 @@
 #include "colissionBuffer.h"
 
 class WorldPrototype;
+class WorldRegions;
 class ColissionLayer;
 
 class WorldLayer {
+	// every change to which parts are in this layer or how they are grouped goes through here, see WorldPrototype::structureVersion
+	void notifyStructureChanged();
+	// the WorldRegions can't follow changes to the grouping of free parts, those rebuild the regions at the next tick
+	void notifyRegrouped();
+	// the regions of the world if this is the layer of its free parts, the regions follow its parts being added, removed and moved
+	WorldRegions* getRegions() const;
+
 public:
 	BoundsTree<Part> tree;
 	ColissionLayer* parent;
@@ -24,6 +32,9 @@ public:
 	~WorldLayer();
 
 	void refresh();
+	// refresh split up over the branches of the tree, see BoundsTree::refreshBranch
+	void refreshBranch(int branchIndex);
+	void refreshRoot();
 
 	void addNode(TreeNode&& newNode);
 	void addPart(Part* newPart);
@@ -32,6 +43,7 @@ public:
 	template<typename PartIterBegin, typename PartIterEnd>
 	void addAllToGroup(PartIterBegin begin, PartIterEnd end, Part* group) {
 		tree.addAllToExistingGroup(begin, end, group);
+		notifyRegrouped();
 	}
 	//void addIntoGroup(MotorizedPhysical* newPhys, Part* group);
 
@@ -51,6 +63,7 @@ public:
 	template<typename PartIterBegin, typename PartIterEnd>
 	void moveAllOutOfGroup(PartIterBegin begin, PartIterEnd end) {
 		tree.moveAllOutOfGroup(begin, end);
+		notifyRegrouped();
 	}
 	void optimize() {
 		tree.maxImproveStructure();
@@ -89,3 +102,7 @@ public:
 };
 void getColissionsBetween(const ColissionLayer& a, const ColissionLayer& b, ColissionBuffer& curColissions);
 
+// the colissions between the parts of one tree, and between the parts of two trees, as used by the layers
+void findColissionsInternal(const TreeNode& trunkNode, std::vector<Colission>& colissions);
+void findColissionsBetween(const TreeNode& first, const TreeNode& second, std::vector<Colission>& colissions);
+
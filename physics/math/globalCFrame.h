@@ -130,3 +130,13 @@ inline CFrame operator-(GlobalCFrame cf, Position relativeTo) {
 inline GlobalCFrame operator+(Position relativeTo, CFrame cf) {
 	return GlobalCFrame(relativeTo + cf.getPosition(), cf.getRotation());
 }
+
+/*
+	Interpolates between two cframes, t=0 gives a and t=1 gives b
+	The rotation is interpolated along the shortest arc between the two rotations
+*/
+inline GlobalCFrame interpolate(const GlobalCFrame& a, const GlobalCFrame& b, double t) {
+	Vec3 deltaPosition = b.position - a.position;
+	Vec3 localDeltaRotation = (~a.rotation * b.rotation).asRotationVector();
+	return GlobalCFrame(a.position + deltaPosition * t, a.rotation * Rotation::fromRotationVec(localDeltaRotation * t));
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+
+// AVXLaneOps::madd is a fused multiply-add, MSVC doesn't define __FMA__ but its /arch:AVX2 includes FMA
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define AVX_LANE_OPS
+#include <immintrin.h>
+#endif
+
+/*
+	Elementwise operations on doubles for the structure-of-arrays batches SoftLinkBatch and ExternalForceBatch
+
+	A batch kernel is written once as a template over the value type T and its Ops, and instantiated with
+	ScalarLaneOps for one body at a time, or with AVXLaneOps for BATCH_LANES bodies at a time when AVX_LANE_OPS is defined
+	Batches pad their columns to a multiple of BATCH_LANES and align them to BATCH_ALIGNMENT, so the last block can be loaded whole
+*/
+constexpr std::size_t BATCH_LANES = 4;
+constexpr std::size_t BATCH_ALIGNMENT = 32;
+
+struct ScalarLaneOps {
+	static double load(const double* p) { return *p; }
+	static void store(double* p, double v) { *p = v; }
+	static double add(double a, double b) { return a + b; }
+	static double sub(double a, double b) { return a - b; }
+	static double mul(double a, double b) { return a * b; }
+	static double div(double a, double b) { return a / b; }
+	static double madd(double a, double b, double c) { return a * b + c; }
+	static double neg(double a) { return -a; }
+	static double sqrt(double a) { return std::sqrt(a); }
+	static double abs(double a) { return std::abs(a); }
+};
+
+#ifdef AVX_LANE_OPS
+struct AVXLaneOps {
+	static __m256d load(const double* p) { return _mm256_load_pd(p); }
+	static void store(double* p, __m256d v) { _mm256_store_pd(p, v); }
+	static __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+	static __m256d sub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+	static __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+	static __m256d div(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+	static __m256d madd(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+	static __m256d neg(__m256d a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+	static __m256d sqrt(__m256d a) { return _mm256_sqrt_pd(a); }
+	static __m256d abs(__m256d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+};
+#endif
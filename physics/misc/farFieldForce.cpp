@@ -0,0 +1,158 @@
+#include "farFieldForce.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../datastructures/boundsTree.h"
+#include "../layer.h"
+#include "../part.h"
+#include "../physical.h"
+#include "../externalForceBatch.h"
+
+void FarFieldForce::annotate(const TreeNode& treeNode, std::size_t index) {
+	if(treeNode.isLeafNode()) {
+		const Part* part = static_cast<const Part*>(treeNode.object);
+		double charge = getCharge(*part);
+		Node& node = nodes[index];
+		node.bounds = treeNode.bounds;
+		node.centroid = castPositionToVec3(part->getCenterOfMass());
+		node.charge = charge;
+		node.absCharge = std::abs(charge);
+		node.size = 0.0;
+		node.firstChild = 0;
+		node.childCount = 0;
+		node.part = part;
+		return;
+	}
+
+	// children are laid out next to each other, their own subtrees follow after them
+	std::size_t firstChild = nodes.size();
+	std::size_t childCount = treeNode.nodeCount;
+	nodes.resize(firstChild + childCount);
+	for(std::size_t i = 0; i < childCount; i++) {
+		annotate(treeNode[static_cast<int>(i)], firstChild + i);
+	}
+
+	Node& node = nodes[index];
+	node.bounds = treeNode.bounds;
+	node.firstChild = firstChild;
+	node.childCount = childCount;
+	node.part = nullptr;
+	node.charge = 0.0;
+	node.absCharge = 0.0;
+	Vec3 weightedCentroid(0.0, 0.0, 0.0);
+	for(std::size_t i = firstChild; i < firstChild + childCount; i++) {
+		const Node& child = nodes[i];
+		node.charge += child.charge;
+		node.absCharge += child.absCharge;
+		weightedCentroid += child.centroid * child.absCharge;
+	}
+	node.centroid = (node.absCharge != 0.0) ? weightedCentroid / node.absCharge : castPositionToVec3(node.bounds.getCenter());
+	node.size = length(Vec3(node.bounds.getDiagonal()));
+}
+
+void FarFieldForce::annotateWorld(const WorldPrototype& world) {
+	std::size_t rootCount = 0;
+	for(const ColissionLayer& layer : world.layers) {
+		for(const WorldLayer& subLayer : layer.subLayers) {
+			if(subLayer.tree.rootNode.nodeCount != 0) rootCount++;
+		}
+	}
+
+	nodes.clear();
+	nodes.resize(1 + rootCount);
+	std::size_t rootIndex = 1;
+	for(const ColissionLayer& layer : world.layers) {
+		for(const WorldLayer& subLayer : layer.subLayers) {
+			if(subLayer.tree.rootNode.nodeCount != 0) {
+				annotate(subLayer.tree.rootNode, rootIndex++);
+			}
+		}
+	}
+
+	// the top node is never taken as a whole, it only needs its children
+	Node& top = nodes[0];
+	top.firstChild = 1;
+	top.childCount = rootCount;
+	top.part = nullptr;
+	top.charge = 0.0;
+	top.absCharge = 0.0;
+	top.centroid = Vec3(0.0, 0.0, 0.0);
+	top.size = INFINITY;
+	if(rootCount != 0) {
+		top.bounds = nodes[1].bounds;
+		for(std::size_t i = 2; i < 1 + rootCount; i++) {
+			top.bounds = unionOfBounds(top.bounds, nodes[i].bounds);
+		}
+	}
+}
+
+void FarFieldForce::addForceFromNode(const Node& node, const MotorizedPhysical* targetPhys, Position targetPos, double targetCharge, Vec3& force) const {
+	Vec3 offset = node.centroid - castPositionToVec3(targetPos);
+	double distSq = lengthSquared(offset);
+
+	if(node.part == nullptr) {
+		// nodes around the target are always opened, so a part never gets a share of its own charge
+		bool open = node.bounds.contains(targetPos) || node.size * node.size >= openingAngle * openingAngle * distSq;
+		if(open) {
+			for(std::size_t i = node.firstChild; i < node.firstChild + node.childCount; i++) {
+				addForceFromNode(nodes[i], targetPhys, targetPos, targetCharge, force);
+			}
+			return;
+		}
+	} else if(node.part->parent != nullptr && node.part->parent->mainPhysical == targetPhys) {
+		return;
+	}
+
+	double softDistSq = distSq + softening * softening;
+	force += offset * (coupling * targetCharge * node.charge / (softDistSq * std::sqrt(softDistSq)));
+}
+
+void FarFieldForce::applyToPhysical(MotorizedPhysical* phys) const {
+	phys->forEachPart([this, phys](Part& part) {
+		double charge = getCharge(part);
+		if(charge == 0.0) return;
+		Vec3 force(0.0, 0.0, 0.0);
+		addForceFromNode(nodes[0], phys, part.getCenterOfMass(), charge, force);
+		part.applyForceAtCenterOfMass(force);
+	});
+}
+
+void FarFieldForce::apply(WorldPrototype* world) {
+	annotateWorld(*world);
+	if(nodes[0].childCount == 0) return;
+
+	for(MotorizedPhysical* phys : world->physicals) {
+		applyToPhysical(phys);
+	}
+}
+
+void FarFieldForce::prepareBatch(WorldPrototype* world) {
+	annotateWorld(*world);
+}
+
+void FarFieldForce::applyToBatch(ExternalForceBatch& batch, std::size_t begin, std::size_t end) const {
+	if(nodes[0].childCount == 0) return;
+
+	// every physical only writes to itself, the annotated tree is read only from here
+	std::size_t physicalsEnd = std::min(end, batch.count);
+	for(std::size_t i = begin; i < physicalsEnd; i++) {
+		applyToPhysical(batch.physicals[i]);
+	}
+}
+
+double FarFieldForce::getPotentialEnergyForObject(const WorldPrototype* world, const Part& part) const {
+	double charge = getCharge(part);
+	if(charge == 0.0) return 0.0;
+	const MotorizedPhysical* ownPhys = (part.parent != nullptr) ? part.parent->mainPhysical : nullptr;
+	Vec3 pos = castPositionToVec3(part.getCenterOfMass());
+
+	double total = 0.0;
+	for(const Part& other : world->iterParts()) {
+		if(&other == &part) continue;
+		if(ownPhys != nullptr && other.parent != nullptr && other.parent->mainPhysical == ownPhys) continue;
+		double softDistSq = lengthSquared(castPositionToVec3(other.getCenterOfMass()) - pos) + softening * softening;
+		total -= coupling * charge * getCharge(other) / std::sqrt(softDistSq);
+	}
+	return total * 0.5;
+}
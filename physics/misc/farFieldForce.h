@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../math/linalg/vec.h"
+#include "../math/bounds.h"
+#include "../world.h"
+
+struct TreeNode;
+
+/*
+	Inverse square force between every pair of parts in the world, such as gravity between bodies or electrostatics
+
+	The force on a part a from a part b is coupling * q_a * q_b * (b - a) / (|b - a|^2 + softening^2)^(3/2), where q is given by getCharge
+	A positive coupling attracts parts with charges of the same sign
+
+	Forces are computed with the Barnes-Hut approximation over the BoundsTrees of the world, in O(n log n)
+	Every node of the trees is annotated with its total charge and charge centroid, nodes which are small when seen from
+	the receiving part are taken as a whole instead of being opened. openingAngle sets this trade off, 0 gives the exact sum
+	Parts of the physical receiving the force are skipped, but may still be part of a far away node
+*/
+class FarFieldForce : public ExternalForce {
+	struct Node {
+		Bounds bounds;
+		Vec3 centroid;
+		double charge;
+		// sum of |charge|, which weighs the centroid
+		double absCharge;
+		double size;
+		// children are nodes [firstChild, firstChild + childCount), leaves have part set instead
+		std::size_t firstChild;
+		std::size_t childCount;
+		const Part* part;
+	};
+
+	// rebuilt at every apply and prepareBatch, nodes[0] holds the roots of all trees
+	std::vector<Node> nodes;
+
+	void annotate(const TreeNode& treeNode, std::size_t index);
+	void annotateWorld(const WorldPrototype& world);
+	void addForceFromNode(const Node& node, const MotorizedPhysical* targetPhys, Position targetPos, double targetCharge, Vec3& force) const;
+	// each physical only sums the forces on its own parts
+	void applyToPhysical(MotorizedPhysical* phys) const;
+
+public:
+	double coupling;
+	// a node of size s at distance d is taken as a whole when s / d < openingAngle
+	double openingAngle;
+	// keeps the force finite for parts which are very close together
+	double softening;
+
+	FarFieldForce(double coupling, double openingAngle = 0.5, double softening = 0.01) :
+		coupling(coupling), openingAngle(openingAngle), softening(softening) {}
+
+	virtual double getCharge(const Part& part) const = 0;
+
+	virtual void apply(WorldPrototype* world) override;
+	/*
+		Batched so that the world spreads the physicals over its threadPool
+		The trees are annotated once in prepareBatch, every range of the batch then only reads them
+	*/
+	virtual bool isBatched() const override { return true; }
+	virtual void prepareBatch(WorldPrototype* world) override;
+	virtual void applyToBatch(ExternalForceBatch& batch, std::size_t begin, std::size_t end) const override;
+	/*
+		Exact O(n) sum over all other parts of the world
+		Half of every pair is given to each of the two parts, so the total over all objects counts every pair once
+	*/
+	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const Part& part) const override;
+};
+
+class NBodyGravity : public FarFieldForce {
+public:
+	NBodyGravity(double gravitationalConstant, double openingAngle = 0.5, double softening = 0.01) :
+		FarFieldForce(gravitationalConstant, openingAngle, softening) {}
+
+	virtual double getCharge(const Part& part) const override { return part.getMass(); }
+};
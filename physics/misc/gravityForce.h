@@ -2,6 +2,7 @@
 
 #include "../math/linalg/vec.h"
 #include "../world.h"
+#include "../externalForceBatch.h"
 
 class DirectionalGravity : public ExternalForce {
 public:
@@ -14,6 +15,19 @@ public:
 			p->applyForceAtCenterOfMass(gravity * p->totalMass);
 		}
 	}
+	virtual bool isBatched() const override { return true; }
+	virtual void applyToBatch(ExternalForceBatch& batch, std::size_t begin, std::size_t end) const override {
+		// plain loops over aligned columns, these get vectorized
+		for(std::size_t i = begin; i < end; i++) {
+			batch.forceX[i] += gravity.x * batch.mass[i];
+		}
+		for(std::size_t i = begin; i < end; i++) {
+			batch.forceY[i] += gravity.y * batch.mass[i];
+		}
+		for(std::size_t i = begin; i < end; i++) {
+			batch.forceZ[i] += gravity.z * batch.mass[i];
+		}
+	}
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const Part& part) const override {
 		return Vec3(Position() - part.getCenterOfMass()) * gravity * part.getMass();
 	}
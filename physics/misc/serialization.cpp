@@ -10,6 +10,7 @@
 #include "../geometry/builtinShapeClasses.h"
 #include "../geometry/shape.h"
 #include "../geometry/shapeClass.h"
+#include "../geometry/shapeClassRegistry.h"
 #include "../part.h"
 #include "../world.h"
 #include "../constraints/hardConstraint.h"
@@ -139,8 +140,7 @@ void serializePolyhedronShapeClass(const PolyhedronShapeClass& polyhedron, std::
 }
 PolyhedronShapeClass* deserializePolyhedronShapeClass(std::istream& istream) {
 	Polyhedron poly = ::deserializePolyhedron(istream);
-	PolyhedronShapeClass* result = new PolyhedronShapeClass(std::move(poly));
-	return result;
+	return ShapeClassRegistry::global().intern(std::move(poly));
 }
 
 void serializeDirectionalGravity(const DirectionalGravity& gravity, std::ostream& ostream) {
@@ -180,6 +180,9 @@ Part* DeSerializationSessionPrototype::deserializePartData(const GlobalCFrame& c
 	return result;
 }
 Part* DeSerializationSessionPrototype::deserializePartExternalData(Part&& part, std::istream& istream) {
+	if(targetWorld != nullptr) {
+		return targetWorld->createPart(std::move(part));
+	}
 	return new Part(std::move(part));
 }
 
@@ -281,7 +284,7 @@ void DeSerializationSessionPrototype::deserializeConnectionsOfPhysicalWithContex
 MotorizedPhysical* DeSerializationSessionPrototype::deserializeMotorizedPhysicalWithContext(std::vector<ColissionLayer>& layers, std::istream& istream) {
 	Motion motion = ::deserialize<Motion>(istream);
 	GlobalCFrame cf = ::deserialize<GlobalCFrame>(istream);
-	MotorizedPhysical* mainPhys = new MotorizedPhysical(deserializeRigidBodyWithContext(cf, layers, istream));
+	MotorizedPhysical* mainPhys = MotorizedPhysical::create(targetWorld, deserializeRigidBodyWithContext(cf, layers, istream));
 	indexToPhysicalMap.push_back(static_cast<Physical*>(mainPhys));
 	mainPhys->motionOfCenterOfMass = motion;
 
@@ -408,11 +411,18 @@ void DeSerializationSessionPrototype::deserializeWorldLayer(WorldLayer& layer, s
 	uint32_t extraPartsInLayer = ::deserialize<uint32_t>(istream);
 	for(uint32_t i = 0; i < extraPartsInLayer; i++) {
 		GlobalCFrame cf = ::deserialize<GlobalCFrame>(istream);
-		layer.tree.add(deserializePartData(cf, &layer, istream));
+		layer.addPart(deserializePartData(cf, &layer, istream));
 	}
+	layer.parent->world->objectCount += extraPartsInLayer;
 }
 
 void DeSerializationSessionPrototype::deserializeWorld(WorldPrototype& world, std::istream& istream) {
+	struct TargetWorldReset {
+		WorldPrototype*& targetWorld;
+		~TargetWorldReset() { targetWorld = nullptr; }
+	} targetWorldReset{targetWorld};
+	targetWorld = &world;
+
 	this->deserializeAndCollectHeaderInformation(istream);
 
 	world.age = ::deserialize<uint64_t>(istream);
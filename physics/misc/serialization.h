@@ -111,6 +111,8 @@ private:
 protected:
 	ShapeDeserializer shapeDeserializer;
 	std::vector<Physical*> indexToPhysicalMap;
+	// the world deserializeWorld is filling, its parts are made with WorldPrototype::createPart
+	WorldPrototype* targetWorld = nullptr;
 
 	// creates a part with the given cframe, layer, and extra data it deserializes
 	// calls deserializePartExternalData for extending this deserialization
@@ -83,7 +83,10 @@ int Part::getLayerID() const {
 
 void Part::removeFromWorld() {
 	if(this->parent) this->parent->removePart(this);
-	if(this->layer) this->layer->removePart(this);
+	if(this->layer) {
+		this->layer->removePart(this);
+		this->layer = nullptr;
+	}
 }
 
 PartIntersection Part::intersects(const Part& other) const {
@@ -132,6 +135,14 @@ void Part::setCFrame(const GlobalCFrame& newCFrame) {
 	if(this->layer != nullptr) this->layer->notifyPartGroupBoundsUpdated(this, oldBounds);
 }
 
+GlobalCFrame Part::getInterpolatedCFrame(double alpha) const {
+	if(this->parent == nullptr) return this->cframe;
+	const MotorizedPhysical* mainPhys = this->parent->mainPhysical;
+	const GlobalCFrame& mainCFrame = mainPhys->getCFrame();
+	GlobalCFrame interpolatedMainCFrame = interpolate(mainPhys->previousCFrame, mainCFrame, alpha);
+	return interpolatedMainCFrame.localToGlobal(mainCFrame.globalToLocal(this->cframe));
+}
+
 Vec3 Part::getVelocity() const {
 	return this->getMotion().getVelocity();
 }
@@ -327,7 +338,7 @@ static void mergeLayersAround(Part* first, Part* second, PhysicalMergeFunc merge
 void Part::attach(Part* other, const CFrame& relativeCFrame) {
 	mergeLayersAround(this, other, [&]() {
 		if(this->parent == nullptr) {
-			this->parent = new MotorizedPhysical(this);
+			this->parent = MotorizedPhysical::create(nullptr, this);
 			this->parent->attachPart(other, relativeCFrame);
 		} else {
 			this->parent->attachPart(other, this->transformCFrameToParent(relativeCFrame));
@@ -352,7 +363,7 @@ void Part::detach() {
 
 void Part::ensureHasParent() {
 	if(this->parent == nullptr) {
-		this->parent = new MotorizedPhysical(this);
+		this->parent = MotorizedPhysical::create(nullptr, this);
 	}
 }
 
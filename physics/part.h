@@ -83,6 +83,11 @@ public:
 	Position getCenterOfMass() const { return cframe.localToGlobal(this->getLocalCenterOfMass()); }
 	SymmetricMat3 getInertia() const { return hitbox.getInertia() * properties.density; }
 	const GlobalCFrame& getCFrame() const { return cframe; }
+	/*
+		Returns the cframe of this part between the last two ticks, alpha=0 gives the cframe before the last tick and alpha=1 the current one
+		For rendering at a higher rate than the physics ticks
+	*/
+	GlobalCFrame getInterpolatedCFrame(double alpha) const;
 	void setCFrame(const GlobalCFrame& newCFrame);
 
 	CFrame transformCFrameToParent(const CFrame& cframeRelativeToPart);
@@ -73,18 +73,40 @@ ConnectedPhysical::ConnectedPhysical(Physical&& phys, Physical* parent, HardCons
 	Physical(std::move(phys)), parent(parent), connectionToParent(std::unique_ptr<HardConstraint>(constraintWithParent), attachOnThis, attachOnParent) {}
 
 MotorizedPhysical::MotorizedPhysical(Part* mainPart) : Physical(mainPart, this) {
+	previousCFrame = getCFrame();
 	refreshPhysicalProperties();
 }
 
 MotorizedPhysical::MotorizedPhysical(RigidBody&& rigidBody) : Physical(std::move(rigidBody), this) {
+	previousCFrame = getCFrame();
 	refreshPhysicalProperties();
 }
 
 MotorizedPhysical::MotorizedPhysical(Physical&& movedPhys) : Physical(std::move(movedPhys)) {
 	this->setMainPhysicalRecursive(this);
+	previousCFrame = getCFrame();
 	refreshPhysicalProperties();
 }
 
+void* MotorizedPhysical::allocate(WorldPrototype* world) {
+	if(world == nullptr) {
+		return ::operator new(sizeof(MotorizedPhysical));
+	}
+	return world->physicalPool.allocate();
+}
+void MotorizedPhysical::deallocate(void* memory, WorldPrototype* world) {
+	if(world == nullptr) {
+		::operator delete(memory);
+	} else {
+		world->physicalPool.deallocate(memory);
+	}
+}
+void MotorizedPhysical::destroy(MotorizedPhysical* phys) {
+	WorldPrototype* world = phys->allocatingWorld;
+	phys->~MotorizedPhysical();
+	deallocate(phys, world);
+}
+
 void MotorizedPhysical::ensureWorld(WorldPrototype* world) {
 	if(this->world == world) return;
 	if(this->world != nullptr) {
@@ -249,7 +271,7 @@ void Physical::attachPhysical(Physical* phys, HardConstraint* constraint, const
 void Physical::attachPhysical(MotorizedPhysical* phys, HardConstraint* constraint, const CFrame& attachToThis, const CFrame& attachToThat) {
 	WorldPrototype* world = this->mainPhysical->world;
 	if(world != nullptr) {
-		world->notifyPhysicalsMerged(this->mainPhysical, mainPhysical);
+		world->notifyPhysicalsMerged(this->mainPhysical, phys);
 	}
 
 	ConnectedPhysical childToAdd(std::move(*phys), this, constraint, attachToThat, attachToThis);
@@ -259,7 +281,7 @@ void Physical::attachPhysical(MotorizedPhysical* phys, HardConstraint* constrain
 	p.parent = this;
 	p.setMainPhysicalRecursive(this->mainPhysical);
 
-	delete phys;
+	MotorizedPhysical::destroy(phys);
 
 	childPhysicals.back().refreshCFrameRecursive();
 
@@ -323,7 +345,7 @@ void Physical::attachPhysical(MotorizedPhysical* phys, const CFrame& attachment)
 		world->notifyPhysicalsMerged(this->mainPhysical, phys->mainPhysical);
 	}
 
-	delete phys;
+	MotorizedPhysical::destroy(phys);
 
 	mainPhysical->refreshPhysicalProperties();
 }
@@ -354,7 +376,7 @@ void Physical::attachPart(Part* part, const CFrame& attachment) {
 void Physical::detachAllChildPhysicals() {
 	WorldPrototype* world = this->mainPhysical->world;
 	for(ConnectedPhysical& child : childPhysicals) {
-		MotorizedPhysical* newPhys = new MotorizedPhysical(std::move(static_cast<Physical&>(child)));
+		MotorizedPhysical* newPhys = MotorizedPhysical::create(world, std::move(static_cast<Physical&>(child)));
 		
 		if(world != nullptr) {
 			world->notifyPhysicalHasBeenSplit(this->mainPhysical, newPhys);
@@ -453,7 +475,7 @@ void Physical::detachPart(Part* part) {
 		MotorizedPhysical* mainPhys = this->mainPhysical; // save main physical because it'll get deleted by parent->detachChild()
 		if(this != mainPhys) {
 			ConnectedPhysical& self = static_cast<ConnectedPhysical&>(*this);
-			MotorizedPhysical* newPhys = new MotorizedPhysical(std::move(static_cast<Physical&>(self)));
+			MotorizedPhysical* newPhys = MotorizedPhysical::create(world, std::move(static_cast<Physical&>(self)));
 			if(world != nullptr) {
 				world->notifyPhysicalHasBeenSplit(mainPhys, newPhys);
 			}
@@ -465,7 +487,7 @@ void Physical::detachPart(Part* part) {
 		// It has been removed
 	} else {
 		detachPartAssumingMultipleParts(part);
-		MotorizedPhysical* newPhys = new MotorizedPhysical(part);
+		MotorizedPhysical* newPhys = MotorizedPhysical::create(world, part);
 		part->parent = newPhys;
 		if(world != nullptr) {
 			world->notifyNewPhysicalCreated(newPhys);
@@ -491,7 +513,7 @@ void Physical::removePart(Part* part) {
 			if(mainPhys->world != nullptr) {
 				mainPhys->world->notifyMainPhysicalObsolete(mainPhys);
 			}
-			delete mainPhys;
+			MotorizedPhysical::destroy(mainPhys);
 		}
 
 		// After this, self, and hence also *this* is no longer valid!
@@ -502,9 +524,9 @@ void Physical::removePart(Part* part) {
 	part->parent = nullptr;
 }
 
-// TODO: this seems to need to update the encompassing MotorizedPhysical as well
 void Physical::notifyPartPropertiesChanged(Part* part) {
 	rigidBody.refreshWithNewParts();
+	mainPhysical->refreshPhysicalProperties();
 }
 void Physical::notifyPartStdMoved(Part* oldPartPtr, Part* newPartPtr) noexcept {
 	rigidBody.notifyPartStdMoved(oldPartPtr, newPartPtr);
@@ -544,6 +566,8 @@ void ConnectedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 
 void MotorizedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 	rigidBody.setCFrame(newCFrame);
+	// a teleport, don't interpolate from the old location
+	previousCFrame = newCFrame;
 	for(ConnectedPhysical& conPhys : childPhysicals) {
 		conPhys.refreshCFrameRecursive();
 	}
@@ -582,15 +606,42 @@ void MotorizedPhysical::translate(const Vec3& translation) {
 }
 
 void MotorizedPhysical::refreshPhysicalProperties() {
-	ALLOCA_COMMotionTree(cache, this, size);
+	if(childPhysicals.empty()) {
+		// a single rigid body, no need to build a COMMotionTree
+		this->totalCenterOfMass = rigidBody.localCenterOfMass;
+		this->totalMass = rigidBody.mass;
+
+		this->forceResponse = SymmetricMat3::IDENTITY() * (1 / rigidBody.mass);
+		this->momentResponse = ~rigidBody.inertia;
+		return;
+	}
+
+	articulation.refresh(*this);
+	applyArticulationProperties();
+}
 
-	this->totalCenterOfMass = cache.centerOfMass;
-	this->totalMass = cache.totalMass;
+void MotorizedPhysical::applyArticulationProperties() {
+	this->totalCenterOfMass = articulation.centerOfMass;
+	this->totalMass = articulation.totalMass;
 
-	SymmetricMat3 totalInertia = cache.getInertia();
+	this->forceResponse = SymmetricMat3::IDENTITY() * (1 / articulation.totalMass);
+	this->momentResponse = ~articulation.inertia;
+}
+
+Vec3 MotorizedPhysical::getArticulationAngularMomentum() const {
+	Rotation selfRot = this->getCFrame().getRotation();
+
+	SymmetricMat3 totalInertia = selfRot.localToGlobal(articulation.inertia);
+	Vec3 globalInternalAngularMomentum = selfRot.localToGlobal(articulation.internalAngularMomentum);
+
+	Vec3 externalAngularMomentum = totalInertia * this->motionOfCenterOfMass.getAngularVelocity();
+
+	return externalAngularMomentum + globalInternalAngularMomentum;
+}
 
-	this->forceResponse = SymmetricMat3::IDENTITY() * (1 / cache.totalMass);
-	this->momentResponse = ~totalInertia;
+void MotorizedPhysical::refreshGlobalInertiaCache() {
+	this->cachedGlobalMomentResponse = getCFrame().getRotation().localToGlobal(momentResponse);
+	this->cachedCenterOfMass = getCenterOfMass();
 }
 
 void ConnectedPhysical::refreshCFrame() {
@@ -633,11 +684,30 @@ void MotorizedPhysical::update(double deltaT) {
 	motionOfCenterOfMass.translation.translation[0] += accel;
 	motionOfCenterOfMass.rotation.rotation[0] += rotAcc;
 
+	applyImplicitGyroscopicMoment(deltaT);
+
+	if(holdsPreviousCFrame) {
+		holdsPreviousCFrame = false;
+	} else {
+		previousCFrame = getCFrame();
+	}
+
 	Vec3 oldCenterOfMass = this->totalCenterOfMass;
-	Vec3 angularMomentumBefore = getTotalAngularMomentum();
 
-	updateConstraints(deltaT);
-	refreshPhysicalProperties();
+	// without childPhysicals there are no hard constraints to move, and the mass properties only change through refreshPhysicalProperties
+	bool isArticulated = !childPhysicals.empty();
+	// the implicit gyroscopic moment already gave the angular velocity after this rotation
+	bool conservesAngularMomentum = !usesImplicitGyroscopicMoment();
+	Vec3 angularMomentumBefore;
+	if(isArticulated) {
+		articulation.refresh(*this);
+		angularMomentumBefore = getArticulationAngularMomentum();
+		updateConstraints(deltaT);
+		articulation.refresh(*this);
+		applyArticulationProperties();
+	} else if(conservesAngularMomentum) {
+		angularMomentumBefore = getTotalAngularMomentum();
+	}
 
 	Vec3 deltaCOM = this->totalCenterOfMass - oldCenterOfMass;
 	Vec3 movementOfCenterOfMass = motionOfCenterOfMass.getVelocity() * deltaT + accel * deltaT * deltaT * 0.5 - getCFrame().localToRelative(deltaCOM);
@@ -645,16 +715,62 @@ void MotorizedPhysical::update(double deltaT) {
 	rotateAroundCenterOfMass(Rotation::fromRotationVec(motionOfCenterOfMass.getAngularVelocity() * deltaT));
 	translateUnsafeRecursive(movementOfCenterOfMass);
 
-	Vec3 angularMomentumAfter = getTotalAngularMomentum();
+	if(conservesAngularMomentum) {
+		// the articulation is still that of the new constraint state, moving the whole tree doesn't change it in local space
+		Vec3 angularMomentumAfter = isArticulated ? getArticulationAngularMomentum() : getTotalAngularMomentum();
 
-	SymmetricMat3 globalMomentResponse = getCFrame().getRotation().localToGlobal(momentResponse);
+		SymmetricMat3 globalMomentResponse = getCFrame().getRotation().localToGlobal(momentResponse);
 
-	Vec3 deltaAngularVelocity = globalMomentResponse * (angularMomentumAfter - angularMomentumBefore);
-	this->motionOfCenterOfMass.rotation.rotation[0] -= deltaAngularVelocity;
+		Vec3 deltaAngularVelocity = globalMomentResponse * (angularMomentumAfter - angularMomentumBefore);
+		this->motionOfCenterOfMass.rotation.rotation[0] -= deltaAngularVelocity;
+	}
 
 	updateAttachedPhysicals();
 }
 
+void MotorizedPhysical::catchUpSkippedTicks(double deltaT) {
+	if(skippedTicks == 0) return;
+
+	Vec3 heldForce = totalForce;
+	Vec3 heldMoment = totalMoment;
+	GlobalCFrame heldPreviousCFrame = previousCFrame;
+	update(deltaT * static_cast<double>(skippedTicks));
+	totalForce = heldForce;
+	totalMoment = heldMoment;
+	// the step of the current tick keeps it too, so the interpolation spans the catch-up and that step together
+	previousCFrame = heldPreviousCFrame;
+	holdsPreviousCFrame = true;
+	skippedTicks = 0;
+}
+
+Integrator MotorizedPhysical::getIntegrator() const {
+	if(integrator != Integrator::WORLD_DEFAULT) return integrator;
+	if(world != nullptr && world->integrator != Integrator::WORLD_DEFAULT) return world->integrator;
+	return Integrator::EXPLICIT;
+}
+
+bool MotorizedPhysical::usesImplicitGyroscopicMoment() const {
+	// physicals with childPhysicals keep the angular momentum correction of update, which also covers their internal motion
+	return childPhysicals.empty() && getIntegrator() == Integrator::SEMI_IMPLICIT_GYROSCOPIC;
+}
+
+void MotorizedPhysical::applyImplicitGyroscopicMoment(double deltaT) {
+	if(!usesImplicitGyroscopicMoment()) return;
+
+	Rotation rot = getCFrame().getRotation();
+	Vec3 w = rot.globalToLocal(motionOfCenterOfMass.getAngularVelocity());
+	// only single rigid bodies get here, so this is the inverse of momentResponse
+	const SymmetricMat3& inertia = rigidBody.inertia;
+	Vec3 Iw = inertia * w;
+
+	// f(w2) = I * (w2 - w) + deltaT * w2 x I * w2 == 0, one Newton step starting from w2 = w
+	Vec3 f = (w % Iw) * deltaT;
+	Mat3 jacobian = Mat3(inertia) + (createCrossProductEquivalent(w) * Mat3(inertia) - createCrossProductEquivalent(Iw)) * deltaT;
+	Vec3 newW = w - ~jacobian * f;
+
+	motionOfCenterOfMass.rotation.rotation[0] = rot.localToGlobal(newW);
+}
+
 #pragma endregion
 
 /*
@@ -818,6 +934,17 @@ double MotorizedPhysical::getInertiaOfPointInDirectionRelative(const Vec3Relativ
 	return getInertiaOfPointInDirectionLocal(getCFrame().relativeToLocal(relPoint), getCFrame().relativeToLocal(relDirection));
 }
 
+/*
+	The same as getResponseMatrix(r) * dir, projected on dir, but in world space
+	forceResponse is a multiple of the identity, so it is the same in every frame
+*/
+double MotorizedPhysical::getCachedInertiaOfPointInDirectionRelative(const Vec3Relative& relPoint, const Vec3Relative& relDirection) const {
+	Vec3 momentPerForce = relPoint % relDirection;
+	double accelInForceDir = (relDirection * (forceResponse * relDirection) + momentPerForce * (cachedGlobalMomentResponse * momentPerForce)) / lengthSquared(relDirection);
+
+	return 1 / accelInForceDir;
+}
+
 CFrame ConnectedPhysical::getRelativeCFrameToParent() const {
 	return connectionToParent.getRelativeCFrameToParent();
 }
@@ -837,6 +964,11 @@ Vec3 MotorizedPhysical::getTotalImpulse() const {
 Vec3 MotorizedPhysical::getTotalAngularMomentum() const {
 	Rotation selfRot = this->getCFrame().getRotation();
 
+	if(childPhysicals.empty()) {
+		// a single rigid body has no internal angular momentum, and its inertia is that of the rigidBody
+		return selfRot.localToGlobal(rigidBody.inertia) * this->motionOfCenterOfMass.getAngularVelocity();
+	}
+
 	ALLOCA_COMMotionTree(cache, this, size);
 
 	SymmetricMat3 totalInertia = selfRot.localToGlobal(cache.getInertia());
@@ -857,9 +989,14 @@ Motion Physical::getMotion() const {
 }
 
 Motion MotorizedPhysical::getMotion() const {
+	GlobalCFrame cf = this->getCFrame();
+
+	if(childPhysicals.empty()) {
+		return motionOfCenterOfMass.getMotionOfPoint(cf.localToRelative(-rigidBody.localCenterOfMass));
+	}
+
 	ALLOCA_COMMotionTree(cache, this, size);
 
-	GlobalCFrame cf = this->getCFrame();
 	TranslationalMotion motionOfCom = localToGlobal(cf.getRotation(), cache.motionOfCenterOfMass);
 
 	return -motionOfCom + motionOfCenterOfMass.getMotionOfPoint(cf.localToRelative(-cache.centerOfMass));
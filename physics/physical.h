@@ -15,6 +15,8 @@
 #include "rigidBody.h"
 #include "constraints/hardConstraint.h"
 #include "constraints/hardPhysicalConnection.h"
+#include "articulatedBody.h"
+#include "integrator.h"
 
 typedef Vec3 Vec3Local;
 typedef Vec3 Vec3Relative;
@@ -215,8 +217,22 @@ public:
 class MotorizedPhysical : public Physical {
 	friend class Physical;
 	friend class ConnectedPhysical;
+	friend class WorldPrototype;
+
+	// copies the mass properties from the last refresh of articulation
+	void applyArticulationProperties();
+	// same as getTotalAngularMomentum, from the last refresh of articulation
+	Vec3 getArticulationAngularMomentum() const;
+
+	// the world whose physical pool this physical is allocated from, nullptr for the heap
+	WorldPrototype* allocatingWorld = nullptr;
+	// memory for one MotorizedPhysical from the physical pool of world, or from the heap if world is nullptr
+	static void* allocate(WorldPrototype* world);
+	// gives memory from allocate(world) back, the physical in it must already be destructed
+	static void deallocate(void* memory, WorldPrototype* world);
 public:
 	void refreshPhysicalProperties();
+	void refreshGlobalInertiaCache();
 	Vec3 totalForce = Vec3(0.0, 0.0, 0.0);
 	Vec3 totalMoment = Vec3(0.0, 0.0, 0.0);
 
@@ -224,16 +240,72 @@ public:
 	Vec3 totalCenterOfMass;
 
 	WorldPrototype* world = nullptr;
+	// index into world->physicals, only refreshed when the world builds its islands
+	std::size_t indexInWorld = 0;
+	// WORLD_DEFAULT follows world->integrator
+	Integrator integrator = Integrator::WORLD_DEFAULT;
+
+	/*
+		This physical is only updated every tickDivisor ticks, it first catches up on the ticks it skipped and then takes the step of the current tick
+		Physicals in the same island are updated together, at the rate of the fastest of them
+		Forces applied in skipped ticks are dropped, the catch up holds the external and link forces of the current tick over the skipped ticks
+	*/
+	std::size_t tickDivisor = 1;
+	// ticks since this physical was last updated, not counting the current one
+	std::size_t skippedTicks = 0;
+	// set by catchUpSkippedTicks, the next update leaves previousCFrame at the frame from before the catch-up
+	bool holdsPreviousCFrame = false;
+	/*
+		Steps this physical over its skippedTicks with the forces it has now, and keeps those forces for the step of the current tick
+		Called before contacts and constraints add their forces, so those act once, on both physicals of a contact alike
+	*/
+	void catchUpSkippedTicks(double deltaT);
 	
 	SymmetricMat3 forceResponse;
 	SymmetricMat3 momentResponse;
 
 	Motion motionOfCenterOfMass;
+
+	// cframe of the mainPart before the last update, for interpolating between ticks, see Part::getInterpolatedCFrame
+	GlobalCFrame previousCFrame;
+
+	/*
+		World-space copies of momentResponse and the center of mass, for contact handling
+		These are only valid until this physical moves or changes, the world refreshes them once per tick before handling colissions
+	*/
+	SymmetricMat3 cachedGlobalMomentResponse;
+	Position cachedCenterOfMass;
+
+	// reused by refreshPhysicalProperties and update for physicals with childPhysicals, only valid right after a refresh
+	ArticulatedBodyWorkspace articulation;
 	
 	explicit MotorizedPhysical(Part* mainPart);
 	explicit MotorizedPhysical(RigidBody&& rigidBody);
 	explicit MotorizedPhysical(Physical&& movedPhys);
 
+	/*
+		MotorizedPhysicals are made with create(world, ...), which allocates them from the physical pool of world, or from the heap if world is nullptr
+		The physical remembers its pool and can only be added to that world, the world destroys its pooled physicals when it is cleared
+		Physicals made for parts which aren't in a world yet, such as by attaching them to each other, come from the heap and can go into any world
+		ConnectedPhysicals have no allocation of their own, they're stored by value in the childPhysicals of their parent
+
+		Physicals are freed with destroy, never with delete
+	*/
+	template<typename... Args>
+	static MotorizedPhysical* create(WorldPrototype* world, Args&&... args) {
+		void* memory = allocate(world);
+		MotorizedPhysical* phys;
+		try {
+			phys = new(memory) MotorizedPhysical(std::forward<Args>(args)...);
+		} catch(...) {
+			deallocate(memory, world);
+			throw;
+		}
+		phys->allocatingWorld = world;
+		return phys;
+	}
+	static void destroy(MotorizedPhysical* phys);
+
 	/*
 		Returns the motion of this physical positioned at it's getCFrame()
 
@@ -285,6 +357,15 @@ public:
 	void ensureWorld(WorldPrototype* world);
 
 	void update(double deltaT);
+	// the integrator this physical uses, with WORLD_DEFAULT resolved
+	Integrator getIntegrator() const;
+	/*
+		Single rigid bodies using SEMI_IMPLICIT_GYROSCOPIC apply the gyroscopic moment of this tick to motionOfCenterOfMass here,
+		instead of having update correct their angular velocity to keep the angular momentum
+		Called after the accumulated moment has been added to the angular velocity, does nothing for other physicals
+	*/
+	void applyImplicitGyroscopicMoment(double deltaT);
+	bool usesImplicitGyroscopicMoment() const;
 
 	void setCFrame(const GlobalCFrame& newCFrame);
 	
@@ -306,6 +387,11 @@ public:
 	Mat3 getResponseMatrix(const Vec3Local& actionPoint, const Vec3Local& responsePoint) const;
 	double getInertiaOfPointInDirectionLocal(const Vec3Local& localPoint, const Vec3Local& localDirection) const;
 	double getInertiaOfPointInDirectionRelative(const Vec3Relative& relativePoint, const Vec3Relative& relativeDirection) const;
+	/*
+		Same as getInertiaOfPointInDirectionRelative, but works on the world-space cache of refreshGlobalInertiaCache instead of rotating into local space
+		relativePoint is relative to cachedCenterOfMass
+	*/
+	double getCachedInertiaOfPointInDirectionRelative(const Vec3Relative& relativePoint, const Vec3Relative& relativeDirection) const;
 	inline Part* getMainPart() { return this->rigidBody.mainPart; }
 	inline const Part* getMainPart() const { return this->rigidBody.mainPart; }
 
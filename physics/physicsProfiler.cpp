@@ -8,14 +8,35 @@ const char * physicsLabels[]{
 	"Externals",
 	"Col. Handling",
 	"Constraints",
+	"Island Building",
+	"Island Stepping",
 	"Tree Bounds",
 	"Tree Structure",
 	"Wait for lock",
 	"Updates",
 	"Queue",
+	"Snapshot",
+	"Reorder",
 	"Other"
 };
 
+const char * tickTaskLabels[]{
+	"Broadphase",
+	"Externals",
+	"Batched externals",
+	"Region migration",
+	"Region trees",
+	"Region colissions",
+	"Merge colissions",
+	"Islands",
+	"Contacts",
+	"Update physicals",
+	"Soft link forces",
+	"Apply soft links",
+	"Refresh trees",
+	"Finish"
+};
+
 const char * intersectionLabels[]{
 	"Colission",
 	"GJK Reject",
@@ -44,6 +65,8 @@ const char* iterationLabels[]{
 };
 
 BreakdownAverageProfiler<PhysicsProcess> physicsMeasure(physicsLabels, 100);
+BreakdownAverageProfiler<TickTask> tickTaskMeasure(tickTaskLabels, 100);
+HistoricTally<long long, TickTask> tickTaskItemCounts(tickTaskLabels, 100);
 HistoricTally<long long, IntersectionResult> intersectionStatistics(intersectionLabels, 1);
 CircularBuffer<int> gjkCollideIterStats(1);
 CircularBuffer<int> gjkNoCollideIterStats(1);
@@ -10,15 +10,38 @@ enum class PhysicsProcess {
 	EXTERNALS,
 	COLISSION_HANDLING,
 	CONSTRAINTS,
+	ISLAND_BUILDING,
+	ISLAND_STEPPING,
 	UPDATE_TREE_BOUNDS,
 	UPDATE_TREE_STRUCTURE,
 	WAIT_FOR_LOCK,
 	UPDATING,
 	QUEUE,
+	SNAPSHOT,
+	SPATIAL_REORDER,
 	OTHER,
 	COUNT
 };
 
+// the tasks of the tick graph, in the order WorldPrototype::buildTickGraph adds them
+enum class TickTask {
+	BROADPHASE,
+	EXTERNALS,
+	BATCHED_EXTERNALS,
+	REGION_MIGRATION,
+	REGION_TREES,
+	REGION_COLISSIONS,
+	MERGE_COLISSIONS,
+	ISLANDS,
+	CONTACTS,
+	UPDATE_PHYSICALS,
+	SOFT_LINK_FORCES,
+	APPLY_SOFT_LINKS,
+	REFRESH_TREES,
+	FINISH,
+	COUNT
+};
+
 enum class IntersectionResult {
 	COLISSION,
 	GJK_REJECT,
@@ -36,6 +59,13 @@ enum class IterationTime {
 };
 
 extern BreakdownAverageProfiler<PhysicsProcess> physicsMeasure;
+/*
+	Time from the start to the end of every task of the tick graph, recorded on the calling thread after every tick with a threadPool
+	The tasks overlap, so these don't add up to the length of the tick, physicsMeasure only sees the tasks on the calling thread
+*/
+extern BreakdownAverageProfiler<TickTask> tickTaskMeasure;
+// the number of items each task of the tick graph was split into, regions, islands or chunks, 1 for the serial tasks
+extern HistoricTally<long long, TickTask> tickTaskItemCounts;
 extern HistoricTally<long long, IntersectionResult> intersectionStatistics;
 extern CircularBuffer<int> gjkCollideIterStats;
 extern CircularBuffer<int> gjkNoCollideIterStats;
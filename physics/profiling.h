@@ -26,6 +26,22 @@ public:
 	}
 };
 
+/*
+	Profilers and tallies are shared by every thread without synchronization, so only one thread may record into them at a time
+	Threads which tick worlds alongside other threads, like those of a WorldBatch, don't record anything while they hold a ProfilingSuspension
+*/
+inline thread_local bool profilingSuspended = false;
+
+class ProfilingSuspension {
+	bool wasSuspended;
+public:
+	inline ProfilingSuspension() : wasSuspended(profilingSuspended) { profilingSuspended = true; }
+	inline ~ProfilingSuspension() { profilingSuspended = wasSuspended; }
+
+	ProfilingSuspension(const ProfilingSuspension&) = delete;
+	ProfilingSuspension& operator=(const ProfilingSuspension&) = delete;
+};
+
 template<typename Unit, typename Category>
 class HistoricTally {
 	ParallelArray<Unit, static_cast<size_t>(Category::COUNT)> currentTally;
@@ -41,6 +57,7 @@ public:
 	}
 
 	inline void addToTally(Category category, Unit amount) {
+		if(profilingSuspended) return;
 		currentTally[static_cast<size_t>(category)] += amount;
 	}
 
@@ -51,6 +68,7 @@ public:
 	}
 
 	inline void nextTally() {
+		if(profilingSuspended) return;
 		history.add(currentTally);
 		clearCurrentTally();
 	}
@@ -72,6 +90,7 @@ public:
 	inline BreakdownAverageProfiler(char const * const labels[static_cast<size_t>(ProcessType::COUNT)], size_t capacity) : HistoricTally<std::chrono::nanoseconds, ProcessType>(labels, capacity), tickHistory(capacity) {}
 
 	inline void mark(ProcessType process) {
+		if(profilingSuspended) return;
 		std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
 		if(currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(currentProcess, curTime - startTime);
@@ -81,6 +100,7 @@ public:
 	}
 
 	inline void mark(ProcessType process, ProcessType overrideOldProcess) {
+		if(profilingSuspended) return;
 		std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
 		if (currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(overrideOldProcess, curTime - startTime);
@@ -90,6 +110,7 @@ public:
 	}
 
 	inline void end() {
+		if(profilingSuspended) return;
 		std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
 		this->addToTally(currentProcess, curTime - startTime);
 		tickHistory.add(curTime);
@@ -1,21 +1,25 @@
 #pragma once
 
-#include <shared_mutex>
+#include "datastructures/upgradableMutex.h"
 
+/*
+	Holds an upgradable lock on the mutex: readers may still enter, writers may not
+	upgrade() turns it into an exclusive lock, without a writer being able to slip in between
+*/
 class SharedLockGuard {
-	std::shared_mutex& mutex;
+	UpgradableMutex& mutex;
 	bool isHard = false;
 
 public:
-	inline SharedLockGuard(std::shared_mutex& mutex) : mutex(mutex) {
-		mutex.lock_shared();
+	inline SharedLockGuard(UpgradableMutex& mutex) : mutex(mutex) {
+		mutex.lock_upgradable();
 	}
 
 	inline ~SharedLockGuard() {
 		if(isHard) {
 			mutex.unlock();
 		} else {
-			mutex.unlock_shared();
+			mutex.unlock_upgradable();
 		}
 	}
 
@@ -23,8 +27,7 @@ public:
 		if(isHard) {
 			throw "Attemt to upgrade already hard lock!";
 		}
-		mutex.unlock_shared();
-		mutex.lock();
+		mutex.upgrade();
 		isHard = true;
 	}
 
@@ -32,26 +35,25 @@ public:
 		if(!isHard) {
 			throw "Attempt to downgrade already soft lock!";
 		}
-		mutex.unlock();
-		mutex.lock_shared();
+		mutex.downgrade();
 		isHard = false;
 	}
 };
 
 class UnlockOnDestroy {
-	std::shared_mutex& mutex;
+	UpgradableMutex& mutex;
 public:
 	/* assumes it is given a locked mutex
 	Unlocks when destroyed*/
-	inline UnlockOnDestroy(std::shared_mutex& mutex) : mutex(mutex) {}
+	inline UnlockOnDestroy(UpgradableMutex& mutex) : mutex(mutex) {}
 	~UnlockOnDestroy() { mutex.unlock(); }
 };
 
 class UnlockSharedOnDestroy {
-	std::shared_mutex& mutex;
+	UpgradableMutex& mutex;
 public:
 	/* assumes it is given a shared_locked mutex
 	Unlocks when destroyed*/
-	inline UnlockSharedOnDestroy(std::shared_mutex& mutex) : mutex(mutex) {}
+	inline UnlockSharedOnDestroy(UpgradableMutex& mutex) : mutex(mutex) {}
 	~UnlockSharedOnDestroy() { mutex.unlock_shared(); }
-};
\ No newline at end of file
+};
@@ -3,6 +3,7 @@
 #include "math/linalg/vec.h"
 #include "part.h"
 
+struct SoftLinkBatch;
 
 class SoftLink {
 protected:
@@ -22,8 +23,18 @@ public:
 	SoftLink& operator=(SoftLink&& other) = delete;
 
 
+	// index into world->springLinks, only refreshed when the world builds its islands
+	std::size_t indexInWorld = 0;
+
 	virtual ~SoftLink();
 	virtual void update() = 0;
+	/*
+		Links which return true here don't get update() calls from the world
+		Their force is computed together with all other batched links in a SoftLinkBatch, and applied by the batch
+	*/
+	virtual bool isBatched() const { return false; }
+	// fills in row index of batch, only called for batched links
+	virtual void gatherInto(SoftLinkBatch&, std::size_t) const {}
 
 	SoftLink(const AttachedPart& part1, const AttachedPart& part2);
 
@@ -45,4 +56,7 @@ public:
 	Vec3 getRelativePositionOfAttach1() const;
 	Vec3 getRelativePositionOfAttach2() const;
 
+	inline Part* getPart1() const { return attachedPart1.part; }
+	inline Part* getPart2() const { return attachedPart2.part; }
+
 };
\ No newline at end of file
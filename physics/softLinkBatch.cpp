@@ -0,0 +1,117 @@
+#include "softLinkBatch.h"
+
+#include "softLink.h"
+#include "datastructures/tickArena.h"
+
+#include "math/laneOps.h"
+
+#include <assert.h>
+
+void SoftLinkBatch::allocate(TickArena& arena, std::size_t count) {
+	this->count = count;
+	this->paddedCount = (count + LANES - 1) / LANES * LANES;
+
+	double** columns[]{&restLength, &stiffness, &onlyPulls, &offsetX, &offsetY, &offsetZ,
+		&originOn1X, &originOn1Y, &originOn1Z, &originOn2X, &originOn2Y, &originOn2Z, &forceX, &forceY, &forceZ};
+	for(double** column : columns) {
+		*column = static_cast<double*>(arena.allocate(sizeof(double) * paddedCount, ALIGNMENT));
+	}
+	for(std::size_t i = count; i < paddedCount; i++) {
+		disable(i);
+	}
+}
+
+void SoftLinkBatch::gather(std::size_t index, const SoftLink& link, double restLength, double stiffness, bool onlyPulls) {
+	assert(index < count);
+	this->restLength[index] = restLength;
+	this->stiffness[index] = stiffness;
+	this->onlyPulls[index] = onlyPulls ? 1.0 : 0.0;
+
+	Vec3 offset = link.getGlobalPositionOfAttach2() - link.getGlobalPositionOfAttach1();
+	offsetX[index] = offset.x;
+	offsetY[index] = offset.y;
+	offsetZ[index] = offset.z;
+
+	// the same origins as SpringLink::update and ElasticLink::update
+	Vec3 originOn1 = link.getRelativePositionOfAttach2();
+	Vec3 originOn2 = link.getRelativePositionOfAttach1();
+	originOn1X[index] = originOn1.x;
+	originOn1Y[index] = originOn1.y;
+	originOn1Z[index] = originOn1.z;
+	originOn2X[index] = originOn2.x;
+	originOn2Y[index] = originOn2.y;
+	originOn2Z[index] = originOn2.z;
+}
+
+void SoftLinkBatch::disable(std::size_t index) {
+	// a unit offset keeps the length away from 0, without stiffness there is no force
+	restLength[index] = 0.0;
+	stiffness[index] = 0.0;
+	onlyPulls[index] = 0.0;
+	offsetX[index] = 1.0;
+	offsetY[index] = 0.0;
+	offsetZ[index] = 0.0;
+	originOn1X[index] = 0.0;
+	originOn1Y[index] = 0.0;
+	originOn1Z[index] = 0.0;
+	originOn2X[index] = 0.0;
+	originOn2Y[index] = 0.0;
+	originOn2Z[index] = 0.0;
+}
+
+void SoftLinkBatch::scatter(std::size_t index, SoftLink& link) const {
+	assert(index < count);
+	Vec3 force(forceX[index], forceY[index], forceZ[index]);
+	link.getPart2()->applyForce(Vec3(originOn2X[index], originOn2Y[index], originOn2Z[index]), force);
+	link.getPart1()->applyForce(Vec3(originOn1X[index], originOn1Y[index], originOn1Z[index]), -force);
+}
+
+/*
+	The force of SpringLink::update, for ScalarLinkOps or AVXLinkOps
+
+	scale = stiffness * |length - restLength| / length, or 0 for slack links which only pull
+	force = -offset * scale
+*/
+template<typename T, typename Ops>
+static void computeLanes(SoftLinkBatch& b, std::size_t i) {
+	T dx = Ops::load(b.offsetX + i), dy = Ops::load(b.offsetY + i), dz = Ops::load(b.offsetZ + i);
+	T len = Ops::sqrt(Ops::madd(dz, dz, Ops::madd(dy, dy, Ops::mul(dx, dx))));
+	T stretch = Ops::sub(len, Ops::load(b.restLength + i));
+	T scale = Ops::div(Ops::mul(Ops::load(b.stiffness + i), Ops::abs(stretch)), len);
+	scale = Ops::zeroIfSlack(scale, Ops::load(b.onlyPulls + i), stretch);
+	T negScale = Ops::neg(scale);
+	Ops::store(b.forceX + i, Ops::mul(dx, negScale));
+	Ops::store(b.forceY + i, Ops::mul(dy, negScale));
+	Ops::store(b.forceZ + i, Ops::mul(dz, negScale));
+}
+
+struct ScalarLinkOps : public ScalarLaneOps {
+	static double zeroIfSlack(double scale, double onlyPulls, double stretch) {
+		return (onlyPulls != 0.0 && stretch <= 0.0) ? 0.0 : scale;
+	}
+};
+
+#ifdef AVX_LANE_OPS
+struct AVXLinkOps : public AVXLaneOps {
+	static __m256d zeroIfSlack(__m256d scale, __m256d onlyPulls, __m256d stretch) {
+		__m256d zero = _mm256_setzero_pd();
+		__m256d slack = _mm256_and_pd(_mm256_cmp_pd(onlyPulls, zero, _CMP_NEQ_OQ), _mm256_cmp_pd(stretch, zero, _CMP_LE_OQ));
+		return _mm256_andnot_pd(slack, scale);
+	}
+};
+#endif
+
+void SoftLinkBatch::computeForces(std::size_t begin, std::size_t end) {
+	assert(begin % LANES == 0);
+	assert(end == count || end % LANES == 0);
+#ifdef AVX_LANE_OPS
+	// padding rows are disabled, so the last partial block can be done with a full register
+	for(std::size_t i = begin; i < end; i += LANES) {
+		computeLanes<__m256d, AVXLinkOps>(*this, i);
+	}
+#else
+	for(std::size_t i = begin; i < end; i++) {
+		computeLanes<double, ScalarLinkOps>(*this, i);
+	}
+#endif
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+#include "math/laneOps.h"
+
+class SoftLink;
+class TickArena;
+
+/*
+	Structure-of-arrays copy of all SpringLinks and ElasticLinks of a world, their forces are computed for 4 links at once
+
+	Row i belongs to world.springLinks[i], rows of links which aren't batched are disabled and produce no force
+	The forces are applied to the parts afterwards by the islands, in the order of their links, which keeps the result deterministic
+	Every column is padded to a multiple of LANES and aligned to ALIGNMENT, the arrays live in the world's TickArena
+*/
+struct SoftLinkBatch {
+	static constexpr std::size_t LANES = BATCH_LANES;
+	static constexpr std::size_t ALIGNMENT = BATCH_ALIGNMENT;
+
+	std::size_t count = 0;
+	std::size_t paddedCount = 0;
+
+	double* restLength = nullptr;
+	double* stiffness = nullptr;
+	// 1.0 for links which only pull, like ElasticLink, these are slack while shorter than their rest length
+	double* onlyPulls = nullptr;
+	// global position of attach 2 minus that of attach 1
+	double* offsetX = nullptr;
+	double* offsetY = nullptr;
+	double* offsetZ = nullptr;
+	// relative origins at which the forces are applied to part 1 and part 2
+	double* originOn1X = nullptr;
+	double* originOn1Y = nullptr;
+	double* originOn1Z = nullptr;
+	double* originOn2X = nullptr;
+	double* originOn2Y = nullptr;
+	double* originOn2Z = nullptr;
+
+	// force on part 2, part 1 gets the opposite
+	double* forceX = nullptr;
+	double* forceY = nullptr;
+	double* forceZ = nullptr;
+
+	// previous contents are lost, the padding rows are disabled
+	void allocate(TickArena& arena, std::size_t count);
+
+	void gather(std::size_t index, const SoftLink& link, double restLength, double stiffness, bool onlyPulls);
+	void disable(std::size_t index);
+
+	/*
+		Computes the forces of rows [begin, end), using AVX2 when available
+		begin must be a multiple of LANES
+	*/
+	void computeForces(std::size_t begin, std::size_t end);
+
+	// applies the force of row index to the parts of link
+	void scatter(std::size_t index, SoftLink& link) const;
+};
@@ -4,15 +4,16 @@
 #include "../math/linalg/largeMatrixAlgorithms.h"
 #include "../math/linalg/mat.h"
 #include "../physical.h"
+#include "../datastructures/tickArena.h"
 
 #include "../math/mathUtil.h"
 
 #include "../misc/toString.h"
 #include "../../util/log.h"
 
-#include <fstream>
-
-#include <map>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
 
 
 void PhysicalConstraint::getMatrices(UnmanagedVerticalFixedMatrix<double, 6>& parameterToMotionMatrixA, UnmanagedVerticalFixedMatrix<double, 6>& parameterToMotionMatrixB, UnmanagedHorizontalFixedMatrix<double, 6>& motionToEquationMatrixA, UnmanagedHorizontalFixedMatrix<double, 6>& motionToEquationMatrixB, UnmanagedHorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES>& errorValue) const {
@@ -25,136 +26,529 @@ void ConstraintGroup::add(Physical* first, Physical* second, Constraint* constra
 }
 
 
-void ConstraintGroup::apply() const {
-	size_t numberOfParameters = 0;
-	UnmanagedVerticalFixedMatrix<double, 6>* parameterToMotion = new UnmanagedVerticalFixedMatrix<double, 6>[constraints.size() * 2];
-	UnmanagedHorizontalFixedMatrix<double, 6>* motionToEquation = new UnmanagedHorizontalFixedMatrix<double, 6>[constraints.size() * 2];
-	for(size_t i = 0; i < constraints.size(); i++) {
-		int numParameters = constraints[i].constraint->numberOfParameters();
-		parameterToMotion[i * 2].cols = numParameters;
-		parameterToMotion[i * 2 + 1].cols = numParameters;
-		motionToEquation[i * 2].rows = numParameters;
-		motionToEquation[i * 2 + 1].rows = numParameters;
-		numberOfParameters += numParameters;
-	}
-
-	double* matrixBuffer = new double[6 * numberOfParameters * 4];
-	HorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES> vectorToSolve(numberOfParameters);
+struct PhysicalConstraintIndex {
+	const MotorizedPhysical* phys;
+	size_t constraintIndex;
 
-	{
-		size_t curParameterIndex = 0;
-		for(size_t i = 0; i < constraints.size(); i++) {
-			size_t curSize = parameterToMotion[i].cols;
-			parameterToMotion[i * 2].data = matrixBuffer + 6 * 4 * curParameterIndex;
-			parameterToMotion[i * 2 + 1].data = matrixBuffer + 6 * (4 * curParameterIndex + curSize);
-			motionToEquation[i * 2].data = matrixBuffer + 6 * (4 * curParameterIndex + 2 * curSize);
-			motionToEquation[i * 2 + 1].data = matrixBuffer + 6 * (4 * curParameterIndex + 3 * curSize);
+	bool operator<(const PhysicalConstraintIndex& other) const {
+		return (phys != other.phys) ? phys < other.phys : constraintIndex < other.constraintIndex;
+	}
+};
+
+/*
+	The system is stored block-sparse, there is one block for every pair of constraints that share a MotorizedPhysical
+	Block rows are indexed by constraint, the blocks of a row are sorted by the index of their column constraint
+	Everything points into the TickArena
+*/
+struct BlockSparseSystem {
+	size_t constraintCount;
+	size_t numberOfParameters;
+
+	// first parameter of every constraint, with numberOfParameters at the end
+	size_t* parameterOffsets;
+	// parameterToMotion A and B, motionToEquation A and B of every constraint
+	double* matrixBuffer;
+	// numberOfParameters * NUMBER_OF_ERROR_DERIVATIVES, row major
+	double* errorValues;
+	double* solution;
+
+	size_t* rowStarts;
+	size_t* blockCols;
+	size_t* blockOffsets;
+	double* blockValues;
+
+	// constraints in the order they are eliminated, and the place of every constraint in that order
+	size_t* eliminationOrder;
+	size_t* eliminationPosition;
+
+	inline size_t parameterCountOf(size_t constraintIndex) const {
+		return parameterOffsets[constraintIndex + 1] - parameterOffsets[constraintIndex];
+	}
+	UnmanagedVerticalFixedMatrix<double, 6> getParameterToMotion(size_t constraintIndex, int side) const {
+		size_t offset = parameterOffsets[constraintIndex];
+		size_t size = parameterCountOf(constraintIndex);
+		return UnmanagedVerticalFixedMatrix<double, 6>(matrixBuffer + 6 * (4 * offset + side * size), size);
+	}
+	UnmanagedHorizontalFixedMatrix<double, 6> getMotionToEquation(size_t constraintIndex, int side) const {
+		size_t offset = parameterOffsets[constraintIndex];
+		size_t size = parameterCountOf(constraintIndex);
+		return UnmanagedHorizontalFixedMatrix<double, 6>(matrixBuffer + 6 * (4 * offset + (2 + side) * size), size);
+	}
+};
 
-			// writing to errorVec which writes to vectorToSolve
-			UnmanagedHorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES> errorVec = vectorToSolve.subRows(curParameterIndex, curSize);
-			constraints[i].getMatrices(parameterToMotion[i * 2], parameterToMotion[i * 2 + 1], motionToEquation[i * 2], motionToEquation[i * 2 + 1], errorVec);
+static std::pair<const PhysicalConstraintIndex*, const PhysicalConstraintIndex*> getConstraintsOf(const PhysicalConstraintIndex* begin, const PhysicalConstraintIndex* end, const MotorizedPhysical* phys) {
+	const PhysicalConstraintIndex* first = std::lower_bound(begin, end, PhysicalConstraintIndex{phys, 0});
+	const PhysicalConstraintIndex* last = first;
+	while(last != end && last->phys == phys) ++last;
+	return std::make_pair(first, last);
+}
 
-			curParameterIndex += curSize;
+/*
+	Orders the constraints deepest first in a breadth first spanning tree of the physicals they connect
+	When a constraint is eliminated, the constraints deeper in the tree are already gone, the ones left that share a physical with it
+	are its siblings and the constraint to the parent, which already share that physical, so a tree of physicals has no fill-in
+	Only loops in the constraint graph create fill-in
+	Roots and neighbours are visited in the order of the constraints, so the result doesn't depend on where the physicals are in memory
+*/
+static void computeEliminationOrder(const std::vector<PhysicalConstraint>& constraints, const PhysicalConstraintIndex* constraintsOfPhysical, const PhysicalConstraintIndex* constraintsOfPhysicalEnd, BlockSparseSystem& sys, TickArena& arena) {
+	size_t constraintCount = sys.constraintCount;
+	size_t entryCount = constraintsOfPhysicalEnd - constraintsOfPhysical;
+
+	// depth of every physical, stored at the first entry of its run in constraintsOfPhysical
+	long long* depthOfRun = arena.allocate<long long>(entryCount);
+	for(size_t i = 0; i < entryCount; i++) {
+		depthOfRun[i] = -1;
+	}
+	size_t* queue = arena.allocate<size_t>(entryCount);
+	auto runOf = [&](const MotorizedPhysical* phys) {
+		return static_cast<size_t>(getConstraintsOf(constraintsOfPhysical, constraintsOfPhysicalEnd, phys).first - constraintsOfPhysical);
+	};
+
+	for(size_t root = 0; root < constraintCount; root++) {
+		size_t rootRun = runOf(constraints[root].physA->mainPhysical);
+		if(depthOfRun[rootRun] != -1) continue;
+		depthOfRun[rootRun] = 0;
+		size_t queueBegin = 0;
+		size_t queueEnd = 0;
+		queue[queueEnd++] = rootRun;
+		while(queueBegin != queueEnd) {
+			size_t run = queue[queueBegin++];
+			const MotorizedPhysical* phys = constraintsOfPhysical[run].phys;
+			for(const PhysicalConstraintIndex* cur = constraintsOfPhysical + run; cur != constraintsOfPhysicalEnd && cur->phys == phys; ++cur) {
+				const PhysicalConstraint& constraint = constraints[cur->constraintIndex];
+				const MotorizedPhysical* other = (constraint.physA->mainPhysical == phys) ? constraint.physB->mainPhysical : constraint.physA->mainPhysical;
+				size_t otherRun = runOf(other);
+				if(depthOfRun[otherRun] == -1) {
+					depthOfRun[otherRun] = depthOfRun[run] + 1;
+					queue[queueEnd++] = otherRun;
+				}
+			}
 		}
-		assert(curParameterIndex == numberOfParameters);
 	}
 
-	LargeMatrix<double> systemToSolve(numberOfParameters, numberOfParameters);
+	// counting sort on the depth of the deeper physical, deepest first, ties in constraint order
+	size_t* depthOfConstraint = arena.allocate<size_t>(constraintCount);
+	size_t maxDepth = 0;
+	for(size_t i = 0; i < constraintCount; i++) {
+		long long depthA = depthOfRun[runOf(constraints[i].physA->mainPhysical)];
+		long long depthB = depthOfRun[runOf(constraints[i].physB->mainPhysical)];
+		depthOfConstraint[i] = static_cast<size_t>(std::max(depthA, depthB));
+		maxDepth = std::max(maxDepth, depthOfConstraint[i]);
+	}
+	size_t* bucketStarts = arena.allocate<size_t>(maxDepth + 2);
+	for(size_t i = 0; i < maxDepth + 2; i++) {
+		bucketStarts[i] = 0;
+	}
+	for(size_t i = 0; i < constraintCount; i++) {
+		bucketStarts[maxDepth - depthOfConstraint[i] + 1]++;
+	}
+	for(size_t i = 1; i < maxDepth + 2; i++) {
+		bucketStarts[i] += bucketStarts[i - 1];
+	}
+	sys.eliminationOrder = arena.allocate<size_t>(constraintCount);
+	sys.eliminationPosition = arena.allocate<size_t>(constraintCount);
+	for(size_t i = 0; i < constraintCount; i++) {
+		size_t position = bucketStarts[maxDepth - depthOfConstraint[i]]++;
+		sys.eliminationOrder[position] = i;
+		sys.eliminationPosition[i] = position;
+	}
+}
 
-	{
-		size_t curColIndex = 0;
-		for(size_t blockCol = 0; blockCol < constraints.size(); blockCol++) {
-			int colSize = parameterToMotion[blockCol * 2].cols;
+/*
+	Block (row, col) is the effect of the parameters of constraint col on the equations of constraint row
+*/
+static void buildBlockSparseSystem(const std::vector<PhysicalConstraint>& constraints, BlockSparseSystem& sys, TickArena& arena) {
+	size_t constraintCount = sys.constraintCount;
 
-			MotorizedPhysical* mPhysA = constraints[blockCol].physA->mainPhysical;
-			MotorizedPhysical* mPhysB = constraints[blockCol].physB->mainPhysical;
+	PhysicalConstraintIndex* constraintsOfPhysical = arena.allocate<PhysicalConstraintIndex>(constraintCount * 2);
+	for(size_t i = 0; i < constraintCount; i++) {
+		constraintsOfPhysical[i * 2] = PhysicalConstraintIndex{constraints[i].physA->mainPhysical, i};
+		constraintsOfPhysical[i * 2 + 1] = PhysicalConstraintIndex{constraints[i].physB->mainPhysical, i};
+	}
+	const PhysicalConstraintIndex* constraintsOfPhysicalEnd = constraintsOfPhysical + constraintCount * 2;
+	std::sort(constraintsOfPhysical, constraintsOfPhysical + constraintCount * 2);
+
+	size_t maxBlockCount = 0;
+	for(size_t row = 0; row < constraintCount; row++) {
+		auto ofA = getConstraintsOf(constraintsOfPhysical, constraintsOfPhysicalEnd, constraints[row].physA->mainPhysical);
+		auto ofB = getConstraintsOf(constraintsOfPhysical, constraintsOfPhysicalEnd, constraints[row].physB->mainPhysical);
+		maxBlockCount += (ofA.second - ofA.first) + (ofB.second - ofB.first);
+	}
 
-			const UnmanagedHorizontalFixedMatrix<double, 6> & motionToEq1 = motionToEquation[blockCol * 2];
-			const UnmanagedHorizontalFixedMatrix<double, 6> & motionToEq2 = motionToEquation[blockCol * 2 + 1];
+	sys.rowStarts = arena.allocate<size_t>(constraintCount + 1);
+	sys.blockCols = arena.allocate<size_t>(maxBlockCount);
+	sys.blockOffsets = arena.allocate<size_t>(maxBlockCount);
+
+	size_t blockCount = 0;
+	size_t totalBlockSize = 0;
+	for(size_t row = 0; row < constraintCount; row++) {
+		size_t rowStart = blockCount;
+		sys.rowStarts[row] = rowStart;
+		auto ofA = getConstraintsOf(constraintsOfPhysical, constraintsOfPhysicalEnd, constraints[row].physA->mainPhysical);
+		auto ofB = getConstraintsOf(constraintsOfPhysical, constraintsOfPhysicalEnd, constraints[row].physB->mainPhysical);
+		for(const PhysicalConstraintIndex* cur = ofA.first; cur != ofA.second; ++cur) sys.blockCols[blockCount++] = cur->constraintIndex;
+		for(const PhysicalConstraintIndex* cur = ofB.first; cur != ofB.second; ++cur) sys.blockCols[blockCount++] = cur->constraintIndex;
+		std::sort(sys.blockCols + rowStart, sys.blockCols + blockCount);
+		blockCount = std::unique(sys.blockCols + rowStart, sys.blockCols + blockCount) - sys.blockCols;
+
+		size_t rowSize = sys.parameterCountOf(row);
+		for(size_t i = rowStart; i < blockCount; i++) {
+			sys.blockOffsets[i] = totalBlockSize;
+			totalBlockSize += rowSize * sys.parameterCountOf(sys.blockCols[i]);
+		}
+	}
+	sys.rowStarts[constraintCount] = blockCount;
+	sys.blockValues = arena.allocate<double>(totalBlockSize);
+
+	for(size_t row = 0; row < constraintCount; row++) {
+		MotorizedPhysical* mPhysA = constraints[row].physA->mainPhysical;
+		MotorizedPhysical* mPhysB = constraints[row].physB->mainPhysical;
+
+		const UnmanagedHorizontalFixedMatrix<double, 6> motionToEq1 = sys.getMotionToEquation(row, 0);
+		const UnmanagedHorizontalFixedMatrix<double, 6> motionToEq2 = sys.getMotionToEquation(row, 1);
+		size_t rowSize = motionToEq1.rows;
+
+		for(size_t blockIndex = sys.rowStarts[row]; blockIndex < sys.rowStarts[row + 1]; blockIndex++) {
+			size_t col = sys.blockCols[blockIndex];
+
+			MotorizedPhysical* cPhysA = constraints[col].physA->mainPhysical;
+			MotorizedPhysical* cPhysB = constraints[col].physB->mainPhysical;
+
+			const UnmanagedVerticalFixedMatrix<double, 6> paramToMotion1 = sys.getParameterToMotion(col, 0);
+			const UnmanagedVerticalFixedMatrix<double, 6> paramToMotion2 = sys.getParameterToMotion(col, 1);
+			size_t colSize = paramToMotion1.cols;
+
+			UnmanagedLargeMatrix<double> resultMat1(sys.blockValues + sys.blockOffsets[blockIndex], colSize, rowSize);
+			for(double& d : resultMat1) d = 0.0;
+			double resultBuf2[6 * 6];
+			UnmanagedLargeMatrix<double> resultMat2(resultBuf2, colSize, rowSize);
+			for(double& d : resultMat2) d = 0.0;
+			if(mPhysA == cPhysA) {
+				inMemoryMatrixMultiply(motionToEq1, paramToMotion1, resultMat1);
+			} else if(mPhysA == cPhysB) {
+				inMemoryMatrixMultiply(motionToEq1, paramToMotion2, resultMat1);
+				inMemoryMatrixNegate(resultMat1);
+			}
+			if(mPhysB == cPhysA) {
+				inMemoryMatrixMultiply(motionToEq2, paramToMotion1, resultMat2);
+				inMemoryMatrixNegate(resultMat2);
+			} else if(mPhysB == cPhysB) {
+				inMemoryMatrixMultiply(motionToEq2, paramToMotion2, resultMat2);
+			}
 
-			size_t curRowIndex = 0;
-			for(size_t blockRow = 0; blockRow < constraints.size(); blockRow++) {
-				int rowSize = motionToEquation[blockRow * 2].rows;
+			resultMat1 += resultMat2;
+		}
+	}
 
-				MotorizedPhysical* cPhysA = constraints[blockRow].physA->mainPhysical;
-				MotorizedPhysical* cPhysB = constraints[blockRow].physB->mainPhysical;
+	computeEliminationOrder(constraints, constraintsOfPhysical, constraintsOfPhysicalEnd, sys, arena);
+}
 
-				const UnmanagedVerticalFixedMatrix<double, 6> & paramToMotion1 = parameterToMotion[blockRow * 2];
-				const UnmanagedVerticalFixedMatrix<double, 6> & paramToMotion2 = parameterToMotion[blockRow * 2 + 1];
+// out = a * b, a is rows x inner, b is inner x cols, all row major
+static void multiplyBlocks(const double* a, const double* b, double* out, size_t rows, size_t inner, size_t cols) {
+	for(size_t i = 0; i < rows; i++) {
+		for(size_t j = 0; j < cols; j++) {
+			double total = 0.0;
+			for(size_t k = 0; k < inner; k++) {
+				total += a[i * inner + k] * b[k * cols + j];
+			}
+			out[i * cols + j] = total;
+		}
+	}
+}
+// out -= a * b
+static void subtractMultipliedBlocks(const double* a, const double* b, double* out, size_t rows, size_t inner, size_t cols) {
+	for(size_t i = 0; i < rows; i++) {
+		for(size_t j = 0; j < cols; j++) {
+			double total = 0.0;
+			for(size_t k = 0; k < inner; k++) {
+				total += a[i * inner + k] * b[k * cols + j];
+			}
+			out[i * cols + j] -= total;
+		}
+	}
+}
+/*
+	Inverts the size x size block in place, Gauss-Jordan with partial pivoting
+	Parameters without any effect on the equations have a zero pivot, they are left out and get a zero row and column
+*/
+static void invertBlock(double* block, size_t size) {
+	double work[6][12];
+	for(size_t i = 0; i < size; i++) {
+		for(size_t j = 0; j < size; j++) {
+			work[i][j] = block[i * size + j];
+			work[i][size + j] = (i == j) ? 1.0 : 0.0;
+		}
+	}
+	bool usable[6];
+	for(size_t col = 0; col < size; col++) {
+		size_t bestRow = col;
+		for(size_t row = col + 1; row < size; row++) {
+			if(std::abs(work[row][col]) > std::abs(work[bestRow][col])) bestRow = row;
+		}
+		if(bestRow != col) {
+			for(size_t j = 0; j < 2 * size; j++) std::swap(work[col][j], work[bestRow][j]);
+		}
+		double pivot = work[col][col];
+		usable[col] = pivot != 0.0;
+		if(!usable[col]) continue;
+		for(size_t j = 0; j < 2 * size; j++) work[col][j] /= pivot;
+		for(size_t row = 0; row < size; row++) {
+			if(row == col || work[row][col] == 0.0) continue;
+			double factor = work[row][col];
+			for(size_t j = 0; j < 2 * size; j++) work[row][j] -= factor * work[col][j];
+		}
+	}
+	for(size_t i = 0; i < size; i++) {
+		for(size_t j = 0; j < size; j++) {
+			block[i * size + j] = (usable[i] && usable[j]) ? work[i][size + j] : 0.0;
+		}
+	}
+}
 
-				double resultBuf1[6 * 6];
-				UnmanagedLargeMatrix<double> resultMat1(resultBuf1, rowSize, colSize);
-				for(double& d : resultMat1) d = 0.0;
-				double resultBuf2[6 * 6];
-				UnmanagedLargeMatrix<double> resultMat2(resultBuf2, rowSize, colSize);
-				for(double& d : resultMat2) d = 0.0;
-				if(mPhysA == cPhysA) {
-					inMemoryMatrixMultiply(motionToEq1, paramToMotion1, resultMat1);
-				} else if(mPhysA == cPhysB) {
-					inMemoryMatrixMultiply(motionToEq1, paramToMotion2, resultMat1);
-					inMemoryMatrixNegate(resultMat1);
-				}
-				if(mPhysB == cPhysA) {
-					inMemoryMatrixMultiply(motionToEq2, paramToMotion1, resultMat2);
-					inMemoryMatrixNegate(resultMat2);
-				} else if(mPhysB == cPhysB) {
-					inMemoryMatrixMultiply(motionToEq2, paramToMotion2, resultMat2);
+/*
+	The factorization of the system, in elimination order: position p stands for constraint eliminationOrder[p]
+	structure[p] are the positions after p whose blocks with p are nonzero, the original ones and the fill-in, sorted
+	lower[p] holds the blocks (j, p) for every j in structure[p], after factoring the multipliers of the unit lower triangle
+	upper[p] holds the blocks (p, j), diagonal[p] the inverse of the pivot block
+*/
+struct BlockFactorization {
+	size_t** structure;
+	size_t* structureSize;
+	double** lower;
+	double** upper;
+	double** diagonal;
+	// blocks of each structure entry in lower and upper start at these offsets
+	size_t** blockOffsets;
+
+	size_t findInStructure(size_t position, size_t otherPosition) const {
+		const size_t* found = std::lower_bound(structure[position], structure[position] + structureSize[position], otherPosition);
+		assert(found != structure[position] + structureSize[position] && *found == otherPosition);
+		return found - structure[position];
+	}
+};
+
+/*
+	Symbolic factorization over the elimination tree: the structure of p is its original neighbours after it,
+	joined with the structures of its children without p itself. The parent of p is the first position in its structure
+	Costs the total size of the structures, which is linear in the number of constraints when there is no fill-in
+*/
+static void computeStructure(const BlockSparseSystem& sys, BlockFactorization& factorization, TickArena& arena) {
+	size_t n = sys.constraintCount;
+	factorization.structure = arena.allocate<size_t*>(n);
+	factorization.structureSize = arena.allocate<size_t>(n);
+
+	size_t* firstChild = arena.allocate<size_t>(n);
+	size_t* nextSibling = arena.allocate<size_t>(n);
+	size_t* mark = arena.allocate<size_t>(n);
+	size_t* gathered = arena.allocate<size_t>(n);
+	const size_t NONE = n;
+	for(size_t p = 0; p < n; p++) {
+		firstChild[p] = NONE;
+		mark[p] = NONE;
+	}
+
+	for(size_t p = 0; p < n; p++) {
+		size_t count = 0;
+		size_t constraintIndex = sys.eliminationOrder[p];
+		for(size_t blockIndex = sys.rowStarts[constraintIndex]; blockIndex < sys.rowStarts[constraintIndex + 1]; blockIndex++) {
+			size_t other = sys.eliminationPosition[sys.blockCols[blockIndex]];
+			if(other > p && mark[other] != p) {
+				mark[other] = p;
+				gathered[count++] = other;
+			}
+		}
+		for(size_t child = firstChild[p]; child != NONE; child = nextSibling[child]) {
+			for(size_t i = 0; i < factorization.structureSize[child]; i++) {
+				size_t other = factorization.structure[child][i];
+				if(other > p && mark[other] != p) {
+					mark[other] = p;
+					gathered[count++] = other;
 				}
+			}
+		}
+		std::sort(gathered, gathered + count);
+		factorization.structure[p] = arena.allocate<size_t>(count);
+		std::copy(gathered, gathered + count, factorization.structure[p]);
+		factorization.structureSize[p] = count;
+
+		if(count != 0) {
+			size_t parent = gathered[0];
+			nextSibling[p] = firstChild[parent];
+			firstChild[parent] = p;
+		}
+	}
+}
 
-				resultMat1 += resultMat2;
+/*
+	Block LU decomposition of the system, solved for all error derivatives at once
+	With the elimination order of computeEliminationOrder a tree of physicals has no fill-in,
+	every step then only touches the few blocks around one constraint, so the whole solve is linear in the number of constraints
+*/
+static void solveBlockSparse(BlockSparseSystem& sys, TickArena& arena) {
+	size_t n = sys.constraintCount;
+	constexpr size_t D = NUMBER_OF_ERROR_DERIVATIVES;
+
+	BlockFactorization f;
+	computeStructure(sys, f, arena);
+
+	auto sizeAt = [&sys](size_t position) {
+		return sys.parameterCountOf(sys.eliminationOrder[position]);
+	};
+
+	f.lower = arena.allocate<double*>(n);
+	f.upper = arena.allocate<double*>(n);
+	f.diagonal = arena.allocate<double*>(n);
+	f.blockOffsets = arena.allocate<size_t*>(n);
+	for(size_t p = 0; p < n; p++) {
+		size_t size = sizeAt(p);
+		size_t offDiagonalSize = 0;
+		f.blockOffsets[p] = arena.allocate<size_t>(f.structureSize[p]);
+		for(size_t i = 0; i < f.structureSize[p]; i++) {
+			f.blockOffsets[p][i] = offDiagonalSize;
+			offDiagonalSize += size * sizeAt(f.structure[p][i]);
+		}
+		f.diagonal[p] = arena.allocate<double>(size * size);
+		f.lower[p] = arena.allocate<double>(offDiagonalSize);
+		f.upper[p] = arena.allocate<double>(offDiagonalSize);
+		std::fill(f.diagonal[p], f.diagonal[p] + size * size, 0.0);
+		std::fill(f.lower[p], f.lower[p] + offDiagonalSize, 0.0);
+		std::fill(f.upper[p], f.upper[p] + offDiagonalSize, 0.0);
+	}
 
-				systemToSolve.setSubMatrix(curRowIndex, curColIndex, resultMat1);
+	// the block of (row, col), both positions, which must be in the structure
+	auto blockAt = [&f](size_t row, size_t col) -> double* {
+		if(row == col) return f.diagonal[row];
+		if(row < col) return f.upper[row] + f.blockOffsets[row][f.findInStructure(row, col)];
+		return f.lower[col] + f.blockOffsets[col][f.findInStructure(col, row)];
+	};
+
+	for(size_t row = 0; row < n; row++) {
+		size_t rowPosition = sys.eliminationPosition[row];
+		size_t rowSize = sys.parameterCountOf(row);
+		for(size_t blockIndex = sys.rowStarts[row]; blockIndex < sys.rowStarts[row + 1]; blockIndex++) {
+			size_t col = sys.blockCols[blockIndex];
+			size_t blockSize = rowSize * sys.parameterCountOf(col);
+			const double* source = sys.blockValues + sys.blockOffsets[blockIndex];
+			std::copy(source, source + blockSize, blockAt(rowPosition, sys.eliminationPosition[col]));
+		}
+	}
 
-				curRowIndex += rowSize;
+	sys.solution = arena.allocate<double>(sys.numberOfParameters * D);
+	std::copy(sys.errorValues, sys.errorValues + sys.numberOfParameters * D, sys.solution);
+	auto rightHandSideAt = [&sys](size_t position) {
+		return sys.solution + D * sys.parameterOffsets[sys.eliminationOrder[position]];
+	};
+
+	// elimination, the right hand side is eliminated along
+	double multiplier[6 * 6];
+	for(size_t p = 0; p < n; p++) {
+		size_t size = sizeAt(p);
+		invertBlock(f.diagonal[p], size);
+		const double* rightHandSide = rightHandSideAt(p);
+
+		for(size_t i = 0; i < f.structureSize[p]; i++) {
+			size_t rowPosition = f.structure[p][i];
+			size_t rowSize = sizeAt(rowPosition);
+			double* lowerBlock = f.lower[p] + f.blockOffsets[p][i];
+			multiplyBlocks(lowerBlock, f.diagonal[p], multiplier, rowSize, size, size);
+			std::copy(multiplier, multiplier + rowSize * size, lowerBlock);
+
+			subtractMultipliedBlocks(lowerBlock, rightHandSide, rightHandSideAt(rowPosition), rowSize, size, D);
+			for(size_t j = 0; j < f.structureSize[p]; j++) {
+				size_t colPosition = f.structure[p][j];
+				const double* upperBlock = f.upper[p] + f.blockOffsets[p][j];
+				subtractMultipliedBlocks(lowerBlock, upperBlock, blockAt(rowPosition, colPosition), rowSize, size, sizeAt(colPosition));
 			}
-			curColIndex += colSize;
 		}
 	}
 
-	Log::debug("System matrix: %s\nvector: %s", str(systemToSolve).c_str(), str(vectorToSolve).c_str());
-
-	destructiveSolve(systemToSolve, vectorToSolve);
+	// back substitution
+	double remainder[6 * D];
+	for(size_t p = n; p-- > 0;) {
+		size_t size = sizeAt(p);
+		double* rightHandSide = rightHandSideAt(p);
+		std::copy(rightHandSide, rightHandSide + size * D, remainder);
+		for(size_t j = 0; j < f.structureSize[p]; j++) {
+			size_t colPosition = f.structure[p][j];
+			subtractMultipliedBlocks(f.upper[p] + f.blockOffsets[p][j], rightHandSideAt(colPosition), remainder, size, sizeAt(colPosition), D);
+		}
+		multiplyBlocks(f.diagonal[p], remainder, rightHandSide, size, size, D);
+	}
+}
 
-	{
-		size_t curParameterIndex = 0;
-		for(size_t i = 0; i < constraints.size(); i++) {
-			const UnmanagedVerticalFixedMatrix<double, 6>& curP2MA = parameterToMotion[i * 2];
-			const UnmanagedVerticalFixedMatrix<double, 6>& curP2MB = parameterToMotion[i * 2 + 1];
-			size_t curSize = curP2MA.cols;
+// room for the system, the factorization and the ordering of one constraint with up to 6 parameters and a few neighbours
+static constexpr std::size_t ARENA_BYTES_PER_CONSTRAINT = 4096;
 
-			UnmanagedHorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES> parameterVec = vectorToSolve.subRows(curParameterIndex, curSize);
-			Matrix<double, 6, NUMBER_OF_ERROR_DERIVATIVES> effectOnA = curP2MA * parameterVec;
-			Matrix<double, 6, NUMBER_OF_ERROR_DERIVATIVES> effectOnB = -(curP2MB * parameterVec);
+void ConstraintGroup::apply() const {
+	TickArena arena(ARENA_BYTES_PER_CONSTRAINT * (constraints.size() + 1));
+	apply(arena);
+}
 
-			// TODO add moving correction
-			Vector<double, 6> offsetAngularEffectOnA = effectOnA.getCol(0);
-			Vector<double, 6> offsetAngularEffectOnB = effectOnB.getCol(0);
+void ConstraintGroup::apply(TickArena& arena) const {
+	if(constraints.empty()) return;
 
-			GlobalCFrame& mainPACF = constraints[i].physA->mainPhysical->rigidBody.mainPart->cframe;
-			GlobalCFrame& mainPBCF = constraints[i].physB->mainPhysical->rigidBody.mainPart->cframe;
-			mainPACF.position += offsetAngularEffectOnA.getSubVector<3>(0);
-			mainPACF.rotation = Rotation::fromRotationVec(offsetAngularEffectOnA.getSubVector<3>(3)) * mainPACF.rotation;
-			mainPBCF.position += offsetAngularEffectOnB.getSubVector<3>(0);
-			mainPBCF.rotation = Rotation::fromRotationVec(offsetAngularEffectOnB.getSubVector<3>(3)) * mainPBCF.rotation;
+	BlockSparseSystem sys;
+	sys.constraintCount = constraints.size();
 
-			Vector<double, 6> velAngularEffectOnA = effectOnA.getCol(1);
-			Vector<double, 6> velAngularEffectOnB = effectOnB.getCol(1);
-			constraints[i].physA->mainPhysical->motionOfCenterOfMass.translation.translation[0] += velAngularEffectOnA.getSubVector<3>(0);
-			constraints[i].physA->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] += velAngularEffectOnA.getSubVector<3>(3);
-			constraints[i].physB->mainPhysical->motionOfCenterOfMass.translation.translation[0] += velAngularEffectOnB.getSubVector<3>(0);
-			constraints[i].physB->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] += velAngularEffectOnB.getSubVector<3>(3);
+	sys.parameterOffsets = arena.allocate<size_t>(constraints.size() + 1);
+	size_t numberOfParameters = 0;
+	for(size_t i = 0; i < constraints.size(); i++) {
+		sys.parameterOffsets[i] = numberOfParameters;
+		numberOfParameters += constraints[i].constraint->numberOfParameters();
+	}
+	sys.parameterOffsets[constraints.size()] = numberOfParameters;
+	sys.numberOfParameters = numberOfParameters;
 
+	sys.matrixBuffer = arena.allocate<double>(6 * numberOfParameters * 4);
+	sys.errorValues = arena.allocate<double>(numberOfParameters * NUMBER_OF_ERROR_DERIVATIVES);
+	for(size_t i = 0; i < numberOfParameters * NUMBER_OF_ERROR_DERIVATIVES; i++) {
+		sys.errorValues[i] = 0.0;
+	}
 
-			/*Vector<double, 6> accelAngularEffectOnA = effectOnA.getCol(2);
-			Vector<double, 6> accelAngularEffectOnB = effectOnB.getCol(2);
-			constraints[i].physA->mainPhysical->totalForce += constraints[i].physA->mainPhysical->totalMass * velAngularEffectOnA.getSubVector<3>(0);
-			constraints[i].physA->mainPhysical->totalMoment += ~constraints[i].physA->mainPhysical->momentResponse * velAngularEffectOnA.getSubVector<3>(3);
-			constraints[i].physB->mainPhysical->totalForce += constraints[i].physB->mainPhysical->totalMass * velAngularEffectOnB.getSubVector<3>(0);
-			constraints[i].physB->mainPhysical->totalMoment += ~constraints[i].physB->mainPhysical->momentResponse * velAngularEffectOnB.getSubVector<3>(3);*/
+	for(size_t i = 0; i < constraints.size(); i++) {
+		UnmanagedVerticalFixedMatrix<double, 6> paramToMotionA = sys.getParameterToMotion(i, 0);
+		UnmanagedVerticalFixedMatrix<double, 6> paramToMotionB = sys.getParameterToMotion(i, 1);
+		UnmanagedHorizontalFixedMatrix<double, 6> motionToEqA = sys.getMotionToEquation(i, 0);
+		UnmanagedHorizontalFixedMatrix<double, 6> motionToEqB = sys.getMotionToEquation(i, 1);
+		UnmanagedHorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES> errorVec(sys.errorValues + NUMBER_OF_ERROR_DERIVATIVES * sys.parameterOffsets[i], sys.parameterCountOf(i));
+		constraints[i].getMatrices(paramToMotionA, paramToMotionB, motionToEqA, motionToEqB, errorVec);
+	}
 
+	buildBlockSparseSystem(constraints, sys, arena);
+	solveBlockSparse(sys, arena);
 
-			curParameterIndex += curSize;
-		}
-		assert(curParameterIndex == numberOfParameters);
+	for(size_t i = 0; i < constraints.size(); i++) {
+		const UnmanagedVerticalFixedMatrix<double, 6> curP2MA = sys.getParameterToMotion(i, 0);
+		const UnmanagedVerticalFixedMatrix<double, 6> curP2MB = sys.getParameterToMotion(i, 1);
+
+		UnmanagedHorizontalFixedMatrix<double, NUMBER_OF_ERROR_DERIVATIVES> parameterVec(sys.solution + NUMBER_OF_ERROR_DERIVATIVES * sys.parameterOffsets[i], sys.parameterCountOf(i));
+		Matrix<double, 6, NUMBER_OF_ERROR_DERIVATIVES> effectOnA = curP2MA * parameterVec;
+		Matrix<double, 6, NUMBER_OF_ERROR_DERIVATIVES> effectOnB = -(curP2MB * parameterVec);
+
+		// TODO add moving correction
+		Vector<double, 6> offsetAngularEffectOnA = effectOnA.getCol(0);
+		Vector<double, 6> offsetAngularEffectOnB = effectOnB.getCol(0);
+
+		GlobalCFrame& mainPACF = constraints[i].physA->mainPhysical->rigidBody.mainPart->cframe;
+		GlobalCFrame& mainPBCF = constraints[i].physB->mainPhysical->rigidBody.mainPart->cframe;
+		mainPACF.position += offsetAngularEffectOnA.getSubVector<3>(0);
+		mainPACF.rotation = Rotation::fromRotationVec(offsetAngularEffectOnA.getSubVector<3>(3)) * mainPACF.rotation;
+		mainPBCF.position += offsetAngularEffectOnB.getSubVector<3>(0);
+		mainPBCF.rotation = Rotation::fromRotationVec(offsetAngularEffectOnB.getSubVector<3>(3)) * mainPBCF.rotation;
+
+		Vector<double, 6> velAngularEffectOnA = effectOnA.getCol(1);
+		Vector<double, 6> velAngularEffectOnB = effectOnB.getCol(1);
+		constraints[i].physA->mainPhysical->motionOfCenterOfMass.translation.translation[0] += velAngularEffectOnA.getSubVector<3>(0);
+		constraints[i].physA->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] += velAngularEffectOnA.getSubVector<3>(3);
+		constraints[i].physB->mainPhysical->motionOfCenterOfMass.translation.translation[0] += velAngularEffectOnB.getSubVector<3>(0);
+		constraints[i].physB->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] += velAngularEffectOnB.getSubVector<3>(3);
+
+
+		/*Vector<double, 6> accelAngularEffectOnA = effectOnA.getCol(2);
+		Vector<double, 6> accelAngularEffectOnB = effectOnB.getCol(2);
+		constraints[i].physA->mainPhysical->totalForce += constraints[i].physA->mainPhysical->totalMass * velAngularEffectOnA.getSubVector<3>(0);
+		constraints[i].physA->mainPhysical->totalMoment += ~constraints[i].physA->mainPhysical->momentResponse * velAngularEffectOnA.getSubVector<3>(3);
+		constraints[i].physB->mainPhysical->totalForce += constraints[i].physB->mainPhysical->totalMass * velAngularEffectOnB.getSubVector<3>(0);
+		constraints[i].physB->mainPhysical->totalMoment += ~constraints[i].physB->mainPhysical->momentResponse * velAngularEffectOnB.getSubVector<3>(3);*/
 	}
 }
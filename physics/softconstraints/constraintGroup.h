@@ -5,6 +5,7 @@
 #include "softConstraint.h"
 
 class Physical;
+class TickArena;
 
 struct PhysicalConstraint {
 	inline PhysicalConstraint(Physical* physA, Physical* physB, Constraint* constraint) :
@@ -24,5 +25,13 @@ struct ConstraintGroup {
 
 	void add(Physical* first, Physical* second, Constraint* constraint);
 	
+	/*
+		Solves the group directly with a block-sparse LU decomposition, eliminating the constraints leaves first
+		Cost is linear in the number of constraints for groups without loops, such as chains and ragdolls,
+		as long as every physical only has a few constraints; loops add fill-in
+		All scratch memory is taken from arena
+	*/
+	void apply(TickArena& arena) const;
+	// for use outside of a world tick, allocates a temporary arena
 	void apply() const;
 };
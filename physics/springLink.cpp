@@ -1,6 +1,7 @@
 
 
 #include "springLink.h"
+#include "softLinkBatch.h"
 #include <cstdlib>
 
 
@@ -11,6 +12,10 @@ SpringLink::SpringLink(AttachedPart part1, AttachedPart part2, double restLength
 
 }
 
+void SpringLink::gatherInto(SoftLinkBatch& batch, std::size_t index) const {
+	batch.gather(index, *this, this->restLength, this->stiffness, false);
+}
+
 void SpringLink::update() {
 	Vec3 force = forceAppliedToTheLink();
 	this->attachedPart2.part->applyForce(this->getRelativePositionOfAttach1(), force);
@@ -13,6 +13,8 @@ public:
 	SpringLink(AttachedPart part1, AttachedPart part2,  double restLength, double stiffness);
 
 	void update() override;
+	bool isBatched() const override { return true; }
+	void gatherInto(SoftLinkBatch& batch, std::size_t index) const override;
 
 private:
 	Vec3 forceAppliedToTheLink() noexcept;
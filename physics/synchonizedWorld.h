@@ -4,24 +4,43 @@
 #include <mutex>
 #include <shared_mutex>
 #include <functional>
+#include <atomic>
 
 #include "world.h"
 #include "sharedLockGuard.h"
 #include "physicsProfiler.h"
+#include "datastructures/operationQueue.h"
+#include "worldSnapshot.h"
 
 template<typename T = Part>
 class SynchronizedWorld : public World<T> {
-	mutable std::shared_mutex lock;
-	mutable std::mutex queueLock;
+	static constexpr std::size_t OPERATION_QUEUE_CAPACITY = 1024;
+
+	mutable UpgradableMutex lock;
 	mutable std::mutex readQueueLock;
 
-	std::queue<std::function<void()>> waitingOperations;
+	OperationQueue<> waitingOperations{OPERATION_QUEUE_CAPACITY};
+
+	/*
+		Operations which didn't fit in waitingOperations, these are run after it
+		While this isn't empty every operation goes here, so the operations of a single thread stay in order
+	*/
+	std::mutex overflowLock;
+	std::queue<std::function<void()>> overflowOperations;
+	std::atomic<bool> isOverflowing{false};
+
 	mutable std::queue<std::function<void()>> waitingReadOnlyOperations;
 
+	SnapshotBuffer snapshots;
+
 	template<typename Func>
 	void pushOperation(const Func& func) {
-		std::lock_guard<std::mutex> lg(queueLock);
-		waitingOperations.emplace(func);
+		if(!isOverflowing.load(std::memory_order_acquire) && waitingOperations.tryPush(func)) {
+			return;
+		}
+		std::lock_guard<std::mutex> lg(overflowLock);
+		overflowOperations.emplace(func);
+		isOverflowing.store(true, std::memory_order_release);
 	}
 	template<typename Func>
 	void pushReadOnlyOperation(const Func& func) const {
@@ -29,13 +48,18 @@ class SynchronizedWorld : public World<T> {
 		waitingReadOnlyOperations.emplace(func);
 	}
 
+	// only called by tick, under the exclusive lock
 	void processQueue() {
-		std::lock_guard<std::mutex> lg(queueLock);
-
-		while (!waitingOperations.empty()) {
-			std::function<void()>& operation = waitingOperations.front();
-			operation();
-			waitingOperations.pop();
+		waitingOperations.drain();
+
+		if(isOverflowing.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lg(overflowLock);
+			while(!overflowOperations.empty()) {
+				std::function<void()>& operation = overflowOperations.front();
+				operation();
+				overflowOperations.pop();
+			}
+			isOverflowing.store(false, std::memory_order_release);
 		}
 	}
 
@@ -53,9 +77,27 @@ public:
 
 	SynchronizedWorld<T>(double deltaT) : World<T>(deltaT) {}
 
+	/*
+		The snapshot published by the last tick, read without taking the lock of the world
+		Only one thread may read snapshots, the returned snapshot stays valid and unchanged until that thread calls this again
+	*/
+	inline const WorldSnapshot& getLatestSnapshot() { return snapshots.acquireLatest(); }
+
+	/*
+		Stored in the PartSnapshot of part, called by the physics thread while it holds the lock of the world
+		Readers of the snapshot can't safely follow PartSnapshot::part, whatever they need to know about the part goes here
+	*/
+	virtual std::uint64_t getSnapshotUserData(const T&) const { return 0; }
+
+	// pushes, contention and latency of the operations deferred by asyncModification
+	inline const OperationQueueStatistics& getQueueStatistics() const { return waitingOperations.getStatistics(); }
+
+	// waits for the lock of the world, of its readers and writers, and of the tick, which holds an upgradable lock
+	inline const LockStatistics& getLockStatistics() const { return lock.getStatistics(); }
+
 	template<typename Func>
 	void syncModification(const Func& function) {
-		std::lock_guard<std::shared_mutex> lg(lock);
+		std::lock_guard<UpgradableMutex> lg(lock);
 		function();
 	}
 	template<typename Func>
@@ -69,7 +111,7 @@ public:
 	}
 	template<typename Func>
 	void syncReadOnlyOperation(const Func& function) const {
-		SharedLockGuard lg(lock);
+		std::shared_lock<UpgradableMutex> lg(lock);
 		function();
 	}
 	template<typename Func>
@@ -84,11 +126,16 @@ public:
 
 	virtual void tick() override {
 		SharedLockGuard mutLock(lock);
+
+		this->tickArena.reset();
 		
 		this->findColissions();
 		
 		physicsMeasure.mark(PhysicsProcess::EXTERNALS);
 		this->applyExternalForces();
+		this->applyBatchedExternalForces();
+
+		this->buildIslands();
 
 		this->handleColissions();
 
@@ -96,6 +143,7 @@ public:
 
 		this->handleConstraints();
 
+		// no writer can get in between the upgradable lock and the exclusive one, so the islands and colissions are still valid
 		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
 		mutLock.upgrade();
 		this->update();
@@ -106,6 +154,15 @@ public:
 		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
 		mutLock.downgrade();
 
+		// the queued modifications are part of this tick, so they are in the snapshot
+		physicsMeasure.mark(PhysicsProcess::SNAPSHOT);
+		WorldSnapshot& snapshot = snapshots.getBackBuffer();
+		snapshot.capture(*this);
+		for(PartSnapshot& partSnapshot : snapshot.parts) {
+			partSnapshot.userData = getSnapshotUserData(static_cast<const T&>(*partSnapshot.part));
+		}
+		snapshots.publish();
+
 		physicsMeasure.mark(PhysicsProcess::QUEUE);
 		processReadQueue();
 	}
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include "../util/log.h"
+#include "../util/taskGraph.h"
 #include "layer.h"
 #include "misc/validityHelper.h"
 
@@ -69,7 +70,12 @@ WorldPrototype::WorldPrototype(double deltaT) :
 }
 
 WorldPrototype::~WorldPrototype() {
-
+	// parts which outlive the world no longer refer to it, the pooled parts and physicals are destroyed with their pools
+	std::vector<Part*> detachedParts;
+	detachAllParts(detachedParts);
+	for(std::pair<std::type_index, std::unique_ptr<PartPool>>& pool : partPools) {
+		pool.second->clear();
+	}
 }
 
 static std::pair<int, int> pairLayers(int layer1, int layer2) {
@@ -150,8 +156,10 @@ void WorldPrototype::addPart(Part* part, int layerIndex) {
 		return;
 	}
 
-	part->ensureHasParent();
-	physicals.push_back(part->parent->mainPhysical);
+	if(part->parent == nullptr) {
+		part->parent = MotorizedPhysical::create(this, part);
+	}
+	addToPhysicals(part->parent->mainPhysical);
 	part->parent->mainPhysical->world = this;
 
 
@@ -159,7 +167,7 @@ void WorldPrototype::addPart(Part* part, int layerIndex) {
 	part->parent->mainPhysical->forEachPart([worldLayer](Part& p) {
 		p.layer = worldLayer;
 	});
-	worldLayer->tree.add(createNodeFor(part->parent->mainPhysical));
+	worldLayer->addNode(createNodeFor(part->parent->mainPhysical));
 
 
 	objectCount += part->parent->mainPhysical->getNumberOfPartsInThisAndChildren();
@@ -174,8 +182,9 @@ void WorldPrototype::addPart(Part* part, int layerIndex) {
 }
 
 void WorldPrototype::addPhysicalWithExistingLayers(MotorizedPhysical* motorPhys) {
-	physicals.push_back(motorPhys);
+	addToPhysicals(motorPhys);
 	motorPhys->world = this;
+	objectCount += motorPhys->getNumberOfPartsInThisAndChildren();
 
 	std::vector<FoundLayerRepresentative> foundLayers = findAllLayersIn(motorPhys);
 
@@ -214,31 +223,66 @@ void WorldPrototype::removePart(Part* part) {
 }
 
 void WorldPrototype::deletePart(Part* partToDelete) const {
-	delete partToDelete;
+	if(!destroyPooledPart(partToDelete)) {
+		delete partToDelete;
+	}
+}
+bool WorldPrototype::isPooledPart(const Part* part) const {
+	for(const std::pair<std::type_index, std::unique_ptr<PartPool>>& pool : partPools) {
+		if(pool.second->owns(part)) return true;
+	}
+	return false;
+}
+bool WorldPrototype::destroyPooledPart(Part* part) const {
+	for(const std::pair<std::type_index, std::unique_ptr<PartPool>>& pool : partPools) {
+		if(pool.second->owns(part)) {
+			pool.second->destroy(part);
+			return true;
+		}
+	}
+	return false;
 }
 
-void WorldPrototype::clear() {
-	this->constraints.clear();
-	this->externalForces.clear();
+void WorldPrototype::detachAllParts(std::vector<Part*>& detachedParts) {
+	// the physicals from the pool of this world are destroyed together with the pool below
 	for(MotorizedPhysical* phys : this->physicals) {
-		delete phys;
+		if(phys->allocatingWorld != this) {
+			MotorizedPhysical::destroy(phys);
+		}
 	}
 	this->physicals.clear();
-	std::vector<Part*> partsToDelete;
+	physicalPool.clear();
 	for(Part& p : this->iterParts()) {
 		p.parent = nullptr;
 		p.layer = nullptr;
-		partsToDelete.push_back(&p);
+		detachedParts.push_back(&p);
 	}
 	this->objectCount = 0;
+	this->structureVersion++;
+	this->regions.invalidate();
 	for(ColissionLayer& cl : this->layers) {
 		for(WorldLayer& layer : cl.subLayers) {
 			layer.tree.clear();
 		}
 	}
+}
+
+void WorldPrototype::clear() {
+	this->constraints.clear();
+	this->externalForces.clear();
+	std::vector<Part*> partsToDelete;
+	detachAllParts(partsToDelete);
 	for(Part* p : partsToDelete) {
 		this->onPartRemoved(p);
-		this->deletePart(p);
+	}
+	// parts made by createPart are destroyed pool by pool, only the other parts are deleted one at a time
+	for(Part* p : partsToDelete) {
+		if(!isPooledPart(p)) {
+			this->deletePart(p);
+		}
+	}
+	for(std::pair<std::type_index, std::unique_ptr<PartPool>>& pool : partPools) {
+		pool.second->clear();
 	}
 }
 
@@ -246,8 +290,17 @@ size_t WorldPrototype::getLayerCount() const {
 	return this->layers.size();
 }
 
+void WorldPrototype::addToPhysicals(MotorizedPhysical* motorPhys) {
+	// a physical from the pool of another world would be destroyed when that world is cleared, while this world still holds it
+	if(motorPhys->allocatingWorld != nullptr && motorPhys->allocatingWorld != this) {
+		throw std::logic_error("Physical is allocated from the pool of another world!");
+	}
+	physicals.push_back(motorPhys);
+}
+
 void WorldPrototype::notifyMainPhysicalObsolete(MotorizedPhysical* motorPhys) {
 	physicals.erase(std::remove(physicals.begin(), physicals.end(), motorPhys));
+	regions.notifyPhysicalRemoved(motorPhys);
 
 	ASSERT_VALID;
 }
@@ -259,8 +312,9 @@ void WorldPrototype::optimizeLayers() {
 }
 
 void WorldPrototype::notifyNewPhysicalCreated(MotorizedPhysical* newPhysical) {
-	physicals.push_back(newPhysical);
+	addToPhysicals(newPhysical);
 	newPhysical->world = this;
+	regions.invalidate();
 }
 
 static void assignLayersForPhysicalRecurse(const Physical& phys, std::vector<std::pair<WorldLayer*, std::vector<const Part*>>>& foundLayers) {
@@ -341,10 +395,12 @@ void WorldPrototype::notifyPhysicalsMerged(const MotorizedPhysical* firstPhysica
 		assert(secondPhysical->world == this);
 		removePhysicalFromList(this->physicals, secondPhysical);
 	}
+	regions.invalidate();
 }
 
 void WorldPrototype::notifyNewPartAddedToPhysical(const MotorizedPhysical* physical, Part* newPart) {
 	assert(physical->world == this);
+	regions.invalidate();
 
 	onPartAdded(newPart);
 }
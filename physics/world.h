@@ -10,6 +10,13 @@
 #include "layer.h"
 #include "softLink.h"
 #include "colissionBuffer.h"
+#include "island.h"
+#include "datastructures/tickArena.h"
+#include "datastructures/slabPool.h"
+#include "softLinkBatch.h"
+#include "externalForceBatch.h"
+#include "integrator.h"
+#include "worldRegions.h"
 
 #include "springLink.h"
 #include "elasticLink.h"
@@ -17,10 +24,17 @@
 #include "alignmentLink.h"
 
 #include <memory>
+#include <cstdint>
+#include <typeindex>
 
 class ExternalForce;
 class WorldLayer;
 
+namespace Util {
+class ThreadPool;
+class TaskGraph;
+};
+
 template<bool IsConst>
 class WorldLayerIter {
 protected:
@@ -151,8 +165,46 @@ using FilteredWorldIterator = FilteredWorldIteratorTemplate<false, Filter>;
 template<typename Filter>
 using FilteredConstWorldIterator = FilteredWorldIteratorTemplate<true, Filter>;
 
+// the parts of one type made by WorldPrototype::createPart
+class PartPool {
+public:
+	virtual ~PartPool() {}
+	virtual bool owns(const Part* part) const = 0;
+	virtual void destroy(Part* part) = 0;
+	// destroys every part of the pool
+	virtual void clear() = 0;
+};
+template<typename PartType>
+class TypedPartPool : public PartPool {
+public:
+	SlabPool<PartType> pool;
+
+	virtual bool owns(const Part* part) const override { return pool.owns(part); }
+	virtual void destroy(Part* part) override { pool.destroy(static_cast<PartType*>(part)); }
+	virtual void clear() override { pool.clear(); }
+};
+
 class WorldPrototype {
 private:
+	// one per type of part made with createPart, declared before the layers, which still touch the parts when they're destroyed
+	std::vector<std::pair<std::type_index, std::unique_ptr<PartPool>>> partPools;
+	// the MotorizedPhysicals made for the parts of this world, see MotorizedPhysical::create
+	SlabPool<MotorizedPhysical, 64> physicalPool;
+
+	// appends motorPhys to physicals, throws if it is allocated from the pool of another world
+	void addToPhysicals(MotorizedPhysical* motorPhys);
+
+	template<typename PartType>
+	TypedPartPool<PartType>& getPartPool() {
+		for(std::pair<std::type_index, std::unique_ptr<PartPool>>& pool : partPools) {
+			if(pool.first == std::type_index(typeid(PartType))) {
+				return static_cast<TypedPartPool<PartType>&>(*pool.second);
+			}
+		}
+		partPools.emplace_back(std::type_index(typeid(PartType)), std::make_unique<TypedPartPool<PartType>>());
+		return static_cast<TypedPartPool<PartType>&>(*partPools.back().second);
+	}
+
 	friend class Physical;
 	friend class MotorizedPhysical;
 	friend class ConnectedPhysical;
@@ -190,12 +242,39 @@ private:
 
 protected:
 	// World tick steps
+	/*
+		Applies the unbatched ExternalForces and prepares the batched ones
+		Always followed by applyBatchedExternalForces, which applies the batched forces to all physicals at once
+	*/
 	virtual void applyExternalForces();
+	void applyBatchedExternalForces();
 	virtual void findColissions();
+	// the part of findColissions for when the world isn't split into regions, goes over the trees of the layers
+	void findLayerColissions();
 	virtual void handleColissions();
 	virtual void handleConstraints();
 	virtual void update();
 
+	/*
+		Runs colission handling and constraints for each island as a single task, then updates all physicals in parallel chunks, and finally the SoftLinks of each island
+		Replaces the separate calls to handleColissions, handleConstraints and update
+	*/
+	virtual void stepIslands();
+
+	// tick as a graph of tasks, used instead of the stages above when the world has a threadPool
+	void buildTickGraph(Util::TaskGraph& graph);
+
+	// splits the world into islands for this tick, the islands stay valid until the end of the tick
+	void buildIslands(bool includeColissions = true);
+	void ensureIslandsBuilt();
+	/*
+		Brings the BoundsTrees of the free parts of the layers and of the WorldRegions up to the new bounds of all moved parts
+		The parallel update never touches the layers, this runs after it, spread over the threadPool if there is one
+	*/
+	void refreshTrees();
+	// serial work at the end of a tick, after all physicals have been updated and the trees refreshed
+	void finishUpdate();
+
 
 	// event handlers
 	virtual void onPartAdded(Part* newPart);
@@ -203,6 +282,11 @@ protected:
 
 	// called when the part has already been removed from the world
 	virtual void deletePart(Part* partToDelete) const;
+	// destroys the part if it was made by createPart, returns false for parts which weren't
+	bool destroyPooledPart(Part* part) const;
+	bool isPooledPart(const Part* part) const;
+	// destroys all physicals and empties the layers, the parts which were in them are left without parent and layer
+	void detachAllParts(std::vector<Part*>& detachedParts);
 
 public:
 	std::vector<ExternalForce*> externalForces;
@@ -220,6 +304,43 @@ public:
 	
 	ColissionBuffer curColissions;
 
+	IslandSet islands;
+	bool islandsAreBuilt = false;
+
+	/*
+		Scratch memory for the stages of a tick, reset at the start of every tick
+		Nothing allocated from it may be kept past the end of the tick
+	*/
+	TickArena tickArena;
+
+	/*
+		If set, islands are stepped in parallel on this pool
+		The pool is not owned by the world
+
+		Ticks give bit for bit the same result with or without a pool, for any number of threads:
+		every parallel stage hands each physical to exactly one task, and within a task works in the same order as the serial loop,
+		so no forces are ever summed in an order that depends on scheduling. New parallel stages must keep this, see getStateHash
+	*/
+	Util::ThreadPool* threadPool = nullptr;
+
+	// built at the first tick with a threadPool, its profile holds the timing of every task of the last tick
+	std::unique_ptr<Util::TaskGraph> tickGraph;
+
+	// rows of the SpringLinks and ElasticLinks of this tick, allocated from the tickArena
+	SoftLinkBatch softLinkBatch;
+
+	// bodies of all physicals for the batched ExternalForces of this tick, allocated from the tickArena, empty without batched forces
+	ExternalForceBatch externalForceBatch;
+
+	// splits the colission detection between free parts into regions of space, off until regions.regionCount is set above 1
+	WorldRegions regions;
+
+	/*
+		Every this many ticks the end of the tick runs reorderPhysicalsSpatially, 0 turns it off
+		The order of physicals is part of getStateHash, and may change the rounding within islands, so two runs only stay identical with the same interval
+	*/
+	size_t spatialReorderInterval = 0;
+
 	/*
 		These lists signify which layers collide
 	*/
@@ -227,7 +348,11 @@ public:
 	
 	size_t age = 0;
 	size_t objectCount = 0;
+	// incremented whenever parts are added to or removed from the layers, or regrouped within them
+	std::uint64_t structureVersion = 0;
 	double deltaT;
+	// used by all physicals which don't choose their own, see MotorizedPhysical::integrator
+	Integrator integrator = Integrator::EXPLICIT;
 
 
 	WorldPrototype(double deltaT);
@@ -247,6 +372,16 @@ public:
 	void addTerrainPart(Part* part, int layerIndex = 0);
 	void removePart(Part* part);
 
+	/*
+		Constructs a part in a SlabPool of this world, parts made one after the other lie next to each other in memory
+		The world owns the part, it is destroyed by clear() and must never be deleted
+		Making the part doesn't add it to the world, and removing it from the world doesn't destroy it
+	*/
+	template<typename PartType = Part, typename... Args>
+	PartType* createPart(Args&&... args) {
+		return getPartPool<PartType>().pool.create(std::forward<Args>(args)...);
+	}
+
 	bool doLayersCollide(int layer1, int layer2) const;
 	void setLayersCollide(int layer1, int layer2, bool collide);
 
@@ -258,6 +393,14 @@ public:
 
 	void optimizeLayers();
 
+	/*
+		Sorts physicals along a Morton curve through the positions of their main parts
+		The passes over physicals, the islands built from them and the physicals within each island then visit bodies which are close
+		in space one after the other, so the bodies a colission touches are more likely to still be in cache
+		Only the order of physicals changes, parts and physicals stay where they are in memory, everything refers to them by pointer
+	*/
+	void reorderPhysicalsSpatially();
+
 	// removes everything from this world, parts, physicals, forces, constraints
 	void clear();
 
@@ -272,6 +415,16 @@ public:
 	virtual double getPotentialEnergyOfPhysical(const MotorizedPhysical& p) const;
 	virtual double getTotalEnergy() const;
 
+	/*
+		Hash of the exact bits of the cframes of all parts in physicals, the motion of all physicals and the age of the world
+		For checking that two runs of a simulation stay identical, tick by tick
+
+		Only runs of the same build on the same kind of CPU can be compared: with -march=native the compiler may fuse any a * b + c
+		into an FMA instruction, and the batches use AVXLaneOps only where AVX2 and FMA are available, see math/laneOps.h
+		Both round differently from separate multiplies and adds, so the same world hashes differently on machines with other instruction sets
+	*/
+	uint64_t getStateHash() const;
+
 	void addExternalForce(ExternalForce* force);
 	void removeExternalForce(ExternalForce* force);
 
@@ -321,7 +474,29 @@ public:
 
 class ExternalForce {
 public:
+	virtual ~ExternalForce() {}
+	/*
+		Adds this force to the physicals of world, for forces which aren't batched
+		With a threadPool this may run on a worker instead of the calling thread, at the same time as the broadphase
+		So it must not mark the profilers of the world, and may only change the forces of physicals, such as through applyForce
+	*/
 	virtual void apply(WorldPrototype* world) = 0;
+	/*
+		Forces which return true here are applied through prepareBatch and applyToBatch instead of apply
+		The world applies all batched forces together, in one pass over the physicals which is spread over its threadPool
+	*/
+	virtual bool isBatched() const { return false; }
+	/*
+		Called once per tick on one thread, before any applyToBatch of that tick
+		Like apply, it may run on a worker at the same time as the broadphase
+		For work which all ranges of the batch share, such as building a tree over the world
+	*/
+	virtual void prepareBatch(WorldPrototype*) {}
+	/*
+		Adds this force to bodies [begin, end) of batch, begin and end are multiples of ExternalForceBatch::LANES
+		May be called from several threads at once, for different ranges
+	*/
+	virtual void applyToBatch(ExternalForceBatch&, std::size_t, std::size_t) const {}
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const Part&) const = 0;
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const MotorizedPhysical& phys) const {
 		double total = 0.0;
@@ -344,6 +519,12 @@ class World : public WorldPrototype {
 public:
 	World(double deltaT) : WorldPrototype(deltaT) {}
 
+	// see WorldPrototype::createPart
+	template<typename... Args>
+	T* createPart(Args&&... args) {
+		return WorldPrototype::createPart<T>(std::forward<Args>(args)...);
+	}
+
 	template<typename Filter>
 	IteratorFactoryWithEnd<CastingIterator<FilteredWorldIterator<Filter>, T&>> iterPartsFiltered(const Filter& filter) {
 		return IteratorFactoryWithEnd<CastingIterator<FilteredWorldIterator<Filter>, T&>>(
@@ -381,7 +562,9 @@ public:
 	virtual void onPartAdded(T* part) {}
 	virtual void onPartRemoved(T* part) {}
 	virtual void deletePart(T* part) const {
-		delete part;
+		if(!this->destroyPooledPart(part)) {
+			delete part;
+		}
 	}
 	virtual void onPartAdded(Part* part) final override {
 		this->onPartAdded(static_cast<T*>(part));
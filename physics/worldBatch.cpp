@@ -0,0 +1,104 @@
+#include "worldBatch.h"
+
+#include <set>
+#include <sstream>
+
+#include "part.h"
+#include "softLink.h"
+#include "profiling.h"
+#include "geometry/builtinShapeClasses.h"
+#include "misc/serialization.h"
+
+#include "../util/threadPool.h"
+
+WorldBatch::WorldBatch(const WorldPrototype& templateWorld, std::size_t worldCount, Util::ThreadPool* threadPool) :
+	deltaT(templateWorld.deltaT),
+	threadPool(threadPool) {
+	setTemplate(templateWorld);
+	worlds.reserve(worldCount);
+	for(std::size_t i = 0; i < worldCount; i++) {
+		worlds.push_back(std::make_unique<WorldPrototype>(deltaT));
+		reset(i);
+	}
+}
+
+WorldBatch::~WorldBatch() {
+	for(std::unique_ptr<WorldPrototype>& world : worlds) {
+		deleteContents(*world);
+	}
+}
+
+void WorldBatch::setTemplate(const WorldPrototype& templateWorld) {
+	// the builtin classes are always known to the serializer, adding them again would give them a second ID
+	std::set<const ShapeClass*> shapeClasses;
+	for(const Part& part : templateWorld.iterParts()) {
+		const ShapeClass* shapeClass = part.hitbox.baseShape;
+		if(shapeClass != &CubeClass::instance && shapeClass != &SphereClass::instance && shapeClass != &CylinderClass::instance) {
+			shapeClasses.insert(shapeClass);
+		}
+	}
+	sharedShapeClasses.assign(shapeClasses.begin(), shapeClasses.end());
+
+	std::ostringstream ostream;
+	SerializationSessionPrototype session(sharedShapeClasses);
+	session.serializeWorld(templateWorld, ostream);
+	templateData = ostream.str();
+	deltaT = templateWorld.deltaT;
+}
+
+void WorldBatch::deleteContents(WorldPrototype& world) {
+	for(ExternalForce* force : world.externalForces) {
+		delete force;
+	}
+	for(SoftLink* link : world.springLinks) {
+		delete link;
+	}
+	world.springLinks.clear();
+	world.clear();
+}
+
+void WorldBatch::reset(std::size_t index) {
+	WorldPrototype& world = *worlds[index];
+	deleteContents(world);
+	world.deltaT = deltaT;
+
+	std::istringstream istream(templateData);
+	DeSerializationSessionPrototype session(sharedShapeClasses);
+	session.deserializeWorld(world, istream);
+}
+
+void WorldBatch::resetAll() {
+	for(std::size_t i = 0; i < worlds.size(); i++) {
+		reset(i);
+	}
+}
+
+void WorldBatch::tick() {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	auto tickWorld = [this](std::size_t i) {
+		ProfilingSuspension suspension;
+		worlds[i]->tick();
+	};
+	if(threadPool != nullptr) {
+		threadPool->parallelFor(worlds.size(), tickWorld);
+	} else {
+		for(std::size_t i = 0; i < worlds.size(); i++) {
+			tickWorld(i);
+		}
+	}
+
+	tickTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	worldTicks += worlds.size();
+}
+
+void WorldBatch::tick(std::size_t tickCount) {
+	for(std::size_t i = 0; i < tickCount; i++) {
+		tick();
+	}
+}
+
+double WorldBatch::getWorldTicksPerSecond() const {
+	double seconds = std::chrono::duration<double>(tickTime).count();
+	return seconds > 0.0 ? worldTicks / seconds : 0.0;
+}
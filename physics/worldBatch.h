@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "world.h"
+
+namespace Util {
+class ThreadPool;
+};
+
+class ShapeClass;
+
+/*
+	A batch of small independent worlds which are all copies of one template world, for parameter sweeps and the like
+
+	The template is serialized once, and every world is reset by deserializing it again. The ShapeClasses of the template are
+	passed to the serializer as known classes, so they are stored by reference: every world shares the template's ShapeClasses
+	and Polyhedra instead of getting its own copy, and they must outlive the batch
+
+	tick() ticks every world once, spread over the threads of the pool, one world per job
+	The worlds themselves tick serially and don't record into the global profilers while they run in parallel
+
+	The worlds own everything they deserialize, forces added to a world after a reset are deleted by the next reset or by the batch
+*/
+class WorldBatch {
+	std::vector<std::unique_ptr<WorldPrototype>> worlds;
+	std::vector<const ShapeClass*> sharedShapeClasses;
+	std::string templateData;
+	double deltaT;
+
+	std::uint64_t worldTicks = 0;
+	std::chrono::nanoseconds tickTime{0};
+
+	void deleteContents(WorldPrototype& world);
+
+public:
+	Util::ThreadPool* threadPool = nullptr;
+
+	// creates worldCount copies of templateWorld, which may be changed or destroyed afterwards, its ShapeClasses may not
+	WorldBatch(const WorldPrototype& templateWorld, std::size_t worldCount, Util::ThreadPool* threadPool = nullptr);
+	~WorldBatch();
+
+	WorldBatch(const WorldBatch&) = delete;
+	WorldBatch& operator=(const WorldBatch&) = delete;
+
+	// replaces the template, the worlds keep their state until they are reset
+	void setTemplate(const WorldPrototype& templateWorld);
+
+	// brings the world back to the state of the template, including its age
+	void reset(std::size_t index);
+	void resetAll();
+
+	// ticks every world once
+	void tick();
+	void tick(std::size_t tickCount);
+
+	inline std::size_t size() const { return worlds.size(); }
+	inline WorldPrototype& operator[](std::size_t index) { return *worlds[index]; }
+	inline const WorldPrototype& operator[](std::size_t index) const { return *worlds[index]; }
+
+	inline const std::vector<const ShapeClass*>& getSharedShapeClasses() const { return sharedShapeClasses; }
+
+	// the number of ticks of single worlds done by tick() so far, and the rate at which they were done
+	inline std::uint64_t getWorldTicks() const { return worldTicks; }
+	double getWorldTicksPerSecond() const;
+};
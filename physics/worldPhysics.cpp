@@ -9,14 +9,20 @@
 #include "debug.h"
 #include "constants.h"
 #include "physicsProfiler.h"
+#include "externalForceBatch.h"
+#include "softLinkBatch.h"
 #include "../util/log.h"
+#include "../util/threadPool.h"
+#include "../util/taskGraph.h"
 
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 /*
 	exitVector is the distance p2 must travel so that the shapes are no longer colliding
+	The global inertia caches of both mainPhysicals must be up to date, see MotorizedPhysical::refreshGlobalInertiaCache
 */
 void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector) {
 	Debug::logPoint(collisionPoint, Debug::INTERSECTION);
@@ -31,11 +37,11 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 		return; // don't do anything for very small colissions
 	}
 
-	Vec3 collissionRelP1 = collisionPoint - phys1.getCenterOfMass();
-	Vec3 collissionRelP2 = collisionPoint - phys2.getCenterOfMass();
+	Vec3 collissionRelP1 = collisionPoint - phys1.cachedCenterOfMass;
+	Vec3 collissionRelP2 = collisionPoint - phys2.cachedCenterOfMass;
 
-	double inertia1A = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
-	double inertia2A = phys2.getInertiaOfPointInDirectionRelative(collissionRelP2, exitVector);
+	double inertia1A = phys1.getCachedInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
+	double inertia2A = phys2.getCachedInertiaOfPointInDirectionRelative(collissionRelP2, exitVector);
 	double combinedInertia = 1 / (1 / inertia1A + 1 / inertia2A);
 
 	// Friction
@@ -71,8 +77,8 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 	Vec3 slidingVelocity = exitVector % relativeVelocity % exitVector / lengthSquared(exitVector);
 
 	// Compute combined inertia in the horizontal direction
-	double inertia1B = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, slidingVelocity);
-	double inertia2B = phys2.getInertiaOfPointInDirectionRelative(collissionRelP2, slidingVelocity);
+	double inertia1B = phys1.getCachedInertiaOfPointInDirectionRelative(collissionRelP1, slidingVelocity);
+	double inertia2B = phys2.getCachedInertiaOfPointInDirectionRelative(collissionRelP2, slidingVelocity);
 	double combinedHorizontalInertia = 1 / (1 / inertia1B + 1 / inertia2B);
 
 	if (isImpulseColission) {
@@ -105,6 +111,7 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 
 /*
 	exitVector is the distance p2 must travel so that the shapes are no longer colliding
+	The global inertia cache of part1's mainPhysical must be up to date
 */
 void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector) {
 	Debug::logPoint(collisionPoint, Debug::INTERSECTION);
@@ -116,9 +123,9 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 		return; // don't do anything for very small colissions
 	}
 
-	Vec3 collissionRelP1 = collisionPoint - phys1.getCenterOfMass();
+	Vec3 collissionRelP1 = collisionPoint - phys1.cachedCenterOfMass;
 
-	double inertia = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
+	double inertia = phys1.getCachedInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
 
 	// Friction
 	double staticFriction = part1.properties.friction * part2.properties.friction;
@@ -151,7 +158,7 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 	Vec3 slidingVelocity = exitVector % relativeVelocity % exitVector / lengthSquared(exitVector);
 
 	// Compute combined inertia in the horizontal direction
-	double combinedHorizontalInertia = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, slidingVelocity);
+	double combinedHorizontalInertia = phys1.getCachedInertiaOfPointInDirectionRelative(collissionRelP1, slidingVelocity);
 
 	if (isImpulseColission) {
 		Vec3 maxFrictionImpulse = -exitVector % impulse % exitVector / lengthSquared(exitVector) * staticFriction;
@@ -178,35 +185,282 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 	assert(phys1.isValid());
 }
 
+/*
+	===== Islands =====
+*/
+
+void Island::catchUpSkippedTicks(double deltaT) {
+	for(MotorizedPhysical* physical : physicals) {
+		physical->catchUpSkippedTicks(deltaT);
+	}
+}
+void Island::handleColissions() {
+	// contacts don't move the physicals, so their world-space inertia stays valid for all contacts of this tick
+	for(MotorizedPhysical* physical : physicals) {
+		physical->refreshGlobalInertiaCache();
+	}
+	for(const Colission& c : freePartColissions) {
+		handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	}
+	for(const Colission& c : freeTerrainColissions) {
+		handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	}
+}
+void Island::handleConstraints(TickArena& arena) {
+	for(const ConstraintGroup* group : constraints) {
+		group->apply(arena);
+	}
+}
+void Island::updateSpringLinks(const SoftLinkBatch& batch) {
+	for(SoftLink* springLink : springLinks) {
+		if(springLink->isBatched()) {
+			batch.scatter(springLink->indexInWorld, *springLink);
+		} else {
+			springLink->update();
+		}
+	}
+}
+
+/*
+	Calls func for every island, largest first if there is a threadPool
+	Islands which aren't due this tick are skipped unless includeNotDue is set
+*/
+template<typename Func>
+static void forEachIsland(IslandSet& islands, Util::ThreadPool* threadPool, const Func& func, bool includeNotDue = false) {
+	if(threadPool != nullptr && islands.size() > 1) {
+		const std::vector<std::size_t>& order = islands.getScheduleOrder();
+		threadPool->parallelFor(order.size(), [&islands, &order, &func, includeNotDue](std::size_t i) {
+			Island& island = islands[order[i]];
+			if(includeNotDue || island.isDue) func(island);
+		});
+	} else {
+		for(std::size_t i = 0; i < islands.size(); i++) {
+			if(includeNotDue || islands[i].isDue) func(islands[i]);
+		}
+	}
+}
+
+// number of items per task for world-wide passes over the physicals or links, a multiple of BATCH_LANES
+static constexpr std::size_t PHYSICALS_CHUNK_SIZE = 256;
+
+static std::size_t getChunkCount(std::size_t count) {
+	return (count + PHYSICALS_CHUNK_SIZE - 1) / PHYSICALS_CHUNK_SIZE;
+}
+static std::size_t getChunkBegin(std::size_t chunk) {
+	return chunk * PHYSICALS_CHUNK_SIZE;
+}
+static std::size_t getChunkEnd(std::size_t chunk, std::size_t count) {
+	return std::min(getChunkBegin(chunk) + PHYSICALS_CHUNK_SIZE, count);
+}
+
+/*
+	Calls func(begin, end) for consecutive ranges of PHYSICALS_CHUNK_SIZE covering [0, count), spread over threadPool if there is one
+*/
+template<typename Func>
+static void forEachChunk(Util::ThreadPool* threadPool, std::size_t count, const Func& func) {
+	std::size_t chunkCount = getChunkCount(count);
+	auto runChunk = [count, &func](std::size_t chunk) {
+		func(getChunkBegin(chunk), getChunkEnd(chunk, count));
+	};
+	if(threadPool != nullptr) {
+		threadPool->parallelFor(chunkCount, runChunk);
+	} else {
+		for(std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+			runChunk(chunk);
+		}
+	}
+}
+
+/*
+	Applies the accumulated forces and moments of physicals [begin, end) and moves them
+
+	Physicals don't depend on each other here, so this is balanced over physicals rather than islands
+	Moving a physical doesn't touch the layers, their BoundsTrees are brought up to date afterwards by refreshTrees
+
+	Physicals of islands which aren't due drop their forces and stay where they are
+	Due physicals caught up on their skipped ticks before the contacts, so every physical takes a step of deltaT here
+*/
+static void updatePhysicalsChunk(WorldPrototype& world, std::size_t begin, std::size_t end) {
+	std::vector<MotorizedPhysical*>& physicals = world.physicals;
+	const IslandSet& islands = world.islands;
+	double deltaT = world.deltaT;
+
+	for(std::size_t i = begin; i < end; i++) {
+		MotorizedPhysical& phys = *physicals[i];
+		if(islands.isPhysicalDue(i)) {
+			// does nothing unless the contacts of this tick were skipped
+			phys.catchUpSkippedTicks(deltaT);
+			phys.update(deltaT);
+		} else {
+			phys.totalForce = Vec3();
+			phys.totalMoment = Vec3();
+			phys.skippedTicks++;
+			phys.previousCFrame = phys.getCFrame();
+		}
+	}
+}
+
+// updates all physicals in chunks spread over the thread pool
+static void updatePhysicals(WorldPrototype& world) {
+	forEachChunk(world.threadPool, world.physicals.size(), [&world](std::size_t begin, std::size_t end) {
+		updatePhysicalsChunk(world, begin, end);
+	});
+}
+
+// gathers rows [begin, end) of the batch from the SoftLinks of the world and computes their forces, end may include the padding rows
+static void computeSoftLinkChunk(WorldPrototype& world, SoftLinkBatch& batch, std::size_t begin, std::size_t end) {
+	const std::vector<SoftLink*>& links = world.springLinks;
+	std::size_t linksEnd = std::min(end, batch.count);
+	for(std::size_t i = begin; i < linksEnd; i++) {
+		if(links[i]->isBatched()) {
+			links[i]->gatherInto(batch, i);
+		} else {
+			batch.disable(i);
+		}
+	}
+	batch.computeForces(begin, end);
+}
+
+/*
+	Computes the forces of all batched SoftLinks in chunks spread over the thread pool, then lets every island apply the forces of its links
+	Islands apply them in the order of their links, so the result doesn't depend on the number of threads
+*/
+static void updateSoftLinks(WorldPrototype& world, IslandSet& islands) {
+	SoftLinkBatch& batch = world.softLinkBatch;
+	batch.allocate(world.tickArena, world.springLinks.size());
+
+	forEachChunk(world.threadPool, batch.paddedCount, [&world, &batch](std::size_t begin, std::size_t end) {
+		computeSoftLinkChunk(world, batch, begin, end);
+	});
+
+	// these forces are used by the next tick, in which islands skipped now may be due
+	forEachIsland(islands, world.threadPool, [&batch](Island& island) {
+		island.updateSpringLinks(batch);
+	}, true);
+}
+
+/*
+	Gathers bodies [begin, end) of the world's externalForceBatch, adds every batched ExternalForce to them while they are in cache,
+	and adds the sum to the totalForce of their physicals, end may include the padding bodies
+*/
+static void applyBatchedExternalForcesChunk(WorldPrototype& world, std::size_t begin, std::size_t end) {
+	ExternalForceBatch& batch = world.externalForceBatch;
+	std::size_t physicalsEnd = std::min(end, batch.count);
+	for(std::size_t i = begin; i < physicalsEnd; i++) {
+		batch.gather(i, *batch.physicals[i]);
+	}
+	for(const ExternalForce* force : world.externalForces) {
+		if(force->isBatched()) {
+			force->applyToBatch(batch, begin, end);
+		}
+	}
+	for(std::size_t i = begin; i < physicalsEnd; i++) {
+		batch.scatter(i, *batch.physicals[i]);
+	}
+}
+
+// sizes the world's externalForceBatch for all physicals, or to nothing when no force is batched
+static void allocateExternalForceBatch(WorldPrototype& world) {
+	bool hasBatchedForces = false;
+	for(const ExternalForce* force : world.externalForces) {
+		if(force->isBatched()) hasBatchedForces = true;
+	}
+	world.externalForceBatch.allocate(world.tickArena, world.physicals.data(), hasBatchedForces ? world.physicals.size() : 0);
+}
+
 /*
 	===== World Tick =====
 */
 
+/*
+	The BoundsTrees are refreshed in pieces which don't depend on each other:
+	every branch of the root of the free parts of every layer, followed by the trees of every active region
+	The roots of the layers only combine their branches, they are refreshed after all pieces, see BoundsTree::refreshBranch
+*/
+static std::size_t getTreePieceCount(const WorldPrototype& world) {
+	return world.layers.size() * MAX_BRANCHES + world.regions.getActiveRegionCount();
+}
+static void refreshTreePiece(WorldPrototype& world, std::size_t piece) {
+	std::size_t layerPieces = world.layers.size() * MAX_BRANCHES;
+	if(piece < layerPieces) {
+		world.layers[piece / MAX_BRANCHES].subLayers[ColissionLayer::FREE_PARTS_LAYER].refreshBranch(static_cast<int>(piece % MAX_BRANCHES));
+	} else {
+		world.regions.refreshTrees(piece - layerPieces);
+	}
+}
+static void refreshTreeRoots(WorldPrototype& world) {
+	for(ColissionLayer& layer : world.layers) {
+		layer.subLayers[ColissionLayer::FREE_PARTS_LAYER].refreshRoot();
+	}
+}
+
+// feeds the timing of the tasks of the last tick into tickTaskMeasure, on the calling thread
+static void recordTickGraphProfile(const std::vector<Util::TaskGraph::TaskProfile>& profile) {
+	for(std::size_t i = 0; i < profile.size(); i++) {
+		TickTask task = static_cast<TickTask>(i);
+		if(profile[i].end > profile[i].start) {
+			tickTaskMeasure.addToTally(task, profile[i].end - profile[i].start);
+		}
+		tickTaskItemCounts.addToTally(task, static_cast<long long>(profile[i].count));
+	}
+	tickTaskMeasure.nextTally();
+	tickTaskItemCounts.nextTally();
+}
+
 void WorldPrototype::tick() {
-	
+	tickArena.reset();
+
+	if(threadPool != nullptr) {
+		if(tickGraph == nullptr) {
+			tickGraph = std::make_unique<Util::TaskGraph>();
+			buildTickGraph(*tickGraph);
+		}
+		tickGraph->run(threadPool);
+		recordTickGraphProfile(tickGraph->getProfile());
+		return;
+	}
+
 	findColissions();
 
 	physicsMeasure.mark(PhysicsProcess::EXTERNALS);
 	applyExternalForces();
+	applyBatchedExternalForces();
 
-	handleColissions();
+	buildIslands();
 
 	intersectionStatistics.nextTally();
-	
-	handleConstraints();
 
-	update();
+	stepIslands();
 }
 
 void WorldPrototype::applyExternalForces() {
 	for (ExternalForce* force : externalForces) {
-		force->apply(this);
+		if (force->isBatched()) {
+			force->prepareBatch(this);
+		} else {
+			force->apply(this);
+		}
 	}
 }
 
+void WorldPrototype::applyBatchedExternalForces() {
+	allocateExternalForceBatch(*this);
+	forEachChunk(threadPool, externalForceBatch.paddedCount, [this](std::size_t begin, std::size_t end) {
+		applyBatchedExternalForcesChunk(*this, begin, end);
+	});
+}
+
 void WorldPrototype::findColissions() {
 	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 
+	if(regions.prepare(*this)) {
+		regions.findAllColissions(*this, curColissions);
+		return;
+	}
+	findLayerColissions();
+}
+
+void WorldPrototype::findLayerColissions() {
 	curColissions.clear();
 
 	for(const ColissionLayer& layer : layers) {
@@ -218,40 +472,295 @@ void WorldPrototype::findColissions() {
 		getColissionsBetween(layers[collidingLayers.first], layers[collidingLayers.second], curColissions);
 	}
 }
+void WorldPrototype::buildIslands(bool includeColissions) {
+	physicsMeasure.mark(PhysicsProcess::ISLAND_BUILDING);
+	islands.build(*this, includeColissions);
+	islandsAreBuilt = true;
+}
+void WorldPrototype::ensureIslandsBuilt() {
+	if(!islandsAreBuilt) {
+		buildIslands();
+	}
+}
 void WorldPrototype::handleColissions() {
+	ensureIslandsBuilt();
 	physicsMeasure.mark(PhysicsProcess::COLISSION_HANDLING);
-	for (Colission c : curColissions.freePartColissions) {
-		handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
-	}
-	for (Colission c : curColissions.freeTerrainColissions) {
-		handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
-	}
+	double deltaT = this->deltaT;
+	forEachIsland(islands, threadPool, [deltaT](Island& island) {
+		island.catchUpSkippedTicks(deltaT);
+		island.handleColissions();
+	});
 }
 void WorldPrototype::handleConstraints() {
+	ensureIslandsBuilt();
 	physicsMeasure.mark(PhysicsProcess::CONSTRAINTS);
-	for (const ConstraintGroup& group : constraints) {
-		group.apply();
-	}
+	TickArena& arena = this->tickArena;
+	forEachIsland(islands, threadPool, [&arena](Island& island) {
+		island.handleConstraints(arena);
+	});
 }
 void WorldPrototype::update() {
+	ensureIslandsBuilt();
 	physicsMeasure.mark(PhysicsProcess::UPDATING);
-	for (MotorizedPhysical* physical : iterPhysicals()) {
-		physical->update(this->deltaT);
-	}
+	updatePhysicals(*this);
+	updateSoftLinks(*this, islands);
+
+	refreshTrees();
+	finishUpdate();
+}
+void WorldPrototype::stepIslands() {
+	ensureIslandsBuilt();
+	physicsMeasure.mark(PhysicsProcess::ISLAND_STEPPING);
+	TickArena& arena = this->tickArena;
+	double deltaT = this->deltaT;
+	forEachIsland(islands, threadPool, [&arena, deltaT](Island& island) {
+		island.catchUpSkippedTicks(deltaT);
+		island.handleColissions();
+		island.handleConstraints(arena);
+	});
+	physicsMeasure.mark(PhysicsProcess::UPDATING);
+	updatePhysicals(*this);
+	updateSoftLinks(*this, islands);
 
-	for(ColissionLayer& layer : layers) {
-		layer.refresh();
+	refreshTrees();
+	finishUpdate();
+}
+void WorldPrototype::refreshTrees() {
+	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_BOUNDS);
+	std::size_t pieceCount = getTreePieceCount(*this);
+	if(threadPool != nullptr) {
+		threadPool->parallelFor(pieceCount, [this](std::size_t piece) {
+			refreshTreePiece(*this, piece);
+		});
+	} else {
+		for(std::size_t piece = 0; piece < pieceCount; piece++) {
+			refreshTreePiece(*this, piece);
+		}
 	}
+	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
+	refreshTreeRoots(*this);
+}
+/*
+	The same stages as tick, as a TaskGraph:
+
+	broadphase --> region migration --> region trees --> region colissions --> merge --> islands --> contacts and constraints --> update physicals --> soft link forces --> apply soft links --> finish
+	external forces ---------------------------------------------------------------------------------------^
+	                                                                                                                                             \--> refresh trees -----------------------------^
+
+	External forces don't touch the layers, so they overlap the broadphase and the building of the islands
+	With WorldRegions the broadphase only prepares the regions, the three region stages are one task per region, see WorldRegions
+	Without regions these stages have no tasks, and the broadphase does all of the colission detection
+	The stages after it are split into one task per island or per chunk of physicals or links, as in stepIslands
+	Refreshing the trees only reads the parts, so it overlaps the soft links, see refreshTrees
+
+	The broadphase, merging, building the islands and finishing the tick use the profiler and the layers, these run on the calling thread
+	Only tasks on the calling thread mark physicsMeasure, the timing of every task goes from the profile of the graph into tickTaskMeasure
+*/
+void WorldPrototype::buildTickGraph(Util::TaskGraph& graph) {
+	using TaskID = Util::TaskGraph::TaskID;
+
+	TaskID broadphase = graph.addTask("Broadphase", [this]() {
+		physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
+		if(!regions.prepare(*this)) {
+			findLayerColissions();
+		}
+	}, true);
+	TaskID externals = graph.addTask("Externals", [this]() {
+		applyExternalForces();
+		allocateExternalForceBatch(*this);
+	});
+	TaskID batchedExternals = graph.addParallelTask("Batched externals", [this]() {
+		return getChunkCount(externalForceBatch.paddedCount);
+	}, [this](std::size_t chunk) {
+		applyBatchedExternalForcesChunk(*this, getChunkBegin(chunk), getChunkEnd(chunk, externalForceBatch.paddedCount));
+	});
+	TaskID regionMigration = graph.addParallelTask("Region migration", [this]() {
+		return regions.getActiveRegionCount();
+	}, [this](std::size_t i) {
+		regions.migrate(i);
+	});
+	TaskID regionTrees = graph.addParallelTask("Region trees", [this]() {
+		return regions.getActiveRegionCount();
+	}, [this](std::size_t i) {
+		regions.updateTrees(i);
+	});
+	TaskID regionColissions = graph.addParallelTask("Region colissions", [this]() {
+		return regions.getActiveRegionCount();
+	}, [this](std::size_t i) {
+		regions.findColissions(*this, i);
+	});
+	TaskID mergeColissions = graph.addTask("Merge colissions", [this]() {
+		if(regions.getActiveRegionCount() != 0) {
+			regions.mergeColissions(curColissions);
+		}
+	}, true);
+	TaskID islandBuilding = graph.addTask("Islands", [this]() {
+		buildIslands();
+		intersectionStatistics.nextTally();
+		softLinkBatch.allocate(tickArena, springLinks.size());
+		physicsMeasure.mark(PhysicsProcess::ISLAND_STEPPING);
+	}, true);
+	TaskID contacts = graph.addParallelTask("Contacts and constraints", [this]() {
+		return islands.size();
+	}, [this](std::size_t i) {
+		Island& island = islands[islands.getScheduleOrder()[i]];
+		if(island.isDue) {
+			island.catchUpSkippedTicks(deltaT);
+			island.handleColissions();
+			island.handleConstraints(tickArena);
+		}
+	});
+	TaskID update = graph.addParallelTask("Update physicals", [this]() {
+		return getChunkCount(physicals.size());
+	}, [this](std::size_t chunk) {
+		updatePhysicalsChunk(*this, getChunkBegin(chunk), getChunkEnd(chunk, physicals.size()));
+	});
+	TaskID linkForces = graph.addParallelTask("Soft link forces", [this]() {
+		return getChunkCount(softLinkBatch.paddedCount);
+	}, [this](std::size_t chunk) {
+		computeSoftLinkChunk(*this, softLinkBatch, getChunkBegin(chunk), getChunkEnd(chunk, softLinkBatch.paddedCount));
+	});
+	// islands which aren't due get their link forces too, they are used by the next tick
+	TaskID applyLinks = graph.addParallelTask("Apply soft links", [this]() {
+		return islands.size();
+	}, [this](std::size_t i) {
+		islands[islands.getScheduleOrder()[i]].updateSpringLinks(softLinkBatch);
+	});
+	TaskID treeRefresh = graph.addParallelTask("Refresh trees", [this]() {
+		return getTreePieceCount(*this);
+	}, [this](std::size_t piece) {
+		refreshTreePiece(*this, piece);
+	});
+	TaskID finish = graph.addTask("Finish", [this]() {
+		physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
+		refreshTreeRoots(*this);
+		finishUpdate();
+	}, true);
+
+	assert(graph.size() == static_cast<std::size_t>(TickTask::COUNT));
+
+	graph.addDependency(broadphase, regionMigration);
+	graph.addDependency(regionMigration, regionTrees);
+	graph.addDependency(regionTrees, regionColissions);
+	graph.addDependency(regionColissions, mergeColissions);
+	graph.addDependency(mergeColissions, islandBuilding);
+	graph.addDependency(externals, batchedExternals);
+	graph.addDependency(batchedExternals, contacts);
+	graph.addDependency(islandBuilding, contacts);
+	graph.addDependency(contacts, update);
+	graph.addDependency(update, linkForces);
+	graph.addDependency(linkForces, applyLinks);
+	graph.addDependency(applyLinks, finish);
+	graph.addDependency(update, treeRefresh);
+	graph.addDependency(treeRefresh, finish);
+}
+
+void WorldPrototype::finishUpdate() {
 	age++;
 
-	for (SoftLink* springLink : springLinks) {
-		springLink->update();
+	islands.clear();
+	islandsAreBuilt = false;
+
+	if(spatialReorderInterval != 0 && age % spatialReorderInterval == 0) {
+		physicsMeasure.mark(PhysicsProcess::SPATIAL_REORDER);
+		reorderPhysicalsSpatially();
+	}
+}
+
+// spreads the lower 21 bits of value over every third bit
+static uint64_t spreadBits(uint64_t value) {
+	value &= 0x1FFFFF;
+	value = (value | value << 32) & 0x1F00000000FFFF;
+	value = (value | value << 16) & 0x1F0000FF0000FF;
+	value = (value | value << 8) & 0x100F00F00F00F00F;
+	value = (value | value << 4) & 0x10C30C30C30C30C3;
+	value = (value | value << 2) & 0x1249249249249249;
+	return value;
+}
+// coordinate scaled from min..max to 21 bits, physicals which flew off to NaN get 0
+static uint64_t quantize(double coordinate, double min, double max) {
+	double fraction = (coordinate - min) / (max - min);
+	if(!(fraction > 0.0)) return 0;
+	if(fraction > 1.0) fraction = 1.0;
+	return static_cast<uint64_t>(fraction * 0x1FFFFF);
+}
+
+void WorldPrototype::reorderPhysicalsSpatially() {
+	if(physicals.size() < 2) return;
+
+	double min[3]{std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+	double max[3]{-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+	for(const MotorizedPhysical* phys : physicals) {
+		Position position = phys->getMainPart()->getPosition();
+		double coordinates[3]{double(position.x), double(position.y), double(position.z)};
+		for(int i = 0; i < 3; i++) {
+			min[i] = std::min(min[i], coordinates[i]);
+			max[i] = std::max(max[i], coordinates[i]);
+		}
 	}
 
+	std::vector<std::pair<uint64_t, MotorizedPhysical*>> keyed;
+	keyed.reserve(physicals.size());
+	for(MotorizedPhysical* phys : physicals) {
+		Position position = phys->getMainPart()->getPosition();
+		uint64_t mortonCode = spreadBits(quantize(double(position.x), min[0], max[0]))
+			| spreadBits(quantize(double(position.y), min[1], max[1])) << 1
+			| spreadBits(quantize(double(position.z), min[2], max[2])) << 2;
+		keyed.emplace_back(mortonCode, phys);
+	}
+	// stable, so physicals at the same spot keep their order and the result only depends on the state of the world
+	std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<uint64_t, MotorizedPhysical*>& a, const std::pair<uint64_t, MotorizedPhysical*>& b) {
+		return a.first < b.first;
+	});
+	for(std::size_t i = 0; i < keyed.size(); i++) {
+		physicals[i] = keyed[i].second;
+	}
 }
 
 
 
+// FNV-1a
+static void hashBytes(uint64_t& hash, const void* data, std::size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for(std::size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
+template<typename T>
+static void hashValue(uint64_t& hash, const T& value) {
+	hashBytes(hash, &value, sizeof(T));
+}
+static void hashVec3(uint64_t& hash, const Vec3& vec) {
+	hashValue(hash, vec.x);
+	hashValue(hash, vec.y);
+	hashValue(hash, vec.z);
+}
+static void hashCFrame(uint64_t& hash, const GlobalCFrame& cframe) {
+	hashValue(hash, cframe.position.x.value);
+	hashValue(hash, cframe.position.y.value);
+	hashValue(hash, cframe.position.z.value);
+	Mat3 rotation = cframe.getRotation().asRotationMatrix();
+	for(int row = 0; row < 3; row++) {
+		for(int col = 0; col < 3; col++) {
+			hashValue(hash, rotation(row, col));
+		}
+	}
+}
+
+uint64_t WorldPrototype::getStateHash() const {
+	uint64_t hash = 14695981039346656037ULL;
+	hashValue(hash, age);
+	for(const MotorizedPhysical* phys : physicals) {
+		hashVec3(hash, phys->motionOfCenterOfMass.getVelocity());
+		hashVec3(hash, phys->motionOfCenterOfMass.getAngularVelocity());
+		phys->forEachPart([&hash](const Part& part) {
+			hashCFrame(hash, part.getCFrame());
+		});
+	}
+	return hash;
+}
+
 double WorldPrototype::getTotalKineticEnergy() const {
 	double total = 0.0;
 	for(const MotorizedPhysical* p : iterPhysicals()) {
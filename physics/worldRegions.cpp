@@ -0,0 +1,425 @@
+#include "worldRegions.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "world.h"
+#include "layer.h"
+#include "part.h"
+#include "physical.h"
+#include "profiling.h"
+
+static double getCoordinate(const Position& position, int axis) {
+	switch(axis) {
+	case 0: return double(position.x);
+	case 1: return double(position.y);
+	default: return double(position.z);
+	}
+}
+
+static TreeNode createGroupNodeFor(MotorizedPhysical* physical, Part* representative) {
+	TreeNode group(representative, representative->getBounds(), true);
+	physical->forEachPart([&group, representative](Part& part) {
+		if(&part != representative && part.layer == representative->layer) {
+			group.addInside(TreeNode(&part, part.getBounds(), false));
+		}
+	});
+	return group;
+}
+
+static TreeNode grabGroup(BoundsTree<Part>& tree, const Part* partOfGroup, const Bounds& bounds) {
+	// the root is only a group head if the tree holds nothing but this group, grabGroupFor can't take out the root
+	if(tree.rootNode.isGroupHead) {
+		TreeNode group(std::move(tree.rootNode));
+		tree.clear();
+		return group;
+	}
+	return tree.grabGroupFor(partOfGroup, bounds);
+}
+static TreeNode grabGroup(BoundsTree<Part>& tree, const Part* representative) {
+	return grabGroup(tree, representative, representative->getBounds());
+}
+
+// searches the way the trees do, through the nodes containing the bounds, so the object can be grabbed or updated with these bounds if found
+static bool holdsObject(const TreeNode& node, const void* object, const Bounds& bounds) {
+	if(node.isLeafNode()) {
+		return node.object == object;
+	}
+	for(const TreeNode& subNode : node) {
+		if(subNode.bounds.contains(bounds) && holdsObject(subNode, object, bounds)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void findColissionsBetweenTrees(const BoundsTree<Part>& first, const BoundsTree<Part>& second, std::vector<Colission>& colissions) {
+	if(!first.isEmpty() && !second.isEmpty()) {
+		findColissionsBetween(first.rootNode, second.rootNode, colissions);
+	}
+}
+
+static double getReachBelow(const MotorizedPhysical* physical, int axis) {
+	double coordinate = getCoordinate(physical->getMainPart()->getPosition(), axis);
+	double reach = 0.0;
+	physical->forEachPart([&reach, coordinate, axis](const Part& part) {
+		double partReach = coordinate - getCoordinate(part.getBounds().min, axis);
+		if(partReach > reach) reach = partReach;
+	});
+	return reach;
+}
+
+// the largest coordinate along axis of the parts in the trees, -infinity if they are empty
+static double getUpperExtent(const std::vector<BoundsTree<Part>>& trees, int axis) {
+	double upperExtent = -std::numeric_limits<double>::infinity();
+	for(const BoundsTree<Part>& tree : trees) {
+		if(!tree.isEmpty()) {
+			upperExtent = std::max(upperExtent, getCoordinate(tree.rootNode.bounds.max, axis));
+		}
+	}
+	return upperExtent;
+}
+
+std::size_t WorldRegions::getRegionOf(const MotorizedPhysical* physical) const {
+	double coordinate = getCoordinate(physical->getMainPart()->getPosition(), axis);
+	return std::upper_bound(borders.begin(), borders.end(), coordinate) - borders.begin();
+}
+
+bool WorldRegions::needsRebuild(const WorldPrototype& world) const {
+	if(invalidated || regions.size() != regionCount || builtLayerCount != world.layers.size()) {
+		return true;
+	}
+	// physicals pile up in one region when they all move the same way, move the borders once a region holds more than twice its share
+	std::size_t largestRegion = 0;
+	for(const Region& region : regions) {
+		largestRegion = std::max(largestRegion, region.members.size());
+	}
+	std::size_t totalMembers = 0;
+	for(const Region& region : regions) {
+		totalMembers += region.members.size();
+	}
+	return largestRegion > 2 * totalMembers / regions.size() + 8;
+}
+
+void WorldRegions::rebuild(WorldPrototype& world) {
+	axis = 0;
+	if(!world.physicals.empty()) {
+		Position first = world.physicals[0]->getMainPart()->getPosition();
+		double minCoordinates[3]{double(first.x), double(first.y), double(first.z)};
+		double maxCoordinates[3]{double(first.x), double(first.y), double(first.z)};
+		for(const MotorizedPhysical* physical : world.physicals) {
+			Position position = physical->getMainPart()->getPosition();
+			for(int i = 0; i < 3; i++) {
+				double coordinate = getCoordinate(position, i);
+				minCoordinates[i] = std::min(minCoordinates[i], coordinate);
+				maxCoordinates[i] = std::max(maxCoordinates[i], coordinate);
+			}
+		}
+		for(int i = 1; i < 3; i++) {
+			if(maxCoordinates[i] - minCoordinates[i] > maxCoordinates[axis] - minCoordinates[axis]) {
+				axis = i;
+			}
+		}
+	}
+
+	// borders at the quantiles of the physicals, so every region starts with an equal share
+	std::vector<double> coordinates;
+	coordinates.reserve(world.physicals.size());
+	for(const MotorizedPhysical* physical : world.physicals) {
+		coordinates.push_back(getCoordinate(physical->getMainPart()->getPosition(), axis));
+	}
+	std::sort(coordinates.begin(), coordinates.end());
+	borders.assign(regionCount - 1, 0.0);
+	if(!coordinates.empty()) {
+		for(std::size_t i = 0; i < borders.size(); i++) {
+			borders[i] = coordinates[(i + 1) * coordinates.size() / regionCount];
+		}
+	}
+
+	regions.clear();
+	regions.resize(regionCount);
+	for(Region& region : regions) {
+		region.trees.resize(world.layers.size());
+	}
+	for(MotorizedPhysical* physical : world.physicals) {
+		Region& region = regions[getRegionOf(physical)];
+		for(const FoundLayerRepresentative& found : findAllLayersIn(physical)) {
+			int layerIndex = found.layer->parent->getID();
+			region.trees[layerIndex].add(createGroupNodeFor(physical, found.part));
+			region.members.push_back(Member{physical, found.part, layerIndex});
+		}
+	}
+	for(Region& region : regions) {
+		for(BoundsTree<Part>& tree : region.trees) {
+			tree.maxImproveStructure();
+		}
+	}
+
+	builtLayerCount = world.layers.size();
+	invalidated = false;
+	pendingGroups.clear();
+	removedParts.clear();
+	removedPhysicals.clear();
+	rebuildCount++;
+}
+
+/*
+	Drops the members of removed groups and adds the pending groups to their regions
+	The groups of removed parts are already out of the trees, a removed physical of which a group is still in the trees invalidates the regions,
+	as does a pending group for a physical and layer which already has one
+*/
+void WorldRegions::applyChanges() {
+	std::sort(removedParts.begin(), removedParts.end());
+	std::sort(removedPhysicals.begin(), removedPhysicals.end());
+	std::vector<std::pair<const MotorizedPhysical*, int>> groups;
+	for(Region& region : regions) {
+		for(std::size_t i = 0; i < region.members.size();) {
+			Member& member = region.members[i];
+			if(std::binary_search(removedParts.begin(), removedParts.end(), member.representative)) {
+				member = region.members.back();
+				region.members.pop_back();
+			} else {
+				if(std::binary_search(removedPhysicals.begin(), removedPhysicals.end(), member.physical)) {
+					invalidated = true;
+					return;
+				}
+				if(!pendingGroups.empty()) {
+					groups.emplace_back(member.physical, member.layerIndex);
+				}
+				i++;
+			}
+		}
+	}
+	removedParts.clear();
+	removedPhysicals.clear();
+	if(pendingGroups.empty()) return;
+
+	for(const PendingGroup& pending : pendingGroups) {
+		groups.emplace_back(pending.partOfGroup->parent->mainPhysical, pending.layerIndex);
+	}
+	std::sort(groups.begin(), groups.end());
+	if(std::adjacent_find(groups.begin(), groups.end()) != groups.end()) {
+		invalidated = true;
+		return;
+	}
+	for(const PendingGroup& pending : pendingGroups) {
+		MotorizedPhysical* physical = pending.partOfGroup->parent->mainPhysical;
+		Region& region = regions[getRegionOf(physical)];
+		region.trees[pending.layerIndex].add(createGroupNodeFor(physical, pending.partOfGroup));
+		region.members.push_back(Member{physical, pending.partOfGroup, pending.layerIndex});
+	}
+	pendingGroups.clear();
+}
+
+bool WorldRegions::isFollowingChanges() const {
+	return !regions.empty() && !invalidated;
+}
+
+BoundsTree<Part>* WorldRegions::findTreeHolding(const Part* part, const Bounds& bounds, int layerIndex) {
+	for(Region& region : regions) {
+		BoundsTree<Part>& tree = region.trees[layerIndex];
+		if(!tree.isEmpty() && holdsObject(tree.rootNode, part, bounds)) {
+			return &tree;
+		}
+	}
+	return nullptr;
+}
+
+bool WorldRegions::isPending(const Part* part, int layerIndex) const {
+	for(const PendingGroup& pending : pendingGroups) {
+		if(pending.partOfGroup == part) return true;
+		if(pending.layerIndex == layerIndex && part->parent != nullptr && pending.partOfGroup->parent->mainPhysical == part->parent->mainPhysical) return true;
+	}
+	return false;
+}
+
+void WorldRegions::invalidate() {
+	invalidated = true;
+	pendingGroups.clear();
+	removedParts.clear();
+	removedPhysicals.clear();
+}
+
+void WorldRegions::notifyGroupAdded(Part* partOfGroup, int layerIndex) {
+	if(!isFollowingChanges()) return;
+	if(partOfGroup->parent == nullptr || layerIndex >= static_cast<int>(builtLayerCount)) {
+		invalidate();
+		return;
+	}
+	pendingGroups.push_back(PendingGroup{partOfGroup, layerIndex});
+}
+
+void WorldRegions::notifyPartRemoved(const Part* part, int layerIndex) {
+	if(!isFollowingChanges()) return;
+	Bounds bounds = part->getBounds();
+	if(BoundsTree<Part>* tree = findTreeHolding(part, bounds, layerIndex)) {
+		TreeNode group = grabGroup(*tree, part, bounds);
+		// only a group of just this part leaves the member behind, the others lose a part of their group
+		if(group.isLeafNode() && group.object == part) {
+			removedParts.push_back(part);
+		} else {
+			invalidate();
+		}
+		return;
+	}
+	for(std::size_t i = 0; i < pendingGroups.size(); i++) {
+		if(pendingGroups[i].partOfGroup == part) {
+			pendingGroups.erase(pendingGroups.begin() + i);
+			return;
+		}
+	}
+	invalidate();
+}
+
+void WorldRegions::notifyPartBoundsUpdated(const Part* part, const Bounds& oldBounds, int layerIndex) {
+	if(!isFollowingChanges()) return;
+	if(BoundsTree<Part>* tree = findTreeHolding(part, oldBounds, layerIndex)) {
+		tree->updateObjectBounds(part, oldBounds);
+	} else if(!isPending(part, layerIndex)) {
+		invalidate();
+	}
+}
+
+void WorldRegions::notifyGroupBoundsUpdated(const Part* partOfGroup, const Bounds& oldBounds, int layerIndex) {
+	if(!isFollowingChanges()) return;
+	if(BoundsTree<Part>* tree = findTreeHolding(partOfGroup, oldBounds, layerIndex)) {
+		tree->updateObjectGroupBounds(partOfGroup, oldBounds);
+	} else if(!isPending(partOfGroup, layerIndex)) {
+		invalidate();
+	}
+}
+
+void WorldRegions::notifyPhysicalRemoved(const MotorizedPhysical* physical) {
+	if(!isFollowingChanges()) return;
+	removedPhysicals.push_back(physical);
+}
+
+bool WorldRegions::prepare(WorldPrototype& world) {
+	if(regionCount <= 1) {
+		if(!regions.empty()) {
+			regions.clear();
+			borders.clear();
+		}
+		active = false;
+		return false;
+	}
+	if(isFollowingChanges()) {
+		applyChanges();
+	}
+	if(needsRebuild(world)) {
+		rebuild(world);
+	}
+	active = true;
+	return true;
+}
+
+void WorldRegions::migrate(std::size_t regionIndex) {
+	Region& region = regions[regionIndex];
+	region.outbox.clear();
+	region.reachBelow = 0.0;
+	for(std::size_t i = 0; i < region.members.size();) {
+		Member& member = region.members[i];
+		region.reachBelow = std::max(region.reachBelow, getReachBelow(member.physical, axis));
+		std::size_t targetRegion = getRegionOf(member.physical);
+		if(targetRegion != regionIndex) {
+			region.outbox.push_back(Migrant{grabGroup(region.trees[member.layerIndex], member.representative), member, targetRegion});
+			member = region.members.back();
+			region.members.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+void WorldRegions::updateTrees(std::size_t regionIndex) {
+	Region& region = regions[regionIndex];
+	// sources in region order, so the trees are built the same way no matter which region finished migrating first
+	for(Region& source : regions) {
+		for(Migrant& migrant : source.outbox) {
+			if(migrant.targetRegion == regionIndex) {
+				region.trees[migrant.member.layerIndex].add(std::move(migrant.group));
+				region.members.push_back(migrant.member);
+			}
+		}
+	}
+	for(BoundsTree<Part>& tree : region.trees) {
+		tree.improveStructure();
+	}
+}
+
+void WorldRegions::findColissions(const WorldPrototype& world, std::size_t regionIndex) {
+	ProfilingSuspension suspension;
+
+	Region& region = regions[regionIndex];
+	region.colissions.clear();
+	std::vector<Colission>& freePartColissions = region.colissions.freePartColissions;
+	std::vector<Colission>& freeTerrainColissions = region.colissions.freeTerrainColissions;
+
+	for(std::size_t i = 0; i < world.layers.size(); i++) {
+		const ColissionLayer& layer = world.layers[i];
+		if(layer.collidesInternally) {
+			if(!region.trees[i].isEmpty()) {
+				findColissionsInternal(region.trees[i].rootNode, freePartColissions);
+			}
+			findColissionsBetweenTrees(region.trees[i], layer.subLayers[ColissionLayer::TERRAIN_PARTS_LAYER].tree, freeTerrainColissions);
+		}
+	}
+	for(std::pair<int, int> collidingLayers : world.colissionMask) {
+		const BoundsTree<Part>& first = region.trees[collidingLayers.first];
+		const BoundsTree<Part>& second = region.trees[collidingLayers.second];
+		findColissionsBetweenTrees(first, second, freePartColissions);
+		findColissionsBetweenTrees(first, world.layers[collidingLayers.second].subLayers[ColissionLayer::TERRAIN_PARTS_LAYER].tree, freeTerrainColissions);
+		findColissionsBetweenTrees(second, world.layers[collidingLayers.first].subLayers[ColissionLayer::TERRAIN_PARTS_LAYER].tree, freeTerrainColissions);
+	}
+
+	/*
+		Ghost zone, every pair of regions is tested once, by the first of the two
+		The members of region j and all regions after it lie above borders[j - 1], so none of their parts reach below borders[j - 1] - reachBelow
+		Once that is above the top of this region, no later region can touch it
+	*/
+	double reachBelow = 0.0;
+	for(const Region& other : regions) {
+		reachBelow = std::max(reachBelow, other.reachBelow);
+	}
+	double upperExtent = getUpperExtent(region.trees, axis);
+	for(std::size_t otherIndex = regionIndex + 1; otherIndex < regions.size() && borders[otherIndex - 1] - reachBelow <= upperExtent; otherIndex++) {
+		const Region& other = regions[otherIndex];
+		for(std::size_t i = 0; i < world.layers.size(); i++) {
+			if(world.layers[i].collidesInternally) {
+				findColissionsBetweenTrees(region.trees[i], other.trees[i], freePartColissions);
+			}
+		}
+		for(std::pair<int, int> collidingLayers : world.colissionMask) {
+			findColissionsBetweenTrees(region.trees[collidingLayers.first], other.trees[collidingLayers.second], freePartColissions);
+			findColissionsBetweenTrees(region.trees[collidingLayers.second], other.trees[collidingLayers.first], freePartColissions);
+		}
+	}
+}
+
+void WorldRegions::mergeColissions(ColissionBuffer& result) {
+	result.clear();
+	for(Region& region : regions) {
+		result.freePartColissions.insert(result.freePartColissions.end(), region.colissions.freePartColissions.begin(), region.colissions.freePartColissions.end());
+		result.freeTerrainColissions.insert(result.freeTerrainColissions.end(), region.colissions.freeTerrainColissions.begin(), region.colissions.freeTerrainColissions.end());
+		migrationCount += region.outbox.size();
+	}
+}
+
+void WorldRegions::refreshTrees(std::size_t regionIndex) {
+	for(BoundsTree<Part>& tree : regions[regionIndex].trees) {
+		tree.recalculateBounds();
+	}
+}
+
+void WorldRegions::findAllColissions(WorldPrototype& world, ColissionBuffer& result) {
+	for(std::size_t i = 0; i < regions.size(); i++) {
+		migrate(i);
+	}
+	for(std::size_t i = 0; i < regions.size(); i++) {
+		updateTrees(i);
+	}
+	for(std::size_t i = 0; i < regions.size(); i++) {
+		findColissions(world, i);
+	}
+	mergeColissions(result);
+}
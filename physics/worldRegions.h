@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "datastructures/boundsTree.h"
+#include "part.h"
+#include "colissionBuffer.h"
+
+class MotorizedPhysical;
+class WorldPrototype;
+
+/*
+	Splits the free parts of a world into regions of space, slabs along the axis in which the physicals are spread the most,
+	so that the colission detection of each region can run on its own thread
+
+	Every region has its own BoundsTree per ColissionLayer, holding the groups of the physicals whose main part lies in the region
+	Each tick goes through three stages, each of them one task per region:
+		migration:  takes out the groups of physicals which crossed a border
+		trees:      adds the physicals that crossed into the region and improves the structure of its trees
+		colissions: colissions within the region and against the terrain, and the ghost zone:
+		            the parts of a region overlap the borders, so the region also tests its trees against those of the regions after it
+		            which they can reach, as the borders are sorted these are only the next few regions, unless a physical spans many of them
+	A task only ever changes its own region, the regions' colissions are then merged in region order, so the result doesn't depend on scheduling
+
+	The bounds of the region's trees are refreshed at the end of the tick with refreshTrees, alongside the branches of the layers' trees
+
+	The trees of the layers stay the authority on which parts are in the world, the regions mirror their free parts
+	The layers of free parts pass on groups being added or removed and parts being moved between ticks, so the regions stay up to date without a rebuild
+	Added groups join their region at the next prepare, removed parts are taken out of the region's trees right away, while they can still be found by their bounds
+	Regrouping parts, physicals being split or merged, and anything the regions can't find rebuilds them at the next prepare, as does the regions getting out of balance
+
+	The colissions of the regions aren't counted in intersectionStatistics
+*/
+class WorldRegions {
+	struct Member {
+		MotorizedPhysical* physical;
+		// the part of the physical heading its group in the tree of layerIndex
+		Part* representative;
+		int layerIndex;
+	};
+	struct Migrant {
+		TreeNode group;
+		Member member;
+		std::size_t targetRegion;
+	};
+	struct PendingGroup {
+		Part* partOfGroup;
+		int layerIndex;
+	};
+	struct Region {
+		// one per ColissionLayer
+		std::vector<BoundsTree<Part>> trees;
+		std::vector<Member> members;
+		// groups which left this region this tick, picked up by their target regions
+		std::vector<Migrant> outbox;
+		// how far the parts of the members reached below their own coordinate along the axis this tick, including the migrants
+		double reachBelow = 0.0;
+		ColissionBuffer colissions;
+	};
+
+	std::vector<Region> regions;
+	// regions.size() - 1 borders, region i lies between borders[i - 1] and borders[i]
+	std::vector<double> borders;
+	int axis = 0;
+
+	bool active = false;
+	bool invalidated = false;
+	std::size_t builtLayerCount = 0;
+	std::size_t migrationCount = 0;
+	std::size_t rebuildCount = 0;
+
+	// changes to the free parts since the last prepare, see the notify functions
+	std::vector<PendingGroup> pendingGroups;
+	// the parts of groups taken out of the trees, and physicals removed from the world, their members are dropped at the next prepare
+	std::vector<const Part*> removedParts;
+	std::vector<const MotorizedPhysical*> removedPhysicals;
+
+	std::size_t getRegionOf(const MotorizedPhysical* physical) const;
+	bool needsRebuild(const WorldPrototype& world) const;
+	void rebuild(WorldPrototype& world);
+	void applyChanges();
+	bool isFollowingChanges() const;
+	BoundsTree<Part>* findTreeHolding(const Part* part, const Bounds& bounds, int layerIndex);
+	bool isPending(const Part* part, int layerIndex) const;
+
+public:
+	// number of regions the world is split into, 1 or less turns the regions off
+	std::size_t regionCount = 1;
+
+	/*
+		Called at the start of the colission detection of every tick, rebuilds the regions if needed
+		Returns true if the regions are used this tick, in which case the three stages below must run for all regions, then mergeColissions
+	*/
+	bool prepare(WorldPrototype& world);
+
+	void migrate(std::size_t regionIndex);
+	void updateTrees(std::size_t regionIndex);
+	void findColissions(const WorldPrototype& world, std::size_t regionIndex);
+	void mergeColissions(ColissionBuffer& result);
+
+	// all of the above, serially on the calling thread
+	void findAllColissions(WorldPrototype& world, ColissionBuffer& result);
+
+	// brings the bounds of the region's trees up to the positions of the parts, after the physicals have moved
+	void refreshTrees(std::size_t regionIndex);
+
+	// called by the layer of free parts layerIndex, only between ticks
+	void notifyGroupAdded(Part* partOfGroup, int layerIndex);
+	// before the part is removed from the layer
+	void notifyPartRemoved(const Part* part, int layerIndex);
+	void notifyPartBoundsUpdated(const Part* part, const Bounds& oldBounds, int layerIndex);
+	void notifyGroupBoundsUpdated(const Part* partOfGroup, const Bounds& oldBounds, int layerIndex);
+	// called by the world before it lets go of the physical, its parts are removed from their layers separately
+	void notifyPhysicalRemoved(const MotorizedPhysical* physical);
+	// rebuilds the regions at the next prepare
+	void invalidate();
+
+	// 0 if the regions are not used this tick
+	inline std::size_t getActiveRegionCount() const { return active ? regions.size() : 0; }
+	inline std::size_t getMemberCount(std::size_t regionIndex) const { return regions[regionIndex].members.size(); }
+	// the number of times a group of parts crossed a border between regions
+	inline std::size_t getMigrationCount() const { return migrationCount; }
+	inline std::size_t getRebuildCount() const { return rebuildCount; }
+};
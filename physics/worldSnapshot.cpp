@@ -0,0 +1,23 @@
+#include "worldSnapshot.h"
+
+#include "world.h"
+
+void WorldSnapshot::capture(const WorldPrototype& world) {
+	this->age = world.age;
+	parts.clear();
+	for(const Part& part : world.iterParts()) {
+		parts.push_back(PartSnapshot{&part, part.getCFrame(), part.getInterpolatedCFrame(0.0), part.hitbox.scale, part.getBounds()});
+	}
+}
+
+void SnapshotBuffer::publish() {
+	// acq_rel: the reader sees the captured snapshot, and the buffer we get back is no longer read
+	writeIndex = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+const WorldSnapshot& SnapshotBuffer::acquireLatest() {
+	if(middle.load(std::memory_order_relaxed) & FRESH_BIT) {
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+	return buffers[readIndex];
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/globalCFrame.h"
+#include "math/linalg/mat.h"
+#include "math/bounds.h"
+
+class Part;
+class WorldPrototype;
+
+/*
+	State of a single part at the end of a tick, as far as readers outside the physics thread need it
+*/
+struct PartSnapshot {
+	// identifies the part, it may have been removed from the world since, so it is only safe to follow while the reader knows the part is alive
+	const Part* part;
+	GlobalCFrame cframe;
+	// cframe of the part at the start of the tick, for interpolating between ticks
+	GlobalCFrame previousCFrame;
+	DiagonalMat3 scale;
+	Bounds bounds;
+	// set by SynchronizedWorld::getSnapshotUserData, lets readers find their own data of the part without following part
+	std::uint64_t userData = 0;
+
+	// approximates Part::getInterpolatedCFrame, which interpolates around the main part instead
+	inline GlobalCFrame getInterpolatedCFrame(double alpha) const {
+		return interpolate(previousCFrame, cframe, alpha);
+	}
+};
+
+/*
+	Copy of everything readers need from a world, taken by the physics thread at the end of a tick
+	The part list is kept between captures, so capturing a world of the same size doesn't allocate
+*/
+struct WorldSnapshot {
+	// age of the world when this was captured, 0 for a snapshot which was never captured
+	std::size_t age = 0;
+	std::vector<PartSnapshot> parts;
+
+	void capture(const WorldPrototype& world);
+};
+
+/*
+	Triple buffer of WorldSnapshots handing snapshots from one writer to one reader thread without locks
+
+	The writer captures into its own back buffer and swaps it with the shared middle buffer in publish()
+	The reader swaps its front buffer with the middle one in acquireLatest(), but only if a new snapshot was published since
+	Neither side ever waits for the other, and each side only touches the buffer it currently owns
+*/
+class SnapshotBuffer {
+	static constexpr int INDEX_MASK = 0x3;
+	// set in middle while it holds a snapshot the reader hasn't taken yet
+	static constexpr int FRESH_BIT = 0x4;
+
+	WorldSnapshot buffers[3];
+	int writeIndex = 0;
+	std::atomic<int> middle{1};
+	int readIndex = 2;
+
+public:
+	// only for the writer, the returned snapshot is published by the next call to publish()
+	inline WorldSnapshot& getBackBuffer() { return buffers[writeIndex]; }
+	void publish();
+
+	/*
+		Only for the reader, the returned snapshot stays unchanged until the next call to acquireLatest
+		Before the first publish this is an empty snapshot of age 0
+	*/
+	const WorldSnapshot& acquireLatest();
+};
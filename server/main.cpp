@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+
+#include "simulationServer.h"
+
+#include "../util/log.h"
+
+static void printUsage() {
+	std::cout << "usage: server [options]\n"
+		"  --world <file>             world to load, written by --checkpoint, worlds saved by the application can't be loaded\n"
+		"  --delta-t <seconds>        length of a tick, 1/120 by default\n"
+		"  --tps <ticks per second>   target tick rate, 0 ticks as fast as possible, 120 by default\n"
+		"  --ticks <count>            stop after this many ticks\n"
+		"  --threads <count>          threads to tick with, 0 for all hardware threads, 1 by default\n"
+		"  --checkpoint <file>        file to write checkpoints to, also written at shutdown\n"
+		"  --checkpoint-every <ticks> write a checkpoint every this many ticks\n"
+		"  --stats-every <ticks>      log statistics every this many ticks\n"
+		"  --socket <path>            accept commands on a local socket at path\n"
+		"  --no-stdin                 don't read commands from standard input\n"
+		"commands: pause, resume, tps <ticks per second>, checkpoint [file], stats, quit\n";
+}
+
+int main(int argc, const char** args) {
+	ServerOptions options;
+	options.readStdin = true;
+
+	try {
+		for(int i = 1; i < argc; i++) {
+			std::string arg = args[i];
+			if(arg == "--help" || arg == "-h") {
+				printUsage();
+				return 0;
+			} else if(arg == "--no-stdin") {
+				options.readStdin = false;
+				continue;
+			}
+
+			if(i + 1 >= argc) {
+				std::cout << "missing value for " << arg << "\n";
+				printUsage();
+				return 1;
+			}
+			std::string value = args[++i];
+			if(arg == "--world") {
+				options.worldFile = value;
+			} else if(arg == "--delta-t") {
+				options.deltaT = std::stod(value);
+			} else if(arg == "--tps") {
+				options.targetTPS = std::stod(value);
+			} else if(arg == "--ticks") {
+				options.tickLimit = std::stoull(value);
+			} else if(arg == "--threads") {
+				options.threadCount = std::stoull(value);
+			} else if(arg == "--checkpoint") {
+				options.checkpointFile = value;
+			} else if(arg == "--checkpoint-every") {
+				options.checkpointInterval = std::stoull(value);
+			} else if(arg == "--stats-every") {
+				options.statisticsInterval = std::stoull(value);
+			} else if(arg == "--socket") {
+				options.socketPath = value;
+			} else {
+				std::cout << "unknown option " << arg << "\n";
+				printUsage();
+				return 1;
+			}
+		}
+	} catch(const std::exception&) {
+		std::cout << "invalid option value\n";
+		printUsage();
+		return 1;
+	}
+	if(options.checkpointInterval != 0 && options.checkpointFile.empty()) {
+		std::cout << "--checkpoint-every needs a --checkpoint file\n";
+		return 1;
+	}
+
+	try {
+		SimulationServer server(options);
+		server.run();
+	} catch(const char* error) {
+		Log::fatal("%s", error);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,308 @@
+#include "simulationServer.h"
+
+#include <cstdio>
+#include <memory>
+#include <future>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <iostream>
+
+#include "../physics/misc/serialization.h"
+#include "../util/stringUtil.h"
+#include "../util/log.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace std::chrono;
+
+#define TICK_SKIP_TIME milliseconds(1000)
+
+SimulationServer::SimulationServer(const ServerOptions& options) : options(options), world(options.deltaT) {
+	if(!options.worldFile.empty()) {
+		std::ifstream file(options.worldFile, std::ios::binary);
+		if(!file.is_open()) {
+			throw "Could not open world file";
+		}
+		DeSerializationSessionPrototype session;
+		session.deserializeWorld(world, file);
+		Log::info("Loaded %s: %d parts, %d physicals, age %d", options.worldFile.c_str(), (int) world.getPartCount(), (int) world.physicals.size(), (int) world.age);
+	}
+
+	if(options.threadCount != 1) {
+		threadPool = std::make_unique<Util::ThreadPool>(options.threadCount);
+		world.threadPool = threadPool.get();
+	}
+
+	ticker = Util::TickerThread(options.targetTPS, TICK_SKIP_TIME, [this]() { tick(); });
+}
+
+SimulationServer::~SimulationServer() {
+	ticker.stop();
+}
+
+void SimulationServer::tick() {
+	commands.drain();
+	if(paused || isStopping()) {
+		// without a target rate the ticker doesn't wait in between, so it would spin on the queue
+		if(ticker.getTPS() <= 0.0) std::this_thread::sleep_for(milliseconds(1));
+		return;
+	}
+
+	steady_clock::time_point start = steady_clock::now();
+	world.tick();
+	tickTimeSinceReport += duration_cast<nanoseconds>(steady_clock::now() - start);
+	ticksRun++;
+
+	if(options.checkpointInterval != 0 && ticksRun % options.checkpointInterval == 0) {
+		Log::info("%s", writeCheckpoint(options.checkpointFile).c_str());
+	}
+	if(options.statisticsInterval != 0 && ticksRun % options.statisticsInterval == 0) {
+		Log::info("%s", getStatistics().c_str());
+	}
+	if(options.tickLimit != 0 && ticksRun >= options.tickLimit) {
+		requestStop();
+	}
+}
+
+void SimulationServer::requestStop() {
+	std::lock_guard<std::mutex> lg(stopLock);
+	stopRequested.store(true, std::memory_order_release);
+	stopSignal.notify_all();
+}
+
+void SimulationServer::run() {
+	lastReportTime = steady_clock::now();
+	lastReportTicks = ticksRun;
+
+	std::thread stdinThread;
+	if(options.readStdin) {
+		stdinThread = std::thread([this]() { listenOnStdin(); });
+	}
+	std::thread socketThread;
+	if(!options.socketPath.empty()) {
+		socketThread = std::thread([this]() { listenOnSocket(); });
+	}
+
+	ticker.start();
+	{
+		std::unique_lock<std::mutex> lock(stopLock);
+		stopSignal.wait(lock, [this]() { return isStopping(); });
+	}
+	ticker.stop();
+
+	if(stdinThread.joinable()) stdinThread.join();
+	if(socketThread.joinable()) socketThread.join();
+	// answers the commands which came in while the ticker was stopping
+	commands.drain();
+
+	if(!options.checkpointFile.empty()) {
+		Log::info("%s", writeCheckpoint(options.checkpointFile).c_str());
+	}
+	Log::info("%s", getStatistics().c_str());
+}
+
+std::string SimulationServer::execute(const std::string& line) {
+	std::shared_ptr<std::promise<std::string>> reply = std::make_shared<std::promise<std::string>>();
+	std::future<std::string> result = reply->get_future();
+	while(!commands.tryPush([this, line, reply]() { reply->set_value(runCommand(line)); })) {
+		if(isStopping()) return "server is stopping";
+		std::this_thread::sleep_for(milliseconds(1));
+	}
+	while(result.wait_for(milliseconds(100)) != std::future_status::ready) {
+		if(isStopping()) return "server is stopping";
+	}
+	return result.get();
+}
+
+std::string SimulationServer::runCommand(const std::string& line) {
+	std::vector<std::string> words = Util::split(Util::trim(line), ' ');
+	if(words.empty() || words[0].empty()) return "";
+	const std::string& command = words[0];
+
+	if(command == "pause") {
+		paused = true;
+		return "paused at age " + std::to_string(world.age);
+	} else if(command == "resume") {
+		paused = false;
+		return "resumed at age " + std::to_string(world.age);
+	} else if(command == "tps") {
+		if(words.size() != 2) return "usage: tps <ticks per second>, 0 for unlimited";
+		try {
+			ticker.setTPS(std::stod(words[1]));
+		} catch(const std::exception&) {
+			return "invalid tps: " + words[1];
+		}
+		return "target tps set to " + words[1];
+	} else if(command == "checkpoint") {
+		return writeCheckpoint(words.size() >= 2 ? words[1] : options.checkpointFile);
+	} else if(command == "stats") {
+		return getStatistics();
+	} else if(command == "quit" || command == "stop") {
+		requestStop();
+		return "stopping at age " + std::to_string(world.age);
+	} else if(command == "help") {
+		return "commands: pause, resume, tps <ticks per second>, checkpoint [file], stats, quit";
+	}
+	return "unknown command: " + command;
+}
+
+std::string SimulationServer::writeCheckpoint(const std::string& file) {
+	if(file.empty()) return "no checkpoint file given";
+
+	std::string temporaryFile = file + ".tmp";
+	{
+		std::ofstream ostream(temporaryFile, std::ios::binary);
+		if(!ostream.is_open()) return "could not open " + temporaryFile;
+		SerializationSessionPrototype session;
+		session.serializeWorld(world, ostream);
+		if(!ostream) return "could not write " + temporaryFile;
+	}
+#ifdef _WIN32
+	// rename doesn't replace existing files on windows
+	std::remove(file.c_str());
+#endif
+	if(std::rename(temporaryFile.c_str(), file.c_str()) != 0) return "could not replace " + file;
+	return "checkpoint of age " + std::to_string(world.age) + " written to " + file;
+}
+
+std::string SimulationServer::getStatistics() {
+	steady_clock::time_point now = steady_clock::now();
+	double seconds = duration<double>(now - lastReportTime).count();
+	std::size_t ticks = ticksRun - lastReportTicks;
+	double tps = seconds > 0.0 ? ticks / seconds : 0.0;
+	double averageTickMillis = ticks != 0 ? duration<double, std::milli>(tickTimeSinceReport).count() / ticks : 0.0;
+
+	lastReportTime = now;
+	lastReportTicks = ticksRun;
+	tickTimeSinceReport = nanoseconds(0);
+
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "age %llu, %.1f tps, %.3f ms/tick, %llu parts, %llu physicals, energy %.6g%s",
+		(unsigned long long) world.age, tps, averageTickMillis, (unsigned long long) world.getPartCount(), (unsigned long long) world.physicals.size(),
+		world.getTotalEnergy(), paused ? ", paused" : "");
+	return buffer;
+}
+
+#ifndef _WIN32
+static bool writeAll(int fd, const std::string& text) {
+	std::size_t written = 0;
+	while(written < text.size()) {
+		ssize_t result = write(fd, text.data() + written, text.size() - written);
+		if(result <= 0) return false;
+		written += result;
+	}
+	return true;
+}
+
+// returns false once the server is stopping or the client disconnected
+static bool waitReadable(int fd, const SimulationServer& server) {
+	pollfd pfd{fd, POLLIN, 0};
+	while(!server.isStopping()) {
+		int result = poll(&pfd, 1, 100);
+		if(result > 0) return true;
+		if(result < 0) return false;
+	}
+	return false;
+}
+
+void SimulationServer::serveCommands(int input, int output) {
+	std::string pending;
+	char buffer[512];
+	while(waitReadable(input, *this)) {
+		ssize_t received = read(input, buffer, sizeof(buffer));
+		if(received <= 0) return;
+		pending.append(buffer, received);
+
+		std::size_t end;
+		while((end = pending.find('\n')) != std::string::npos) {
+			std::string line = pending.substr(0, end);
+			pending.erase(0, end + 1);
+			if(!writeAll(output, execute(line) + "\n")) return;
+		}
+	}
+}
+
+void SimulationServer::listenOnStdin() {
+	serveCommands(STDIN_FILENO, STDOUT_FILENO);
+}
+
+void SimulationServer::listenOnSocket() {
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if(options.socketPath.size() >= sizeof(address.sun_path)) {
+		Log::error("Socket path %s is too long", options.socketPath.c_str());
+		return;
+	}
+	options.socketPath.copy(address.sun_path, options.socketPath.size());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listener < 0) {
+		Log::error("Could not create a socket");
+		return;
+	}
+	unlink(options.socketPath.c_str());
+	if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0) {
+		Log::error("Could not listen on %s", options.socketPath.c_str());
+		close(listener);
+		return;
+	}
+
+	// one client at a time
+	while(waitReadable(listener, *this)) {
+		int client = accept(listener, nullptr, nullptr);
+		if(client < 0) continue;
+		serveCommands(client, client);
+		close(client);
+	}
+
+	close(listener);
+	unlink(options.socketPath.c_str());
+}
+#else
+/*
+	Standard input can't be polled here, so it is read by a detached thread which blocks in getline
+	That thread reaches the server only through stdinServer, which listenOnStdin clears once the server is stopping,
+	both are never destroyed, the thread may outlive any server
+*/
+static std::mutex& getStdinServerLock() {
+	static std::mutex* lock = new std::mutex();
+	return *lock;
+}
+static SimulationServer* stdinServer = nullptr;
+
+void SimulationServer::listenOnStdin() {
+	{
+		std::lock_guard<std::mutex> lock(getStdinServerLock());
+		stdinServer = this;
+	}
+	static std::once_flag readerStarted;
+	std::call_once(readerStarted, []() {
+		std::thread([]() {
+			std::string line;
+			while(std::getline(std::cin, line)) {
+				// execute returns right away once the server is stopping, so this never holds up listenOnStdin for long
+				std::lock_guard<std::mutex> lock(getStdinServerLock());
+				if(stdinServer != nullptr) {
+					std::cout << stdinServer->execute(line) << std::endl;
+				}
+			}
+		}).detach();
+	});
+
+	while(!isStopping()) {
+		std::this_thread::sleep_for(milliseconds(100));
+	}
+	std::lock_guard<std::mutex> lock(getStdinServerLock());
+	stdinServer = nullptr;
+}
+
+void SimulationServer::listenOnSocket() {
+	Log::error("Control sockets are not supported on this platform, use standard input instead");
+}
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+#include <condition_variable>
+
+#include "../physics/world.h"
+#include "../physics/datastructures/operationQueue.h"
+#include "../util/tickerThread.h"
+#include "../util/threadPool.h"
+
+struct ServerOptions {
+	// world to load at startup, the server starts with an empty world if this is empty
+	std::string worldFile;
+	double deltaT = 1.0 / 120.0;
+	// 0 or less ticks as fast as possible
+	double targetTPS = 120.0;
+	// the server stops after this many ticks, 0 runs until told to quit
+	std::size_t tickLimit = 0;
+	// threads of the tick, 1 ticks on the ticker thread alone, 0 uses all hardware threads
+	std::size_t threadCount = 1;
+
+	std::string checkpointFile;
+	// in ticks, 0 only writes a checkpoint on request and at shutdown
+	std::size_t checkpointInterval = 0;
+	// in ticks, 0 only reports statistics on request
+	std::size_t statisticsInterval = 0;
+
+	// accept commands on standard input, answered on standard output
+	bool readStdin = false;
+	// path of a local socket to accept commands on, empty for none
+	std::string socketPath;
+};
+
+/*
+	Runs a world without any graphics, ticking it at a target rate or as fast as possible
+
+	Commands come in as text lines from any thread through execute(), they are queued and run on the tick thread in between ticks,
+	so they never race with the physics:
+		pause, resume, tps <ticks per second>, checkpoint [file], stats, quit
+
+	Checkpoints are written with SerializationSessionPrototype to a temporary file first and then renamed over the checkpoint,
+	so a crash while writing never leaves a broken checkpoint behind
+*/
+class SimulationServer {
+	ServerOptions options;
+	WorldPrototype world;
+	std::unique_ptr<Util::ThreadPool> threadPool;
+	Util::TickerThread ticker;
+
+	// only used on the tick thread
+	bool paused = false;
+	std::size_t ticksRun = 0;
+	std::chrono::steady_clock::time_point lastReportTime;
+	std::size_t lastReportTicks = 0;
+	std::chrono::nanoseconds tickTimeSinceReport{0};
+
+	std::atomic<bool> stopRequested{false};
+	std::mutex stopLock;
+	std::condition_variable stopSignal;
+
+	// drained by run() once the ticker has stopped, commands pushed after that are destroyed with the server without being run
+	OperationQueue<> commands{256};
+
+	void tick();
+	std::string runCommand(const std::string& line);
+	void requestStop();
+	// both run on threads owned by run(), and return once the server is stopping
+	void listenOnStdin();
+	void listenOnSocket();
+#ifndef _WIN32
+	// runs the commands coming in on input, one per line, and answers each with one line on output, until input closes or the server stops
+	void serveCommands(int input, int output);
+#endif
+
+public:
+	explicit SimulationServer(const ServerOptions& options);
+	~SimulationServer();
+
+	SimulationServer(const SimulationServer&) = delete;
+	SimulationServer& operator=(const SimulationServer&) = delete;
+
+	// starts ticking and blocks until the server is told to quit or reaches its tick limit
+	void run();
+
+	/*
+		Runs the command at the start of the next tick and returns its reply, may be called from any thread
+		Blocks until the command has run, or returns right away once the server is stopping
+	*/
+	std::string execute(const std::string& line);
+
+	inline bool isStopping() const { return stopRequested.load(std::memory_order_acquire); }
+
+	// only safe on the tick thread, or while the server isn't running
+	std::string writeCheckpoint(const std::string& file);
+	std::string getStatistics();
+};
@@ -0,0 +1,88 @@
+#include "../testsMain.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#include "../../physics/world.h"
+#include "../../physics/geometry/shape.h"
+#include "../../physics/geometry/shapeCreation.h"
+#include "../../physics/misc/gravityForce.h"
+#include "../../physics/softconstraints/constraintGroup.h"
+#include "../../physics/softconstraints/ballConstraint.h"
+#include "../../util/threadPool.h"
+
+/*
+	An executable of its own, because it replaces the global operator new to count heap allocations
+	In the main tests the replacement would apply to every test in the binary
+*/
+
+static const double DELTA_T = 0.01;
+
+static const PartProperties basicProperties{0.7, 0.2, 0.6};
+
+/*
+	Counts every heap allocation made through operator new while enabled, to check that steady state ticks don't allocate
+*/
+static std::atomic<bool> countingAllocations{false};
+static std::atomic<std::size_t> heapAllocationCounter{0};
+
+void* operator new(std::size_t size) {
+	if(countingAllocations.load(std::memory_order_relaxed)) {
+		heapAllocationCounter.fetch_add(1, std::memory_order_relaxed);
+	}
+	void* result = std::malloc(size != 0 ? size : 1);
+	if(result == nullptr) throw std::bad_alloc();
+	return result;
+}
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+TEST_CASE(steadyStateTickDoesNotAllocate) {
+	Util::ThreadPool threadPool(4);
+
+	WorldPrototype world(DELTA_T);
+	world.threadPool = &threadPool;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> parts;
+	parts.reserve(14);
+	for(int pile = 0; pile < 4; pile++) {
+		for(int height = 0; height < 3; height++) {
+			parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(pile * 10.0, 0.5 + height * 0.95, 0.0, Rotation::fromEulerAngles(0.0, height * 0.3, 0.0)), basicProperties);
+		}
+	}
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 5.0, 20.0), basicProperties);
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(2.0, 5.0, 20.0), basicProperties);
+	for(Part& p : parts) {
+		world.addPart(&p);
+	}
+	ConstraintGroup group;
+	BallConstraint ball(Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0));
+	group.add(parts[12].parent, parts[13].parent, &ball);
+	world.constraints.push_back(group);
+
+	// let the piles settle, so the number of contacts doesn't grow anymore
+	for(int i = 0; i < 200; i++) {
+		world.tick();
+	}
+
+	std::size_t arenaAllocationsBefore = world.tickArena.getHeapAllocationCount();
+	heapAllocationCounter = 0;
+	countingAllocations = true;
+	for(int i = 0; i < 50; i++) {
+		world.tick();
+	}
+	countingAllocations = false;
+
+	ASSERT_STRICT(world.tickArena.getHeapAllocationCount() == arenaAllocationsBefore);
+	ASSERT_STRICT(heapAllocationCounter.load() == 0);
+}
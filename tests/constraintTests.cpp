@@ -6,6 +6,7 @@
 #include "../physics/misc/toString.h"
 
 #include "../physics/softconstraints/constraintGroup.h"
+#include "../physics/softconstraints/ballConstraint.h"
 
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/shapeCreation.h"
@@ -19,6 +20,7 @@
 #include "../physics/math/linalg/trigonometry.h"
 
 #include <functional>
+#include <memory>
 
 #define ASSERT(cond) ASSERT_TOLERANT(cond, 0.05)
 
@@ -461,6 +463,47 @@ TEST_CASE(testInternalMotionOfCenterOfMass) {
 	ASSERT(motionOfCom == estimatedMotion);
 }
 
+TEST_CASE(articulatedBodyMatchesCOMMotionTree) {
+	// a long chain of motors with a branch, so both the depth and the child order matter
+	const int chainLength = 40;
+	std::vector<Part> parts;
+	parts.reserve(chainLength + 1);
+	for(int i = 0; i < chainLength + 1; i++) {
+		parts.emplace_back(boxShape(1.0, 0.3 + 0.01 * i, 0.5), GlobalCFrame(i * 1.2, 0.0, 0.0), PartProperties{1.0 + 0.1 * i, 1.0, 1.0});
+	}
+	for(int i = 0; i < chainLength - 1; i++) {
+		parts[i].attach(&parts[i + 1], new ConstantSpeedMotorConstraint(0.2 + 0.05 * i), CFrame(0.6, 0.0, 0.0), CFrame(-0.6, 0.0, 0.0));
+	}
+	parts[chainLength / 2].attach(&parts[chainLength], new SinusoidalPistonConstraint(0.3, 1.0, 1.0), CFrame(0.0, 0.5, 0.0), CFrame(0.0, -0.5, 0.0));
+
+	MotorizedPhysical* phys = parts[0].parent->mainPhysical;
+	phys->motionOfCenterOfMass = Motion(Vec3(1.0, 0.7, 1.3), Vec3(-0.3, 1.7, -1.1));
+	for(int i = 0; i < 5; i++) {
+		phys->update(DELTA_T);
+	}
+
+	ArticulatedBodyWorkspace articulation;
+	articulation.refresh(*phys);
+
+	ALLOCA_COMMotionTree(cache, phys, size);
+	ASSERT_STRICT(articulation.size() == size);
+	ASSERT(articulation.totalMass == cache.totalMass);
+	ASSERT(articulation.centerOfMass == cache.centerOfMass);
+	ASSERT(articulation.motionOfCenterOfMass == cache.motionOfCenterOfMass);
+	ASSERT(articulation.inertia == cache.getInertia());
+	ASSERT(articulation.internalAngularMomentum == cache.getInternalAngularMomentum());
+
+	std::size_t index = 0;
+	cache.forEach([&](const MonotonicTreeNode<RelativeMotion>& node, const ConnectedPhysical& conPhys) {
+		ASSERT_STRICT(articulation[index].phys == &conPhys);
+		ASSERT(articulation[index].motion == node.value);
+		index++;
+	});
+
+	ASSERT(phys->totalCenterOfMass == cache.centerOfMass);
+	ASSERT(phys->momentResponse == ~cache.getInertia());
+}
+
 static bool haveSameMotorPhys(const Part& first, const Part& second) {
 	return first.parent != nullptr && second.parent != nullptr && first.parent->mainPhysical == second.parent->mainPhysical;
 }
@@ -523,3 +566,93 @@ TEST_CASE(attachPhysicalsWithLayers) {
 		ASSERT_TRUE(pairwiseCorrectlyGrouped(firstPhysParts, secondPhysParts, true));
 	}
 }
+
+static double totalBallConstraintError(const ConstraintGroup& group) {
+	double total = 0.0;
+	for(const PhysicalConstraint& c : group.constraints) {
+		const BallConstraint* ball = static_cast<const BallConstraint*>(c.constraint);
+		total += length(Vec3(c.physB->getCFrame().localToGlobal(ball->attachB) - c.physA->getCFrame().localToGlobal(ball->attachA)));
+	}
+	return total;
+}
+
+TEST_CASE(ballConstraintChainConverges) {
+	const int chainLength = 20;
+	std::vector<Part> parts;
+	parts.reserve(chainLength);
+	for(int i = 0; i < chainLength; i++) {
+		// links are slightly misplaced, so the chain starts with an error at every joint
+		parts.emplace_back(boxShape(1.0, 0.5, 0.5), GlobalCFrame(i * 1.01, 0.003 * (i % 3), 0.0, Rotation::fromEulerAngles(0.0, 0.0, 0.002 * i)), PartProperties{1.0 + 0.1 * i, 0.5, 0.5});
+	}
+	ConstraintGroup group;
+	std::vector<std::unique_ptr<BallConstraint>> balls;
+	for(int i = 0; i < chainLength; i++) {
+		parts[i].ensureHasParent();
+	}
+	for(int i = 0; i < chainLength - 1; i++) {
+		balls.push_back(std::make_unique<BallConstraint>(Vec3(0.5, 0.0, 0.0), Vec3(-0.5, 0.0, 0.0)));
+		group.add(parts[i].parent, parts[i + 1].parent, balls.back().get());
+	}
+
+	double errorBefore = totalBallConstraintError(group);
+	group.apply();
+	double errorAfter = totalBallConstraintError(group);
+
+	ASSERT_TRUE(errorBefore > 0.1);
+	ASSERT_TRUE(errorAfter < errorBefore * 0.05);
+}
+
+// a ball joint halfway between where a and b ought to be, the parts are placed unrotated
+static void addBallBetween(ConstraintGroup& group, std::vector<std::unique_ptr<BallConstraint>>& balls, Part& a, Part& b, Vec3 idealA, Vec3 idealB) {
+	Vec3 middle = (idealA + idealB) / 2;
+	balls.push_back(std::make_unique<BallConstraint>(middle - idealA, middle - idealB));
+	group.add(a.parent, b.parent, balls.back().get());
+}
+
+TEST_CASE(ballConstraintTreeAndLoopConverge) {
+	// a ragdoll: a body with four arms of four links, and apart from it a square of four parts joined in a loop
+	std::vector<Vec3> idealPositions;
+	idealPositions.push_back(Vec3(0.0, 0.0, 0.0));
+	Vec3 directions[4]{Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0), Vec3(0.0, 0.0, 1.0), Vec3(0.0, 0.0, -1.0)};
+	for(Vec3 direction : directions) {
+		for(int link = 1; link <= 4; link++) {
+			idealPositions.push_back(direction * link);
+		}
+	}
+	Vec3 squareCorners[4]{Vec3(0.0, 10.0, 0.0), Vec3(1.0, 10.0, 0.0), Vec3(1.0, 10.0, 1.0), Vec3(0.0, 10.0, 1.0)};
+	for(Vec3 corner : squareCorners) {
+		idealPositions.push_back(corner);
+	}
+
+	std::vector<Part> parts;
+	parts.reserve(idealPositions.size());
+	for(std::size_t i = 0; i < idealPositions.size(); i++) {
+		// misplaced a little, so every joint starts with an error
+		Vec3 position = idealPositions[i] + Vec3(0.004 * (i * 7 % 5), 0.003 * (i % 3), -0.002 * (i * 3 % 4));
+		parts.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame(position.x, position.y, position.z, Rotation::fromEulerAngles(0.001 * i, 0.0, -0.002 * i)), PartProperties{1.0 + 0.05 * i, 0.5, 0.5});
+		parts.back().ensureHasParent();
+	}
+
+	ConstraintGroup group;
+	std::vector<std::unique_ptr<BallConstraint>> balls;
+	for(int arm = 0; arm < 4; arm++) {
+		std::size_t previous = 0;
+		for(int link = 1; link <= 4; link++) {
+			std::size_t current = 1 + arm * 4 + (link - 1);
+			addBallBetween(group, balls, parts[previous], parts[current], idealPositions[previous], idealPositions[current]);
+			previous = current;
+		}
+	}
+	for(std::size_t corner = 0; corner < 4; corner++) {
+		std::size_t a = 17 + corner;
+		std::size_t b = 17 + (corner + 1) % 4;
+		addBallBetween(group, balls, parts[a], parts[b], idealPositions[a], idealPositions[b]);
+	}
+
+	double errorBefore = totalBallConstraintError(group);
+	group.apply();
+	double errorAfter = totalBallConstraintError(group);
+
+	ASSERT_TRUE(errorBefore > 0.05);
+	ASSERT_TRUE(errorAfter < errorBefore * 0.05);
+}
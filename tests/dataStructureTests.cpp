@@ -6,6 +6,24 @@
 #include "../physics/misc/validityHelper.h"
 
 #include "../physics/datastructures/boundsTree.h"
+#include "../physics/datastructures/unionFind.h"
+#include "../physics/datastructures/tickArena.h"
+#include "../physics/datastructures/operationQueue.h"
+#include "../physics/datastructures/upgradableMutex.h"
+#include "../physics/datastructures/slabPool.h"
+#include "../util/threadPool.h"
+#include "../util/taskGraph.h"
+
+#include <thread>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <set>
 
 TEST_CASE(testBoundsTreeGenerationValid) {
 	for(int iter = 0; iter < 1000; iter++) {
@@ -82,3 +100,363 @@ TEST_CASE(testMergeGroups) {
 		}
 	}
 }
+
+TEST_CASE(testUnionFind) {
+	UnionFind uf(8);
+	for(std::size_t i = 0; i < 8; i++) {
+		ASSERT_STRICT(uf.find(i) == i);
+	}
+	uf.unite(0, 1);
+	uf.unite(2, 3);
+	uf.unite(1, 3);
+	uf.unite(5, 6);
+
+	ASSERT_TRUE(uf.isSameSet(0, 2));
+	ASSERT_TRUE(uf.isSameSet(3, 0));
+	ASSERT_TRUE(uf.isSameSet(5, 6));
+	ASSERT_FALSE(uf.isSameSet(0, 4));
+	ASSERT_FALSE(uf.isSameSet(3, 5));
+	ASSERT_FALSE(uf.isSameSet(4, 7));
+
+	uf.reset(4);
+	ASSERT_STRICT(uf.size() == 4);
+	ASSERT_FALSE(uf.isSameSet(0, 1));
+}
+
+TEST_CASE(testTickArena) {
+	TickArena arena;
+	for(int tick = 0; tick < 5; tick++) {
+		arena.reset();
+		char* small = arena.allocate<char>(3);
+		double* doubles = arena.allocate<double>(100 + tick * 10);
+		int* ints = arena.allocate<int>(1000);
+
+		ASSERT_TRUE(reinterpret_cast<std::size_t>(doubles) % alignof(double) == 0);
+		ASSERT_TRUE(reinterpret_cast<std::size_t>(ints) % alignof(int) == 0);
+
+		// allocations may not overlap
+		for(int i = 0; i < 3; i++) small[i] = 'a';
+		for(int i = 0; i < 100 + tick * 10; i++) doubles[i] = i;
+		for(int i = 0; i < 1000; i++) ints[i] = -i;
+		ASSERT_STRICT(small[2] == 'a');
+		ASSERT_STRICT(doubles[99] == 99.0);
+		ASSERT_STRICT(ints[999] == -999);
+	}
+	// the growth of the later ticks fits in the slack left by the first regrowth
+	std::size_t allocationsAfterWarmup = arena.getHeapAllocationCount();
+	for(int tick = 0; tick < 5; tick++) {
+		arena.reset();
+		arena.allocate<double>(140);
+		arena.allocate<int>(1000);
+	}
+	ASSERT_STRICT(arena.getHeapAllocationCount() == allocationsAfterWarmup);
+}
+
+TEST_CASE(testSlabPoolReusesSlotsAndKeepsAddresses) {
+	SlabPool<std::vector<int>, 4> pool;
+	std::vector<std::vector<int>*> objects;
+	for(int i = 0; i < 10; i++) {
+		objects.push_back(pool.create(std::size_t(i), i));
+	}
+	ASSERT_STRICT(pool.getSlabCount() == 3);
+	ASSERT_STRICT(pool.getLiveCount() == 10);
+	// objects made together lie next to each other
+	ASSERT_TRUE(objects[1] == objects[0] + 1);
+	for(int i = 0; i < 10; i++) {
+		ASSERT_TRUE(pool.owns(objects[i]));
+		ASSERT_STRICT(objects[i]->size() == i);
+	}
+	std::vector<int> outside;
+	ASSERT_FALSE(pool.owns(&outside));
+
+	std::vector<int>* destroyed = objects[5];
+	pool.destroy(destroyed);
+	pool.destroy(objects[2]);
+	ASSERT_STRICT(pool.getLiveCount() == 8);
+	// freed slots are reused before the pool grows
+	std::vector<int>* reused = pool.create(std::size_t(3), 7);
+	std::vector<int>* reusedAgain = pool.create(std::size_t(3), 7);
+	ASSERT_TRUE(reused == objects[2]);
+	ASSERT_TRUE(reusedAgain == destroyed);
+	ASSERT_STRICT(pool.getSlabCount() == 3);
+	ASSERT_STRICT(objects[9]->size() == 9);
+
+	objects[2] = reused;
+	objects[5] = reusedAgain;
+	for(std::vector<int>* object : objects) {
+		pool.destroy(object);
+	}
+	ASSERT_STRICT(pool.getLiveCount() == 0);
+	pool.releaseMemory();
+	ASSERT_STRICT(pool.getSlabCount() == 0);
+}
+
+TEST_CASE(testSlabPoolClearDestroysLiveObjects) {
+	int destroyedCount = 0;
+	struct Counted {
+		int* destroyedCount;
+		~Counted() { (*destroyedCount)++; }
+	};
+	SlabPool<Counted, 4> pool;
+	std::vector<Counted*> objects;
+	for(int i = 0; i < 10; i++) {
+		objects.push_back(pool.create(Counted{&destroyedCount}));
+	}
+	destroyedCount = 0;
+	pool.destroy(objects[3]);
+	pool.destroy(objects[7]);
+	ASSERT_STRICT(destroyedCount == 2);
+
+	pool.clear();
+	ASSERT_STRICT(destroyedCount == 10);
+	ASSERT_STRICT(pool.getLiveCount() == 0);
+	ASSERT_STRICT(pool.getSlabCount() == 3);
+
+	// slots are handed out again in address order, from the start of the lowest slab
+	std::sort(objects.begin(), objects.end(), std::less<Counted*>());
+	Counted* first = pool.create(Counted{&destroyedCount});
+	Counted* second = pool.create(Counted{&destroyedCount});
+	ASSERT_TRUE(first == objects[0]);
+	ASSERT_TRUE(second == objects[1]);
+	destroyedCount = 0;
+	pool.clear();
+	ASSERT_STRICT(destroyedCount == 2);
+}
+
+TEST_CASE(testOperationQueueKeepsOrderOfEachProducer) {
+	const int producerCount = 4;
+	const int operationsPerProducer = 5000;
+	OperationQueue<> queue(256);
+	std::array<std::vector<int>, producerCount> received;
+
+	std::vector<std::thread> producers;
+	for(int producer = 0; producer < producerCount; producer++) {
+		producers.emplace_back([&queue, &received, producer]() {
+			for(int i = 0; i < operationsPerProducer; i++) {
+				// the consumer drains below, a full queue is simply retried
+				while(!queue.tryPush([&received, producer, i]() { received[producer].push_back(i); })) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	std::size_t drained = 0;
+	while(drained < producerCount * operationsPerProducer) {
+		drained += queue.drain();
+	}
+	for(std::thread& producer : producers) {
+		producer.join();
+	}
+
+	for(int producer = 0; producer < producerCount; producer++) {
+		ASSERT_STRICT(received[producer].size() == operationsPerProducer);
+		for(int i = 0; i < operationsPerProducer; i++) {
+			ASSERT_STRICT(received[producer][i] == i);
+		}
+	}
+	const OperationQueueStatistics& statistics = queue.getStatistics();
+	ASSERT_STRICT(statistics.pushes == producerCount * operationsPerProducer);
+	ASSERT_STRICT(statistics.drainedOperations == producerCount * operationsPerProducer);
+	ASSERT_STRICT(statistics.heapClosures == 0);
+}
+
+TEST_CASE(testOperationQueueBoundsAndLargeClosures) {
+	OperationQueue<16> queue(3);
+	ASSERT_STRICT(queue.getCapacity() == 4);
+
+	int sum = 0;
+	for(int i = 0; i < 4; i++) {
+		ASSERT_TRUE(queue.tryPush([&sum, i]() { sum += i; }));
+	}
+	ASSERT_FALSE(queue.tryPush([&sum]() { sum += 100; }));
+	ASSERT_STRICT(queue.drain() == 4);
+	ASSERT_STRICT(sum == 6);
+
+	// too large for the slot, this one goes to the heap
+	std::array<int, 16> values{};
+	values[15] = 10;
+	ASSERT_TRUE(queue.tryPush([&sum, values]() { sum += values[15]; }));
+	ASSERT_STRICT(queue.drain() == 1);
+	ASSERT_STRICT(sum == 16);
+
+	const OperationQueueStatistics& statistics = queue.getStatistics();
+	ASSERT_STRICT(statistics.rejectedPushes == 1);
+	ASSERT_STRICT(statistics.heapClosures == 1);
+	ASSERT_STRICT(statistics.drainedOperations == 5);
+}
+
+TEST_CASE(testOperationQueueDestroysPendingClosuresWithoutRunning) {
+	std::shared_ptr<int> owned = std::make_shared<int>(0);
+	{
+		OperationQueue<16> queue(4);
+		ASSERT_TRUE(queue.tryPush([owned]() { (*owned)++; }));
+		// too large for the slot, this one goes to the heap
+		std::array<int, 16> values{};
+		ASSERT_TRUE(queue.tryPush([owned, values]() { (*owned) += values[0] + 1; }));
+		ASSERT_STRICT(owned.use_count() == 3);
+	}
+	ASSERT_STRICT(owned.use_count() == 1);
+	ASSERT_STRICT(*owned == 0);
+}
+
+TEST_CASE(testUpgradableMutexKeepsWritersOutUntilUpgraded) {
+	UpgradableMutex mutex;
+	std::vector<int> order;
+
+	mutex.lock_upgradable();
+	std::thread writer([&mutex, &order]() {
+		mutex.lock();
+		order.push_back(2);
+		mutex.unlock();
+	});
+	// readers still get in next to the upgradable lock, even with the writer waiting
+	for(int i = 0; i < 100; i++) {
+		ASSERT_TRUE(mutex.try_lock_shared());
+		mutex.unlock_shared();
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	mutex.upgrade();
+	order.push_back(1);
+	mutex.downgrade();
+	ASSERT_TRUE(mutex.try_lock_shared());
+	mutex.unlock_shared();
+	mutex.unlock_upgradable();
+	writer.join();
+
+	ASSERT_STRICT(order.size() == 2);
+	ASSERT_STRICT(order[0] == 1);
+	ASSERT_STRICT(order[1] == 2);
+	ASSERT_STRICT(mutex.getStatistics().upgrades == 1);
+	ASSERT_STRICT(mutex.getStatistics().exclusiveLocks == 1);
+}
+
+TEST_CASE(testUpgradableMutexPrefersWriters) {
+	UpgradableMutex mutex;
+	std::atomic<bool> writerDone{false};
+
+	mutex.lock_shared();
+	std::thread writer([&mutex, &writerDone]() {
+		mutex.lock();
+		writerDone = true;
+		mutex.unlock();
+	});
+	// once the writer waits, new readers are turned away, even though a reader is still in
+	bool readerTurnedAway = false;
+	for(int i = 0; i < 10000 && !readerTurnedAway; i++) {
+		if(mutex.try_lock_shared()) {
+			mutex.unlock_shared();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		} else {
+			readerTurnedAway = true;
+		}
+	}
+	ASSERT_TRUE(readerTurnedAway);
+	ASSERT_FALSE(mutex.try_lock());
+	ASSERT_FALSE(writerDone);
+	mutex.unlock_shared();
+	writer.join();
+
+	ASSERT_TRUE(writerDone);
+	const LockStatistics& statistics = mutex.getStatistics();
+	ASSERT_STRICT(statistics.exclusiveLocks == 1);
+	ASSERT_STRICT(statistics.exclusiveWaits == 1);
+	ASSERT_TRUE(statistics.maxExclusiveWaitNanos > 0);
+	ASSERT_TRUE(mutex.try_lock_shared());
+	mutex.unlock_shared();
+}
+
+TEST_CASE(testTaskGraphRespectsDependencies) {
+	Util::ThreadPool threadPool(4);
+	Util::TaskGraph graph;
+
+	// a diamond with a parallel task in the middle, whose count comes from the task before it
+	std::size_t count = 0;
+	std::vector<int> values;
+	std::atomic<int> sum{0};
+	bool finishedOnCaller = false;
+	Util::TaskGraph::TaskID produce = graph.addTask("Produce", [&count, &values]() {
+		count = 100;
+		values.assign(count, 1);
+	});
+	Util::TaskGraph::TaskID other = graph.addTask("Other", []() {});
+	Util::TaskGraph::TaskID consume = graph.addParallelTask("Consume", [&count]() { return count; }, [&values, &sum](std::size_t i) {
+		sum += values[i];
+	});
+	Util::TaskGraph::TaskID finish = graph.addTask("Finish", [&sum, &finishedOnCaller]() {
+		sum = sum * 2;
+		finishedOnCaller = Util::TaskGraph::isOnCallingThread();
+	}, true);
+	graph.addDependency(produce, consume);
+	graph.addDependency(other, consume);
+	graph.addDependency(consume, finish);
+
+	for(int run = 0; run < 20; run++) {
+		sum = 0;
+		count = 0;
+		finishedOnCaller = false;
+		graph.run(run % 2 == 0 ? &threadPool : nullptr);
+		ASSERT_STRICT(sum == 200);
+		ASSERT_TRUE(finishedOnCaller);
+	}
+
+	const std::vector<Util::TaskGraph::TaskProfile>& profile = graph.getProfile();
+	ASSERT_STRICT(profile.size() == 4);
+	ASSERT_STRICT(profile[consume].count == 100);
+	ASSERT_TRUE(profile[consume].start >= profile[produce].end);
+	ASSERT_TRUE(profile[finish].start >= profile[consume].end);
+}
+
+TEST_CASE(testTaskGraphWakesSleepingThreads) {
+	Util::ThreadPool threadPool(4);
+	Util::TaskGraph graph;
+
+	// long enough for the idle threads to go to sleep, the calling thread sleeps while the pool task runs and the others while the caller task runs
+	Util::TaskGraph::TaskID poolTask = graph.addTask("Pool", []() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	});
+	Util::TaskGraph::TaskID callerTask = graph.addTask("Caller", []() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}, true);
+	std::mutex threadsLock;
+	std::set<std::thread::id> threads;
+	Util::TaskGraph::TaskID spread = graph.addParallelTask("Spread", []() { return std::size_t(32); }, [&threadsLock, &threads](std::size_t) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		std::lock_guard<std::mutex> lg(threadsLock);
+		threads.insert(std::this_thread::get_id());
+	});
+	bool finishedOnCaller = false;
+	Util::TaskGraph::TaskID finish = graph.addTask("Finish", [&finishedOnCaller]() {
+		finishedOnCaller = Util::TaskGraph::isOnCallingThread();
+	}, true);
+	graph.addDependency(poolTask, callerTask);
+	graph.addDependency(callerTask, spread);
+	graph.addDependency(spread, finish);
+
+	for(int run = 0; run < 3; run++) {
+		threads.clear();
+		finishedOnCaller = false;
+		graph.run(&threadPool);
+		ASSERT_TRUE(finishedOnCaller);
+		// the sleeping threads were woken for the parallel task
+		ASSERT_TRUE(threads.size() > 1);
+	}
+}
+
+TEST_CASE(testTaskGraphRethrowsAfterFinishing) {
+	Util::ThreadPool threadPool(4);
+	Util::TaskGraph graph;
+	std::atomic<int> ran{0};
+	graph.addParallelTask("Throw", []() { return std::size_t(50); }, [&ran](std::size_t i) {
+		ran++;
+		if(i == 7) throw "failure in task";
+	});
+
+	bool caught = false;
+	try {
+		graph.run(&threadPool);
+	} catch(const char*) {
+		caught = true;
+	}
+	ASSERT_TRUE(caught);
+	ASSERT_STRICT(ran == 50);
+}
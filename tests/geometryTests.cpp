@@ -11,6 +11,8 @@
 
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/boundingBox.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/geometry/shapeClassRegistry.h"
 
 #include "../physics/misc/shapeLibrary.h"
 
@@ -155,3 +157,23 @@ TEST_CASE(testGetFurthestPointInDirection) {
 		ASSERT(Library::icosahedron.furthestInDirection(vertex) == vertex);
 	}
 }
+
+TEST_CASE(polyhedronShapesShareIdenticalShapeClasses) {
+	ShapeClassRegistryStatistics before = ShapeClassRegistry::global().getStatistics();
+
+	Shape box = polyhedronShape(Library::createBox(1.0, 1.0, 1.0));
+	Shape sameBox = polyhedronShape(Library::createBox(1.0, 1.0, 1.0));
+	// normalized to the same -1..1 box, only the scale differs
+	Shape biggerBox = polyhedronShape(Library::createBox(2.0, 3.0, 4.0));
+	Shape icosahedron = polyhedronShape(Library::icosahedron);
+
+	ASSERT_TRUE(box.baseShape == sameBox.baseShape);
+	ASSERT_TRUE(box.baseShape == biggerBox.baseShape);
+	ASSERT_TRUE(box.baseShape != icosahedron.baseShape);
+	ASSERT(biggerBox.getVolume() == 24.0);
+
+	ShapeClassRegistryStatistics after = ShapeClassRegistry::global().getStatistics();
+	ASSERT_STRICT(after.requestCount - before.requestCount == 4);
+	ASSERT_STRICT(after.reuseCount - before.reuseCount >= 2);
+	ASSERT_TRUE(after.bytesSaved > before.bytesSaved);
+}
@@ -7,8 +7,22 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <memory>
+#include <thread>
+#include <set>
+#include <functional>
+#include <mutex>
+#include <chrono>
 
 #include "../physics/world.h"
+#include "../physics/synchonizedWorld.h"
+#include "../physics/worldSnapshot.h"
+#include "../physics/worldBatch.h"
+#include "../physics/externalForceBatch.h"
+#include "../physics/softLinkBatch.h"
+#include "../physics/springLink.h"
+#include "../physics/elasticLink.h"
+#include "../physics/datastructures/tickArena.h"
 #include "../physics/inertia.h"
 #include "../physics/misc/shapeLibrary.h"
 #include "../physics/math/linalg/trigonometry.h"
@@ -16,10 +30,15 @@
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/shapeCreation.h"
 #include "../physics/misc/gravityForce.h"
+#include "../physics/misc/farFieldForce.h"
+#include "../physics/physicsProfiler.h"
 #include "../physics/constraints/motorConstraint.h"
 #include "../physics/constraints/sinusoidalPistonConstraint.h"
 #include "../physics/constraints/fixedConstraint.h"
+#include "../physics/softconstraints/ballConstraint.h"
 #include "../util/log.h"
+#include "../util/threadPool.h"
+#include "../util/taskGraph.h"
 
 
 #define REMAINS_CONSTANT(v) REMAINS_CONSTANT_TOLERANT(v, 0.0005)
@@ -368,6 +387,33 @@ TEST_CASE(testShapeNativeScaling) {
 	ASSERT(shape2.getInertia() == scaledTestPoly.getInertiaAroundCenterOfMass());
 }
 
+TEST_CASE(scalingPartRefreshesSingleRigidBody) {
+	Part part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0, Rotation::fromEulerAngles(0.3, 0.7, 0.9)), basicProperties);
+	part.ensureHasParent();
+	MotorizedPhysical& phys = *part.parent->mainPhysical;
+
+	part.scale(2.0, 1.0, 3.0);
+
+	ASSERT(phys.totalMass == part.getMass());
+	ASSERT(phys.forceResponse == SymmetricMat3::IDENTITY() * (1 / part.getMass()));
+	ASSERT(phys.momentResponse == ~part.getInertia());
+}
+
+TEST_CASE(cachedInertiaOfPointMatchesLocal) {
+	Part mainPart(boxShape(1.0, 2.0, 3.0), GlobalCFrame(1.0, 2.0, 3.0, Rotation::fromEulerAngles(0.3, 0.7, 0.9)), basicProperties);
+	Part attachedPart(boxShape(0.5, 0.5, 2.0), mainPart, CFrame(1.0, 0.5, 0.0, Rotation::fromEulerAngles(0.1, 0.2, 0.3)), basicProperties);
+	MotorizedPhysical& phys = *mainPart.parent->mainPhysical;
+	phys.refreshGlobalInertiaCache();
+
+	ASSERT(phys.cachedCenterOfMass == phys.getCenterOfMass());
+
+	Vec3 relPoint(0.7, -1.3, 2.1);
+	Vec3 directions[]{Vec3(1.0, 0.0, 0.0), Vec3(0.3, -0.5, 2.0), Vec3(-1.0, 4.0, 0.1)};
+	for(Vec3 dir : directions) {
+		ASSERT(phys.getCachedInertiaOfPointInDirectionRelative(relPoint, dir) == phys.getInertiaOfPointInDirectionRelative(relPoint, dir));
+	}
+}
+
 TEST_CASE(testPhysicalInertiaDerivatives) {
 	Polyhedron testPoly = Library::createPointyPrism(4, 1.0f, 1.0f, 0.5f, 0.5f);
 
@@ -1039,3 +1085,1019 @@ TEST_CASE(setVelocity) {
 		}
 	}
 }
+
+TEST_CASE(interpolatedCFrameBetweenTicks) {
+	WorldPrototype world(DELTA_T);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part mainPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 5.0, 0.0, Rotation::fromEulerAngles(0.3, 0.2, 0.1)), basicProperties);
+	Part attachedPart(boxShape(0.5, 0.5, 0.5), mainPart, CFrame(1.0, 0.0, 0.0), basicProperties);
+	world.addPart(&mainPart);
+	mainPart.setMotion(Vec3(1.0, 0.0, 0.0), Vec3(0.0, 3.0, 1.0));
+
+	GlobalCFrame mainBefore = mainPart.getCFrame();
+	GlobalCFrame attachedBefore = attachedPart.getCFrame();
+	world.tick();
+
+	ASSERT(mainPart.getInterpolatedCFrame(0.0) == mainBefore);
+	ASSERT(attachedPart.getInterpolatedCFrame(0.0) == attachedBefore);
+	ASSERT(mainPart.getInterpolatedCFrame(1.0) == mainPart.getCFrame());
+	ASSERT(attachedPart.getInterpolatedCFrame(1.0) == attachedPart.getCFrame());
+
+	GlobalCFrame halfway = mainPart.getInterpolatedCFrame(0.5);
+	ASSERT(halfway.getPosition() == mainBefore.getPosition() + (mainPart.getPosition() - mainBefore.getPosition()) * 0.5);
+	Rotation halfwayToEnd = ~halfway.getRotation() * mainPart.getCFrame().getRotation();
+	Rotation startToHalfway = ~mainBefore.getRotation() * halfway.getRotation();
+	ASSERT(halfwayToEnd.asRotationVector() == startToHalfway.asRotationVector());
+
+	// a teleport is not interpolated
+	mainPart.setCFrame(GlobalCFrame(20.0, 0.0, 0.0));
+	ASSERT(attachedPart.getInterpolatedCFrame(0.0) == attachedPart.getCFrame());
+}
+
+// the parts of a simulated world after the last tick, and the state hash of the world after every tick
+struct SimulationResult {
+	std::vector<GlobalCFrame> cframes;
+	std::vector<uint64_t> stateHashes;
+};
+
+using WorldBuilder = std::function<void(WorldPrototype& world, Part& floor, std::vector<Part>& parts)>;
+
+/*
+	Builds a new world with buildWorld and ticks it tickCount times, on threadPool if it isn't nullptr
+	floor is a 100 by 100 plate with its top at y = 0, buildWorld adds it as terrain if the scenario needs one
+	afterTicks, if given, may inspect the world before it is destroyed
+*/
+static SimulationResult simulateWorld(Util::ThreadPool* threadPool, int tickCount, const WorldBuilder& buildWorld, const std::function<void(const WorldPrototype& world)>& afterTicks = nullptr) {
+	WorldPrototype world(DELTA_T);
+	world.threadPool = threadPool;
+	Part floor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> parts;
+	buildWorld(world, floor, parts);
+
+	SimulationResult result;
+	for(int i = 0; i < tickCount; i++) {
+		world.tick();
+		result.stateHashes.push_back(world.getStateHash());
+	}
+	for(Part& p : parts) {
+		result.cframes.push_back(p.getCFrame());
+	}
+	if(afterTicks) afterTicks(world);
+	return result;
+}
+
+// four piles of boxes, far enough apart to be separate islands
+static void buildSeparatePiles(WorldPrototype& world, Part& floor, std::vector<Part>& parts) {
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	world.addTerrainPart(&floor);
+
+	parts.reserve(12);
+	for(int pile = 0; pile < 4; pile++) {
+		for(int height = 0; height < 3; height++) {
+			GlobalCFrame location(pile * 10.0, 0.5 + height * 0.95, 0.0, Rotation::fromEulerAngles(0.0, height * 0.3, 0.0));
+			parts.emplace_back(boxShape(1.0, 1.0, 1.0), location, basicProperties);
+		}
+	}
+	for(Part& p : parts) {
+		world.addPart(&p);
+	}
+}
+
+TEST_CASE(parallelIslandsMatchSerial) {
+	Util::ThreadPool threadPool(4);
+
+	SimulationResult serial = simulateWorld(nullptr, 100, buildSeparatePiles);
+	SimulationResult parallel = simulateWorld(&threadPool, 100, buildSeparatePiles);
+
+	ASSERT_TRUE(serial.stateHashes == parallel.stateHashes);
+}
+
+// a spinning cube of boxes, enough physicals to be split over several chunks
+static void buildSpinningCloud(WorldPrototype& world, Part&, std::vector<Part>& parts) {
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	parts.reserve(1000);
+	for(int x = 0; x < 10; x++) {
+		for(int y = 0; y < 10; y++) {
+			for(int z = 0; z < 10; z++) {
+				parts.emplace_back(boxShape(0.5, 0.7, 0.9), GlobalCFrame(x * 3.0, y * 3.0, z * 3.0, Rotation::fromEulerAngles(x * 0.1, y * 0.2, z * 0.3)), basicProperties);
+			}
+		}
+	}
+	for(Part& p : parts) {
+		world.addPart(&p);
+		p.setMotion(Vec3(0.1, 0.0, 0.2), Vec3(1.0, 2.0, 3.0));
+	}
+}
+
+TEST_CASE(tickGraphProfilesEveryStage) {
+	Util::ThreadPool threadPool(4);
+
+	WorldPrototype world(DELTA_T);
+	world.threadPool = &threadPool;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	Part floor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.4, 0.0), basicProperties);
+	world.addPart(&box);
+	world.tick();
+
+	ASSERT_TRUE(world.tickGraph != nullptr);
+	const std::vector<Util::TaskGraph::TaskProfile>& profile = world.tickGraph->getProfile();
+	ASSERT_STRICT(profile.size() == world.tickGraph->size());
+	for(std::size_t i = 1; i < profile.size(); i++) {
+		// every stage of this tick depends on the one before it, except the external forces and refreshing the trees next to the soft links
+		auto isExternals = [](const char* name) { return std::string(name) == "Externals" || std::string(name) == "Batched externals"; };
+		if(!isExternals(profile[i].name) && !isExternals(profile[i - 1].name) && std::string(profile[i].name) != "Refresh trees") {
+			ASSERT_TRUE(profile[i].start >= profile[i - 1].end);
+		}
+	}
+	const Util::TaskGraph::TaskProfile& refreshTrees = profile[static_cast<std::size_t>(TickTask::REFRESH_TREES)];
+	ASSERT_TRUE(std::string(refreshTrees.name) == "Refresh trees");
+	ASSERT_TRUE(refreshTrees.start >= profile[static_cast<std::size_t>(TickTask::UPDATE_PHYSICALS)].end);
+	ASSERT_TRUE(profile[static_cast<std::size_t>(TickTask::FINISH)].start >= refreshTrees.end);
+	ASSERT_STRICT(world.age == 1);
+
+	// the profile of the tick went into the profiler on this thread
+	ASSERT_TRUE(tickTaskItemCounts.history.size() > 0);
+	ASSERT_STRICT(tickTaskMeasure.history.size() == tickTaskItemCounts.history.size());
+	ASSERT_TRUE(tickTaskMeasure.history.front()[static_cast<std::size_t>(TickTask::FINISH)].count() > 0);
+	ASSERT_STRICT(tickTaskItemCounts.history.front()[static_cast<std::size_t>(TickTask::BROADPHASE)] == 1);
+	ASSERT_STRICT(tickTaskItemCounts.history.front()[static_cast<std::size_t>(TickTask::UPDATE_PHYSICALS)] == 1);
+}
+
+TEST_CASE(parallelUpdateMatchesSerial) {
+	Util::ThreadPool threadPool(4);
+
+	SimulationResult serial = simulateWorld(nullptr, 20, buildSpinningCloud);
+	SimulationResult parallel = simulateWorld(&threadPool, 20, buildSpinningCloud);
+
+	ASSERT_TRUE(serial.stateHashes == parallel.stateHashes);
+}
+
+// piles of touching boxes which form one island, and a separate pair of boxes joined by a ConstraintGroup
+static void buildPilesAndConstraint(WorldPrototype& world, Part& floor, std::vector<Part>& parts) {
+	static BallConstraint ball(Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0));
+
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	world.addTerrainPart(&floor);
+
+	parts.reserve(26);
+	for(int pile = 0; pile < 8; pile++) {
+		for(int height = 0; height < 3; height++) {
+			parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(pile * 1.5, 0.5 + height * 0.95, 0.0, Rotation::fromEulerAngles(0.0, height * 0.3 + pile * 0.1, 0.0)), basicProperties);
+		}
+	}
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 5.0, 20.0), basicProperties);
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(2.0, 5.0, 20.0), basicProperties);
+	for(Part& p : parts) {
+		world.addPart(&p);
+	}
+	ConstraintGroup group;
+	group.add(parts[24].parent, parts[25].parent, &ball);
+	world.constraints.push_back(group);
+}
+
+TEST_CASE(stateHashIdenticalAcrossThreadCounts) {
+	SimulationResult serial = simulateWorld(nullptr, 100, buildPilesAndConstraint);
+
+	for(std::size_t threadCount : {1, 2, 3, 8}) {
+		Util::ThreadPool threadPool(threadCount);
+		SimulationResult parallel = simulateWorld(&threadPool, 100, buildPilesAndConstraint);
+		ASSERT_TRUE(serial.stateHashes == parallel.stateHashes);
+	}
+	ASSERT_FALSE(serial.stateHashes.front() == serial.stateHashes.back());
+}
+
+// applies the same force as DirectionalGravity, but one physical at a time
+class UnbatchedGravity : public DirectionalGravity {
+public:
+	UnbatchedGravity(Vec3 gravity) : DirectionalGravity(gravity) {}
+	virtual bool isBatched() const override { return false; }
+};
+
+class LinearDrag : public ExternalForce {
+public:
+	double factor;
+	bool batched;
+
+	LinearDrag(double factor, bool batched) : factor(factor), batched(batched) {}
+
+	virtual void apply(WorldPrototype* world) override {
+		for(MotorizedPhysical* p : world->iterPhysicals()) {
+			p->applyForceAtCenterOfMass(p->motionOfCenterOfMass.getVelocity() * -factor);
+		}
+	}
+	virtual bool isBatched() const override { return batched; }
+	virtual void applyToBatch(ExternalForceBatch& batch, std::size_t begin, std::size_t end) const override {
+		for(std::size_t i = begin; i < end; i++) {
+			batch.forceX[i] -= batch.velocityX[i] * factor;
+			batch.forceY[i] -= batch.velocityY[i] * factor;
+			batch.forceZ[i] -= batch.velocityZ[i] * factor;
+		}
+	}
+	virtual double getPotentialEnergyForObject(const WorldPrototype*, const Part&) const override {
+		return 0.0;
+	}
+};
+
+// a cloud of boxes under gravity and drag, more than one chunk and not a multiple of ExternalForceBatch::LANES
+static WorldBuilder buildFallingCloud(bool batched) {
+	return [batched](WorldPrototype& world, Part&, std::vector<Part>& parts) {
+		if(batched) {
+			world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+		} else {
+			world.addExternalForce(new UnbatchedGravity(Vec3(0, -10, 0)));
+		}
+		world.addExternalForce(new LinearDrag(0.3, batched));
+
+		parts.reserve(303);
+		for(int i = 0; i < 303; i++) {
+			parts.emplace_back(boxShape(0.5 + (i % 3) * 0.2, 0.7, 0.9), GlobalCFrame((i % 20) * 3.0, (i / 20) * 3.0, 0.0, Rotation::fromEulerAngles(i * 0.1, 0.2, 0.3)), basicProperties);
+		}
+		for(std::size_t i = 0; i < parts.size(); i++) {
+			world.addPart(&parts[i]);
+			parts[i].setMotion(Vec3(0.1 * (i % 7), 0.0, 0.2), Vec3(1.0, 2.0, 3.0));
+		}
+	};
+}
+
+TEST_CASE(batchedExternalForcesMatchUnbatched) {
+	Util::ThreadPool threadPool(4);
+
+	SimulationResult unbatched = simulateWorld(nullptr, 20, buildFallingCloud(false));
+	SimulationResult batched = simulateWorld(nullptr, 20, buildFallingCloud(true));
+	SimulationResult batchedParallel = simulateWorld(&threadPool, 20, buildFallingCloud(true));
+
+	ASSERT_STRICT(unbatched.cframes.size() == batched.cframes.size());
+	for(std::size_t i = 0; i < unbatched.cframes.size(); i++) {
+		ASSERT(batched.cframes[i] == unbatched.cframes[i]);
+	}
+	ASSERT_TRUE(batched.stateHashes == batchedParallel.stateHashes);
+}
+
+// records the threads its batch ranges ran on, slow enough for the other threads of the pool to take chunks too
+class ThreadRecordingForce : public ExternalForce {
+public:
+	mutable std::mutex threadsLock;
+	mutable std::set<std::thread::id> threads;
+
+	virtual void apply(WorldPrototype*) override {}
+	virtual bool isBatched() const override { return true; }
+	virtual void applyToBatch(ExternalForceBatch&, std::size_t, std::size_t) const override {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		std::lock_guard<std::mutex> lock(threadsLock);
+		threads.insert(std::this_thread::get_id());
+	}
+	virtual double getPotentialEnergyForObject(const WorldPrototype*, const Part&) const override {
+		return 0.0;
+	}
+};
+
+TEST_CASE(batchedExternalForcesSpreadOverThreadPool) {
+	Util::ThreadPool threadPool(4);
+	ThreadRecordingForce force;
+
+	WorldPrototype world(DELTA_T);
+	world.threadPool = &threadPool;
+	world.addExternalForce(&force);
+	std::vector<Part> parts;
+	parts.reserve(2048);
+	for(int i = 0; i < 2048; i++) {
+		parts.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame((i % 64) * 2.0, (i / 64) * 2.0, 0.0), basicProperties);
+	}
+	for(Part& p : parts) {
+		world.addPart(&p);
+	}
+	world.tick();
+
+	ASSERT_TRUE(world.tickGraph != nullptr);
+	ASSERT_TRUE(force.threads.size() > 1);
+}
+
+static std::vector<Vec3> getFarFieldForces(WorldPrototype& world, FarFieldForce& force) {
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		phys->totalForce = Vec3();
+	}
+	force.apply(&world);
+	std::vector<Vec3> result;
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		result.push_back(phys->totalForce);
+	}
+	return result;
+}
+
+// exposes the external force steps of the tick
+struct ExternalForceTestWorld : public WorldPrototype {
+	using WorldPrototype::WorldPrototype;
+	using WorldPrototype::applyExternalForces;
+	using WorldPrototype::applyBatchedExternalForces;
+};
+
+// more than one chunk of physicals, so the batched forces are spread over the threadPool of the world
+TEST_CASE(barnesHutMatchesDirectSum) {
+	ExternalForceTestWorld world(DELTA_T);
+
+	std::vector<Part> parts;
+	parts.reserve(512);
+	for(int i = 0; i < 512; i++) {
+		GlobalCFrame location((i % 8) * 4.0 + (i % 5) * 0.3, (i / 8 % 8) * 4.0, (i / 64) * 4.0 - (i % 7) * 0.2);
+		parts.emplace_back(boxShape(0.5 + (i % 3) * 0.3, 0.7, 0.9), location, basicProperties);
+	}
+	for(Part& p : parts) {
+		world.addPart(&p);
+	}
+
+	NBodyGravity gravity(1.0);
+	std::vector<Vec3> direct;
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		Vec3 total(0.0, 0.0, 0.0);
+		for(const Part& other : parts) {
+			if(other.parent->mainPhysical == phys) continue;
+			Vec3 offset = other.getCenterOfMass() - phys->getCenterOfMass();
+			double softDistSq = lengthSquared(offset) + gravity.softening * gravity.softening;
+			total += offset * (phys->totalMass * other.getMass() / (softDistSq * std::sqrt(softDistSq)));
+		}
+		direct.push_back(total);
+	}
+
+	gravity.openingAngle = 0.0;
+	std::vector<Vec3> exact = getFarFieldForces(world, gravity);
+	ASSERT_STRICT(exact.size() == direct.size());
+	for(std::size_t i = 0; i < direct.size(); i++) {
+		ASSERT(exact[i] == direct[i]);
+	}
+
+	gravity.openingAngle = 0.5;
+	std::vector<Vec3> approximate = getFarFieldForces(world, gravity);
+	double totalError = 0.0;
+	double totalForce = 0.0;
+	for(std::size_t i = 0; i < direct.size(); i++) {
+		totalError += length(approximate[i] - direct[i]);
+		totalForce += length(direct[i]);
+	}
+	ASSERT_STRICT(totalError < 0.01 * totalForce);
+
+	// as the world applies it in a tick, batched over chunks of physicals on the threadPool
+	Util::ThreadPool threadPool(4);
+	world.threadPool = &threadPool;
+	world.addExternalForce(&gravity);
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		phys->totalForce = Vec3();
+	}
+	world.applyExternalForces();
+	world.applyBatchedExternalForces();
+	world.removeExternalForce(&gravity);
+	world.threadPool = nullptr;
+	std::size_t i = 0;
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		ASSERT_STRICT(phys->totalForce == approximate[i++]);
+	}
+}
+
+TEST_CASE(softLinkBatchMatchesUpdate) {
+	// not a multiple of SoftLinkBatch::LANES, the odd elastic links are slack
+	const std::size_t count = 7;
+	std::vector<Part> updatedParts;
+	std::vector<Part> batchedParts;
+	updatedParts.reserve(count * 2);
+	batchedParts.reserve(count * 2);
+	for(std::size_t i = 0; i < count * 2; i++) {
+		GlobalCFrame location((i / 2) * 10.0, (i % 2) * (2.0 + i * 0.5), 0.3 * i, Rotation::fromEulerAngles(0.2 * i, 0.1, 0.4));
+		updatedParts.emplace_back(boxShape(1.0, 2.0, 0.5), location, basicProperties);
+		batchedParts.emplace_back(boxShape(1.0, 2.0, 0.5), location, basicProperties);
+		updatedParts[i].ensureHasParent();
+		batchedParts[i].ensureHasParent();
+	}
+
+	std::vector<std::unique_ptr<SoftLink>> updatedLinks;
+	std::vector<std::unique_ptr<SoftLink>> batchedLinks;
+	for(std::size_t i = 0; i < count; i++) {
+		std::vector<Part>* partSets[]{&updatedParts, &batchedParts};
+		std::vector<std::unique_ptr<SoftLink>>* linkSets[]{&updatedLinks, &batchedLinks};
+		for(int set = 0; set < 2; set++) {
+			Part* a = &(*partSets[set])[i * 2];
+			Part* b = &(*partSets[set])[i * 2 + 1];
+			double restLength = (i % 2 == 0) ? 1.0 : 50.0;
+			if(i % 3 == 0) {
+				linkSets[set]->emplace_back(new SpringLink({CFrame(0.5, 0.0, 0.0), a}, {CFrame(0.0, 0.2, 0.0), b}, restLength, 3.0 + i));
+			} else {
+				linkSets[set]->emplace_back(new ElasticLink({CFrame(0.5, 0.0, 0.0), a}, {CFrame(0.0, 0.2, 0.0), b}, restLength, 3.0 + i));
+			}
+		}
+	}
+
+	TickArena arena;
+	SoftLinkBatch batch;
+	batch.allocate(arena, count);
+	for(std::size_t i = 0; i < count; i++) {
+		ASSERT_TRUE(batchedLinks[i]->isBatched());
+		batchedLinks[i]->gatherInto(batch, i);
+	}
+	batch.computeForces(0, count);
+	for(std::size_t i = 0; i < count; i++) {
+		batch.scatter(i, *batchedLinks[i]);
+		updatedLinks[i]->update();
+	}
+
+	for(std::size_t i = 0; i < count * 2; i++) {
+		const MotorizedPhysical& updated = *updatedParts[i].parent->mainPhysical;
+		const MotorizedPhysical& batched = *batchedParts[i].parent->mainPhysical;
+		ASSERT(batched.totalForce == updated.totalForce);
+		ASSERT(batched.totalMoment == updated.totalMoment);
+	}
+	// slack elastic links apply no force
+	ASSERT_STRICT(batchedParts[3].parent->mainPhysical->totalForce == Vec3(0.0, 0.0, 0.0));
+}
+
+static double spinTumblingBox(WorldPrototype& world, Part& box, int ticks) {
+	world.addPart(&box);
+	box.parent->mainPhysical->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(0.2, 3.0, 0.3));
+	for(int i = 0; i < ticks; i++) {
+		world.tick();
+	}
+	return box.parent->mainPhysical->getKineticEnergy();
+}
+
+TEST_CASE(implicitGyroscopicKeepsTumblingBoxStable) {
+	// spinning close to the intermediate axis at a large deltaT, where the explicit integrator gains energy
+	const double largeDeltaT = 0.05;
+	Part reference(boxShape(1.0, 2.0, 3.0), GlobalCFrame(), basicProperties);
+	reference.ensureHasParent();
+	reference.parent->mainPhysical->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(0.2, 3.0, 0.3));
+	double initialEnergy = reference.parent->mainPhysical->getKineticEnergy();
+
+	WorldPrototype explicitWorld(largeDeltaT);
+	Part explicitBox(boxShape(1.0, 2.0, 3.0), GlobalCFrame(), basicProperties);
+	double explicitEnergy = spinTumblingBox(explicitWorld, explicitBox, 400);
+
+	WorldPrototype implicitWorld(largeDeltaT);
+	implicitWorld.integrator = Integrator::SEMI_IMPLICIT_GYROSCOPIC;
+	Part implicitBox(boxShape(1.0, 2.0, 3.0), GlobalCFrame(), basicProperties);
+	double implicitEnergy = spinTumblingBox(implicitWorld, implicitBox, 400);
+
+	// choosing the integrator on the physical gives the same result as choosing it for the world
+	WorldPrototype mixedWorld(largeDeltaT);
+	Part mixedBox(boxShape(1.0, 2.0, 3.0), GlobalCFrame(), basicProperties);
+	mixedBox.ensureHasParent();
+	mixedBox.parent->mainPhysical->integrator = Integrator::SEMI_IMPLICIT_GYROSCOPIC;
+	double mixedEnergy = spinTumblingBox(mixedWorld, mixedBox, 400);
+
+	ASSERT_TRUE(explicitEnergy > initialEnergy * 1.5);
+	ASSERT_TRUE(implicitEnergy <= initialEnergy);
+	ASSERT_STRICT(mixedEnergy == implicitEnergy);
+	ASSERT_STRICT(mixedBox.getCFrame().getPosition() == implicitBox.getCFrame().getPosition());
+}
+
+TEST_CASE(tickDivisorCatchesUpOnDueTicks) {
+	WorldPrototype world(0.01);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	// far enough apart to never collide
+	Part fullRate(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	Part quarterRate(boxShape(1.0, 1.0, 1.0), GlobalCFrame(10.0, 0.0, 0.0), basicProperties);
+	world.addPart(&fullRate);
+	world.addPart(&quarterRate);
+	quarterRate.parent->mainPhysical->tickDivisor = 4;
+
+	for(int tick = 1; tick <= 8; tick++) {
+		Position positionBefore = quarterRate.getCFrame().getPosition();
+		world.tick();
+		bool moved = quarterRate.getCFrame().getPosition() != positionBefore;
+		ASSERT_STRICT(moved == (tick % 4 == 0));
+	}
+
+	// a constant force gives the same velocity, the position follows a step over the 3 skipped ticks followed by the step of the due tick
+	WorldPrototype coarseWorld(0.01);
+	coarseWorld.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	Part coarse(boxShape(1.0, 1.0, 1.0), GlobalCFrame(10.0, 0.0, 0.0), basicProperties);
+	coarseWorld.addPart(&coarse);
+	for(int dueTick = 0; dueTick < 2; dueTick++) {
+		coarseWorld.deltaT = 0.01 * 3.0;
+		coarseWorld.tick();
+		coarseWorld.deltaT = 0.01;
+		coarseWorld.tick();
+	}
+
+	ASSERT(quarterRate.parent->mainPhysical->getMotion().getVelocity() == fullRate.parent->mainPhysical->getMotion().getVelocity());
+	ASSERT_STRICT(quarterRate.getCFrame().getPosition() == coarse.getCFrame().getPosition());
+}
+
+TEST_CASE(tickDivisorInterpolatesOverCatchUp) {
+	WorldPrototype world(0.01);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part quarterRate(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addPart(&quarterRate);
+	MotorizedPhysical& phys = *quarterRate.parent->mainPhysical;
+	phys.tickDivisor = 4;
+
+	for(int tick = 1; tick <= 4; tick++) {
+		world.tick();
+	}
+	GlobalCFrame frameAfterDueTick = phys.getCFrame();
+	for(int tick = 5; tick <= 7; tick++) {
+		world.tick();
+	}
+	ASSERT(phys.getCFrame() == frameAfterDueTick);
+
+	// the due tick catches up on 3 ticks and takes its own step, the interpolation spans both from where the physical stood
+	world.tick();
+	ASSERT(phys.previousCFrame == frameAfterDueTick);
+	ASSERT_TRUE(phys.getCFrame().getPosition() != frameAfterDueTick.getPosition());
+	ASSERT(quarterRate.getInterpolatedCFrame(0.0) == frameAfterDueTick);
+}
+
+TEST_CASE(linkedPhysicalsUseFastestTickDivisor) {
+	WorldPrototype world(0.01);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part fast(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	Part slow(boxShape(1.0, 1.0, 1.0), GlobalCFrame(5.0, 0.0, 0.0), basicProperties);
+	world.addPart(&fast);
+	world.addPart(&slow);
+	slow.parent->mainPhysical->tickDivisor = 8;
+	SpringLink link({CFrame(), &fast}, {CFrame(), &slow}, 1.0, 5.0);
+	world.addLink(&link);
+
+	for(int tick = 0; tick < 5; tick++) {
+		Position positionBefore = slow.getCFrame().getPosition();
+		world.tick();
+		ASSERT_STRICT(slow.parent->mainPhysical->skippedTicks == 0);
+		ASSERT_TRUE(slow.getCFrame().getPosition() != positionBefore);
+	}
+}
+
+TEST_CASE(contactsBetweenTickDivisorsConserveMomentum) {
+	WorldPrototype world(0.01);
+
+	// overlapping, so the contact pushes them apart in the first tick
+	Part fast(sphereShape(0.5), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	Part slow(sphereShape(0.5), GlobalCFrame(0.9, 0.1, 0.0), basicProperties);
+	world.addPart(&fast);
+	world.addPart(&slow);
+	MotorizedPhysical& fastPhys = *fast.parent->mainPhysical;
+	MotorizedPhysical& slowPhys = *slow.parent->mainPhysical;
+	slowPhys.tickDivisor = 4;
+	slowPhys.skippedTicks = 3;
+
+	for(int tick = 0; tick < 12; tick++) {
+		world.tick();
+		Vec3 momentum = fastPhys.totalMass * fastPhys.getMotion().getVelocity() + slowPhys.totalMass * slowPhys.getMotion().getVelocity();
+		ASSERT(momentum == Vec3(0.0, 0.0, 0.0));
+	}
+	ASSERT_TRUE(slow.getCFrame().getPosition().x > Position(0.9, 0.1, 0.0).x);
+}
+
+// World<Part> overloads clash, the application uses its own subclass of Part as well
+struct SynchronizedTestPart : public Part {
+	using Part::Part;
+	std::uint64_t id = 0;
+};
+
+TEST_CASE(synchronizedWorldRunsDeferredModificationsAtTick) {
+	SynchronizedWorld<SynchronizedTestPart> world(0.01);
+	int modifications = 0;
+	world.syncModification([&world, &modifications]() {
+		// the world is locked, so these are queued instead of run
+		std::thread writer([&world, &modifications]() {
+			for(int i = 0; i < 2000; i++) {
+				world.asyncModification([&modifications]() { modifications++; });
+			}
+		});
+		writer.join();
+	});
+	ASSERT_STRICT(modifications == 0);
+
+	world.tick();
+	ASSERT_STRICT(modifications == 2000);
+	// more than fit in the lock free queue, the rest went through the overflow queue
+	ASSERT_STRICT(world.getQueueStatistics().drainedOperations < 2000);
+	ASSERT_STRICT(world.getQueueStatistics().rejectedPushes == 1);
+
+	world.asyncModification([&modifications]() { modifications++; });
+	ASSERT_STRICT(modifications == 2001);
+}
+
+TEST_CASE(snapshotBufferHandsOverLatestSnapshot) {
+	SnapshotBuffer buffer;
+	ASSERT_STRICT(buffer.acquireLatest().age == 0);
+
+	for(std::size_t age = 1; age <= 3; age++) {
+		buffer.getBackBuffer().age = age;
+		buffer.publish();
+	}
+	// only the last one is seen, the reader's copy stays until something new is published
+	const WorldSnapshot& latest = buffer.acquireLatest();
+	ASSERT_STRICT(latest.age == 3);
+	ASSERT_STRICT(&buffer.acquireLatest() == &latest);
+
+	buffer.getBackBuffer().age = 4;
+	ASSERT_STRICT(&buffer.getBackBuffer() != &latest);
+	buffer.publish();
+	ASSERT_STRICT(latest.age == 3);
+	ASSERT_STRICT(buffer.acquireLatest().age == 4);
+}
+
+// puts the id of every part in its snapshot
+class SnapshotIdWorld : public SynchronizedWorld<SynchronizedTestPart> {
+public:
+	using SynchronizedWorld<SynchronizedTestPart>::SynchronizedWorld;
+	virtual std::uint64_t getSnapshotUserData(const SynchronizedTestPart& part) const override { return part.id; }
+};
+
+TEST_CASE(synchronizedWorldPublishesSnapshotEveryTick) {
+	SnapshotIdWorld world(0.01);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	// owned by the world
+	SynchronizedTestPart* falling = new SynchronizedTestPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(1.0, 2.0, 3.0), basicProperties);
+	falling->id = 42;
+	world.addPart(falling);
+
+	for(int tick = 0; tick < 3; tick++) {
+		world.tick();
+		const WorldSnapshot& snapshot = world.getLatestSnapshot();
+		ASSERT_STRICT(snapshot.age == world.age);
+		ASSERT_STRICT(snapshot.parts.size() == 1);
+		ASSERT_STRICT(snapshot.parts[0].part == falling);
+		ASSERT_STRICT(snapshot.parts[0].userData == 42);
+		ASSERT_STRICT(snapshot.parts[0].cframe.getPosition() == falling->getCFrame().getPosition());
+		ASSERT_TRUE(snapshot.parts[0].previousCFrame.getPosition() != snapshot.parts[0].cframe.getPosition());
+	}
+}
+
+TEST_CASE(worldBatchTicksIndependentCopiesOfTemplate) {
+	WorldPrototype templateWorld(DELTA_T);
+	DirectionalGravity gravity(Vec3(0, -10, 0));
+	templateWorld.addExternalForce(&gravity);
+	Part floor(boxShape(20.0, 1.0, 20.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	templateWorld.addTerrainPart(&floor);
+	Part polyhedron(polyhedronShape(Library::createBox(1.0, 1.0, 1.0)), GlobalCFrame(0.0, 0.6, 0.0, Rotation::fromEulerAngles(0.0, 0.3, 0.0)), basicProperties);
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.1, 1.8, 0.0), basicProperties);
+	templateWorld.addPart(&polyhedron);
+	templateWorld.addPart(&box);
+
+	Util::ThreadPool threadPool(4);
+	WorldBatch batch(templateWorld, 6, &threadPool);
+	WorldBatch reference(templateWorld, 1);
+	uint64_t initialHash = reference[0].getStateHash();
+
+	// the polyhedron is shared with the template instead of copied into every world
+	ASSERT_STRICT(batch.getSharedShapeClasses().size() == 1);
+	for(std::size_t i = 0; i < batch.size(); i++) {
+		ASSERT_STRICT(batch[i].getPartCount() == 3);
+		ASSERT_STRICT(batch[i].getStateHash() == initialHash);
+		std::size_t partsWithSharedClass = 0;
+		for(const Part& part : batch[i].iterParts()) {
+			if(part.hitbox.baseShape == polyhedron.hitbox.baseShape) partsWithSharedClass++;
+		}
+		ASSERT_STRICT(partsWithSharedClass == 1);
+	}
+
+	batch[2].physicals[0]->motionOfCenterOfMass = Motion(Vec3(1.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+	batch.tick(30);
+	reference.tick(30);
+
+	for(std::size_t i = 0; i < batch.size(); i++) {
+		ASSERT_STRICT(batch[i].age == 30);
+		if(i != 2) {
+			ASSERT_STRICT(batch[i].getStateHash() == reference[0].getStateHash());
+		}
+	}
+	ASSERT_FALSE(batch[2].getStateHash() == reference[0].getStateHash());
+	ASSERT_STRICT(batch.getWorldTicks() == 6 * 30);
+	ASSERT_TRUE(batch.getWorldTicksPerSecond() > 0.0);
+
+	batch.reset(2);
+	ASSERT_STRICT(batch[2].age == 0);
+	ASSERT_STRICT(batch[2].getPartCount() == 3);
+	ASSERT_STRICT(batch[2].externalForces.size() == 1);
+	ASSERT_STRICT(batch[2].getStateHash() == initialHash);
+}
+
+TEST_CASE(worldReusesPooledPartsAfterClear) {
+	WorldPrototype world(DELTA_T);
+	std::set<Part*> firstParts;
+	for(int i = 0; i < 64; i++) {
+		Part* part = world.createPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame((i % 8) * 2.0, 0.0, (i / 8) * 2.0), basicProperties);
+		world.addPart(part);
+		firstParts.insert(part);
+	}
+	world.tick();
+	ASSERT_STRICT(world.getPartCount() == 64);
+
+	world.clear();
+	ASSERT_STRICT(world.getPartCount() == 0);
+
+	// the cleared parts are given back to the pool of the world, the new ones take their place
+	for(int i = 0; i < 64; i++) {
+		Part* part = world.createPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame((i % 8) * 2.0, 5.0, (i / 8) * 2.0), basicProperties);
+		ASSERT_TRUE(firstParts.count(part) == 1);
+		world.addPart(part);
+	}
+	world.tick();
+	ASSERT_STRICT(world.getPartCount() == 64);
+	world.clear();
+}
+
+TEST_CASE(reorderPhysicalsSpatiallyFollowsMortonOrder) {
+	WorldPrototype world(DELTA_T);
+	Part floor(boxShape(20.0, 1.0, 20.0), GlobalCFrame(0.0, -5.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+	std::vector<Part> parts;
+	parts.reserve(64);
+	// a 4x4x4 grid, added in scrambled order
+	for(int i = 0; i < 64; i++) {
+		int cell = (i * 37) % 64;
+		parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame((cell % 4) * 2.0, (cell / 4 % 4) * 2.0, (cell / 16) * 2.0), basicProperties);
+	}
+	for(Part& part : parts) {
+		world.addPart(&part);
+	}
+	std::set<MotorizedPhysical*> physicalsBefore(world.physicals.begin(), world.physicals.end());
+
+	world.reorderPhysicalsSpatially();
+
+	std::set<MotorizedPhysical*> physicalsAfter(world.physicals.begin(), world.physicals.end());
+	ASSERT_TRUE(physicalsBefore == physicalsAfter);
+	ASSERT_STRICT(world.physicals.size() == 64);
+	// every block of 8 along the curve is one 2x2x2 octant of the grid
+	for(std::size_t block = 0; block < 8; block++) {
+		Position corner = world.physicals[block * 8]->getMainPart()->getPosition();
+		for(std::size_t i = block * 8; i < block * 8 + 8; i++) {
+			Position position = world.physicals[i]->getMainPart()->getPosition();
+			ASSERT_TRUE(std::abs(double(position.x) - double(corner.x)) <= 2.0);
+			ASSERT_TRUE(std::abs(double(position.y) - double(corner.y)) <= 2.0);
+			ASSERT_TRUE(std::abs(double(position.z) - double(corner.z)) <= 2.0);
+		}
+	}
+	Position first = world.physicals.front()->getMainPart()->getPosition();
+	Position last = world.physicals.back()->getMainPart()->getPosition();
+	ASSERT_TRUE(double(first.x) == 0.0 && double(first.y) == 0.0 && double(first.z) == 0.0);
+	ASSERT_TRUE(double(last.x) == 6.0 && double(last.y) == 6.0 && double(last.z) == 6.0);
+
+	// the periodic pass at the end of the tick
+	world.spatialReorderInterval = 2;
+	for(int i = 0; i < 4; i++) {
+		world.tick();
+	}
+	ASSERT_STRICT(world.physicals.size() == 64);
+	ASSERT_TRUE(world.isValid());
+}
+
+TEST_CASE(worldReusesItsPhysicalsAfterClear) {
+	WorldPrototype world(DELTA_T);
+	std::set<MotorizedPhysical*> firstPhysicals;
+	for(int i = 0; i < 32; i++) {
+		Part* part = world.createPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(i * 2.0, 0.0, 0.0), basicProperties);
+		world.addPart(part);
+		if(i % 2 == 1) {
+			Part* attached = world.createPart(boxShape(0.5, 0.5, 0.5), GlobalCFrame(i * 2.0, 1.0, 0.0), basicProperties);
+			part->attach(attached, CFrame(0.0, 0.75, 0.0));
+			// splits off a physical of its own, made in the pool of the world
+			attached->detach();
+		}
+	}
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		firstPhysicals.insert(phys);
+	}
+	ASSERT_STRICT(firstPhysicals.size() == 48);
+	world.tick();
+
+	// the physicals are given back to the pool of the world with the parts, the new ones take their place
+	world.clear();
+	for(int i = 0; i < 48; i++) {
+		world.addPart(world.createPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(i * 2.0, 5.0, 0.0), basicProperties));
+	}
+	for(MotorizedPhysical* phys : world.iterPhysicals()) {
+		ASSERT_TRUE(firstPhysicals.count(phys) == 1);
+	}
+	world.tick();
+	world.clear();
+}
+
+TEST_CASE(pooledPhysicalCantGoIntoAnotherWorld) {
+	WorldPrototype poolWorld(DELTA_T);
+	WorldPrototype otherWorld(DELTA_T);
+	Part part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	MotorizedPhysical::create(&poolWorld, &part);
+
+	// poolWorld would destroy the physical when it is cleared, while otherWorld still holds it
+	bool caught = false;
+	try {
+		otherWorld.addPart(&part);
+	} catch(const std::logic_error&) {
+		caught = true;
+	}
+	ASSERT_TRUE(caught);
+	ASSERT_TRUE(otherWorld.physicals.empty());
+	ASSERT_TRUE(part.layer == nullptr);
+}
+
+struct DestructionCountingPart : public Part {
+	using Part::Part;
+	int* destroyedCount = nullptr;
+	~DestructionCountingPart() { (*destroyedCount)++; }
+};
+
+TEST_CASE(worldDestroysPooledPartsWithoutClear) {
+	int destroyedCount = 0;
+	Part outlivingPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(-5.0, 0.0, 0.0), basicProperties);
+	{
+		WorldPrototype world(DELTA_T);
+		for(int i = 0; i < 10; i++) {
+			DestructionCountingPart* part = world.createPart<DestructionCountingPart>(boxShape(1.0, 1.0, 1.0), GlobalCFrame(i * 2.0, 0.0, 0.0), basicProperties);
+			part->destroyedCount = &destroyedCount;
+			world.addPart(part);
+		}
+		world.addPart(&outlivingPart);
+		world.tick();
+	}
+	ASSERT_STRICT(destroyedCount == 10);
+	// the world let go of the part, its destructor no longer touches the world
+	ASSERT_TRUE(outlivingPart.parent == nullptr);
+	ASSERT_TRUE(outlivingPart.layer == nullptr);
+}
+
+// a row of overlapping boxes along x, and a pair of boxes sliding along the whole row, the first of them with a second part on top
+static void buildRegionTestWorld(WorldPrototype& world, Part& floor, std::vector<Part>& parts) {
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	world.addTerrainPart(&floor);
+
+	parts.reserve(43);
+	for(int pile = 0; pile < 20; pile++) {
+		for(int height = 0; height < 2; height++) {
+			parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(pile * 0.9 - 9.0, 0.45 + height * 0.95, 0.0, Rotation::fromEulerAngles(0.0, pile * 0.1, 0.0)), basicProperties);
+		}
+	}
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(-12.0, 0.5, 3.0), basicProperties);
+	parts.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(12.0, 0.5, -3.0), basicProperties);
+	parts.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame(-12.0, 1.25, 3.0), basicProperties);
+	parts[40].attach(&parts[42], CFrame(0.0, 0.75, 0.0));
+	for(int i = 0; i < 42; i++) {
+		world.addPart(&parts[i]);
+	}
+	world.physicals[40]->motionOfCenterOfMass = Motion(Vec3(20.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+	world.physicals[41]->motionOfCenterOfMass = Motion(Vec3(-20.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+}
+
+static std::set<std::pair<int, int>> getColissionPairs(const std::vector<Colission>& colissions, const std::vector<Part>& parts) {
+	std::set<std::pair<int, int>> result;
+	for(const Colission& colission : colissions) {
+		// the floor isn't in parts, it gets index -1
+		int a = colission.p1 >= &parts.front() && colission.p1 <= &parts.back() ? int(colission.p1 - &parts.front()) : -1;
+		int b = colission.p2 >= &parts.front() && colission.p2 <= &parts.back() ? int(colission.p2 - &parts.front()) : -1;
+		result.emplace(std::min(a, b), std::max(a, b));
+	}
+	return result;
+}
+
+TEST_CASE(worldRegionsFindTheSameColissionsAsTheLayers) {
+	WorldPrototype layerWorld(DELTA_T);
+	Part layerFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> layerParts;
+	buildRegionTestWorld(layerWorld, layerFloor, layerParts);
+
+	WorldPrototype regionWorld(DELTA_T);
+	Part regionFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> regionParts;
+	buildRegionTestWorld(regionWorld, regionFloor, regionParts);
+	regionWorld.regions.regionCount = 4;
+
+	layerWorld.tick();
+	regionWorld.tick();
+
+	ASSERT_STRICT(regionWorld.regions.getActiveRegionCount() == 4);
+	for(std::size_t i = 0; i < 4; i++) {
+		ASSERT_TRUE(regionWorld.regions.getMemberCount(i) > 0);
+	}
+	std::set<std::pair<int, int>> layerPairs = getColissionPairs(layerWorld.curColissions.freePartColissions, layerParts);
+	std::set<std::pair<int, int>> regionPairs = getColissionPairs(regionWorld.curColissions.freePartColissions, regionParts);
+	ASSERT_TRUE(layerPairs.size() > 20);
+	ASSERT_TRUE(layerPairs == regionPairs);
+	ASSERT_STRICT(layerWorld.curColissions.freePartColissions.size() == regionWorld.curColissions.freePartColissions.size());
+	ASSERT_TRUE(getColissionPairs(layerWorld.curColissions.freeTerrainColissions, layerParts) == getColissionPairs(regionWorld.curColissions.freeTerrainColissions, regionParts));
+}
+
+// a row of separate boxes along x, with a plank lying on all of them, attached to a small box past the upper end of the row
+// so the plank reaches from the last region down into all the others
+static void buildSpanningPlankWorld(WorldPrototype& world, Part& floor, std::vector<Part>& parts) {
+	world.addTerrainPart(&floor);
+
+	parts.reserve(34);
+	for(int i = 0; i < 32; i++) {
+		parts.emplace_back(boxShape(0.8, 0.8, 0.8), GlobalCFrame(i * 1.0, 0.4, 0.0), basicProperties);
+	}
+	parts.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame(33.0, 0.25, 0.0), basicProperties);
+	parts.emplace_back(boxShape(34.0, 0.2, 1.0), GlobalCFrame(15.5, 0.85, 0.0), basicProperties);
+	parts[32].attach(&parts[33], CFrame(-17.5, 0.6, 0.0));
+	for(int i = 0; i < 33; i++) {
+		world.addPart(&parts[i]);
+	}
+}
+
+TEST_CASE(worldRegionsFindColissionsOfPhysicalsSpanningManyRegions) {
+	WorldPrototype layerWorld(DELTA_T);
+	Part layerFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> layerParts;
+	buildSpanningPlankWorld(layerWorld, layerFloor, layerParts);
+
+	WorldPrototype regionWorld(DELTA_T);
+	Part regionFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> regionParts;
+	buildSpanningPlankWorld(regionWorld, regionFloor, regionParts);
+	regionWorld.regions.regionCount = 8;
+
+	layerWorld.tick();
+	regionWorld.tick();
+
+	ASSERT_STRICT(regionWorld.regions.getActiveRegionCount() == 8);
+	std::set<std::pair<int, int>> layerPairs = getColissionPairs(layerWorld.curColissions.freePartColissions, layerParts);
+	std::set<std::pair<int, int>> regionPairs = getColissionPairs(regionWorld.curColissions.freePartColissions, regionParts);
+	// the plank touches every box of the row
+	ASSERT_STRICT(layerPairs.size() == 32);
+	ASSERT_TRUE(layerPairs == regionPairs);
+}
+
+static void buildRegionsOfThree(WorldPrototype& world, Part& floor, std::vector<Part>& parts) {
+	buildRegionTestWorld(world, floor, parts);
+	world.regions.regionCount = 3;
+}
+
+TEST_CASE(worldRegionsMigratePhysicalsDeterministically) {
+	std::size_t migrationCount = 0;
+	bool everyPhysicalInARegion = false;
+	auto countMigrations = [&migrationCount, &everyPhysicalInARegion](const WorldPrototype& world) {
+		std::size_t memberCount = 0;
+		for(std::size_t i = 0; i < world.regions.getActiveRegionCount(); i++) {
+			memberCount += world.regions.getMemberCount(i);
+		}
+		everyPhysicalInARegion = memberCount == world.physicals.size();
+		migrationCount = world.regions.getMigrationCount();
+	};
+
+	SimulationResult serial = simulateWorld(nullptr, 60, buildRegionsOfThree, countMigrations);
+	std::size_t serialMigrations = migrationCount;
+	ASSERT_TRUE(serialMigrations >= 2);
+	ASSERT_TRUE(everyPhysicalInARegion);
+
+	for(std::size_t threadCount : {1, 2, 3}) {
+		Util::ThreadPool threadPool(threadCount);
+		SimulationResult parallel = simulateWorld(&threadPool, 60, buildRegionsOfThree, countMigrations);
+		ASSERT_STRICT(migrationCount == serialMigrations);
+		ASSERT_TRUE(everyPhysicalInARegion);
+		ASSERT_TRUE(serial.stateHashes == parallel.stateHashes);
+	}
+}
+
+TEST_CASE(worldRegionsFollowPartsAddedMovedAndRemovedBetweenTicks) {
+	WorldPrototype layerWorld(DELTA_T);
+	Part layerFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> layerParts;
+	buildRegionTestWorld(layerWorld, layerFloor, layerParts);
+
+	WorldPrototype regionWorld(DELTA_T);
+	Part regionFloor(boxShape(100.0, 1.0, 100.0), GlobalCFrame(0.0, -0.5, 0.0), basicProperties);
+	std::vector<Part> regionParts;
+	buildRegionTestWorld(regionWorld, regionFloor, regionParts);
+	regionWorld.regions.regionCount = 4;
+
+	layerWorld.tick();
+	regionWorld.tick();
+	std::size_t rebuildCount = regionWorld.regions.getRebuildCount();
+	ASSERT_STRICT(rebuildCount == 1);
+
+	// a box dropped on top of the first pile, a box taken out of the middle and one moved onto the last pile
+	Part layerTopBox(boxShape(1.0, 1.0, 1.0), GlobalCFrame(-9.0, 2.3, 0.0), basicProperties);
+	Part regionTopBox(boxShape(1.0, 1.0, 1.0), GlobalCFrame(-9.0, 2.3, 0.0), basicProperties);
+	for(WorldPrototype* world : {&layerWorld, &regionWorld}) {
+		std::vector<Part>& parts = world == &layerWorld ? layerParts : regionParts;
+		world->addPart(world == &layerWorld ? &layerTopBox : &regionTopBox);
+		world->removePart(&parts[20]);
+		parts[21].setCFrame(GlobalCFrame(8.1, 2.3, 0.0));
+	}
+	layerWorld.tick();
+	regionWorld.tick();
+
+	ASSERT_STRICT(regionWorld.regions.getRebuildCount() == rebuildCount);
+	std::size_t memberCount = 0;
+	for(std::size_t i = 0; i < regionWorld.regions.getActiveRegionCount(); i++) {
+		memberCount += regionWorld.regions.getMemberCount(i);
+	}
+	ASSERT_STRICT(memberCount == regionWorld.physicals.size());
+	ASSERT_TRUE(getColissionPairs(layerWorld.curColissions.freePartColissions, layerParts) == getColissionPairs(regionWorld.curColissions.freePartColissions, regionParts));
+	ASSERT_STRICT(layerWorld.curColissions.freePartColissions.size() == regionWorld.curColissions.freePartColissions.size());
+
+	// attaching a part regroups the layer, the regions can't follow that and rebuild
+	Part layerHat(boxShape(0.5, 0.5, 0.5), GlobalCFrame(), basicProperties);
+	Part regionHat(boxShape(0.5, 0.5, 0.5), GlobalCFrame(), basicProperties);
+	layerParts[0].attach(&layerHat, CFrame(0.0, 0.75, 0.0));
+	regionParts[0].attach(&regionHat, CFrame(0.0, 0.75, 0.0));
+	layerWorld.tick();
+	regionWorld.tick();
+
+	ASSERT_STRICT(regionWorld.regions.getRebuildCount() == rebuildCount + 1);
+	ASSERT_STRICT(layerWorld.curColissions.freePartColissions.size() == regionWorld.curColissions.freePartColissions.size());
+}
+
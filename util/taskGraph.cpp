@@ -0,0 +1,247 @@
+#include "taskGraph.h"
+
+#include "threadPool.h"
+
+#include <thread>
+
+namespace Util {
+
+static thread_local bool onCallingThread = false;
+
+// times an idle thread yields and looks for work again before it goes to sleep
+static constexpr std::size_t SPINS_BEFORE_WAIT = 64;
+
+static std::int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TaskGraph::Task::Task(Task&& other) noexcept :
+	name(other.name),
+	func(std::move(other.func)),
+	count(std::move(other.count)),
+	parallelFunc(std::move(other.parallelFunc)),
+	runOnCaller(other.runOnCaller),
+	successors(std::move(other.successors)),
+	dependencyCount(other.dependencyCount),
+	lastCount(other.lastCount) {}
+
+void TaskGraph::WorkQueue::push(WorkItem item) {
+	std::lock_guard<std::mutex> lg(lock);
+	items.push_back(item);
+}
+bool TaskGraph::WorkQueue::popBack(WorkItem& result) {
+	std::lock_guard<std::mutex> lg(lock);
+	if(front == items.size()) return false;
+	result = items.back();
+	items.pop_back();
+	if(front == items.size()) {
+		items.clear();
+		front = 0;
+	}
+	return true;
+}
+bool TaskGraph::WorkQueue::popFront(WorkItem& result) {
+	std::lock_guard<std::mutex> lg(lock);
+	if(front == items.size()) return false;
+	result = items[front++];
+	if(front == items.size()) {
+		items.clear();
+		front = 0;
+	}
+	return true;
+}
+
+TaskGraph::TaskID TaskGraph::addTask(const char* name, std::function<void()> func, bool runOnCaller) {
+	tasks.emplace_back(name, runOnCaller);
+	tasks.back().func = std::move(func);
+	return tasks.size() - 1;
+}
+TaskGraph::TaskID TaskGraph::addParallelTask(const char* name, std::function<std::size_t()> count, std::function<void(std::size_t)> func) {
+	tasks.emplace_back(name, false);
+	tasks.back().count = std::move(count);
+	tasks.back().parallelFunc = std::move(func);
+	return tasks.size() - 1;
+}
+void TaskGraph::addDependency(TaskID before, TaskID after) {
+	if(before >= after) {
+		throw "A task may only depend on tasks added before it";
+	}
+	tasks[before].successors.push_back(after);
+	tasks[after].dependencyCount++;
+}
+
+bool TaskGraph::isOnCallingThread() {
+	return onCallingThread;
+}
+
+void TaskGraph::makeReady(TaskID taskID, std::size_t queueIndex) {
+	Task& task = tasks[taskID];
+	if(!task.parallelFunc) {
+		task.lastCount = 1;
+		task.remainingIndices.store(1, std::memory_order_relaxed);
+		(task.runOnCaller ? callerQueue : queues[queueIndex]).push(WorkItem{taskID, 0});
+		wakeWaitingThreads();
+		return;
+	}
+
+	std::size_t count = 0;
+	try {
+		count = task.count();
+	} catch(...) {
+		std::lock_guard<std::mutex> lg(exceptionLock);
+		if(firstException == nullptr) firstException = std::current_exception();
+	}
+	task.lastCount = count;
+	if(count == 0) {
+		finishTask(taskID, queueIndex);
+		return;
+	}
+	task.remainingIndices.store(count, std::memory_order_relaxed);
+	WorkQueue& queue = queues[queueIndex];
+	{
+		std::lock_guard<std::mutex> lg(queue.lock);
+		// reversed, so the owner starts at index 0 and thieves take the last indices
+		for(std::size_t i = count; i-- > 0;) {
+			queue.items.push_back(WorkItem{taskID, i});
+		}
+	}
+	wakeWaitingThreads();
+}
+
+void TaskGraph::wakeWaitingThreads() {
+	{
+		std::lock_guard<std::mutex> lg(wakeLock);
+		workVersion.fetch_add(1, std::memory_order_release);
+	}
+	// all of them, the new work may be for the calling thread only, and a parallel task has work for every thread
+	wakeCondition.notify_all();
+}
+
+void TaskGraph::finishTask(TaskID taskID, std::size_t queueIndex) {
+	Task& task = tasks[taskID];
+	if(task.startTime.load(std::memory_order_relaxed) == 0) {
+		std::int64_t time = now();
+		task.startTime.store(time, std::memory_order_relaxed);
+		task.endTime.store(time, std::memory_order_relaxed);
+	}
+	for(TaskID successor : task.successors) {
+		if(tasks[successor].remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			makeReady(successor, queueIndex);
+		}
+	}
+	// only after the successors are queued, so no thread sees the graph as done too early
+	if(remainingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		wakeWaitingThreads();
+	}
+}
+
+void TaskGraph::runItem(WorkItem item, std::size_t queueIndex) {
+	Task& task = tasks[item.task];
+
+	std::int64_t start = now();
+	std::int64_t earliestStart = task.startTime.load(std::memory_order_relaxed);
+	while((earliestStart == 0 || start < earliestStart) && !task.startTime.compare_exchange_weak(earliestStart, start, std::memory_order_relaxed));
+
+	try {
+		if(task.parallelFunc) {
+			task.parallelFunc(item.index);
+		} else {
+			task.func();
+		}
+	} catch(...) {
+		std::lock_guard<std::mutex> lg(exceptionLock);
+		if(firstException == nullptr) firstException = std::current_exception();
+	}
+
+	std::int64_t end = now();
+	std::int64_t latestEnd = task.endTime.load(std::memory_order_relaxed);
+	while(end > latestEnd && !task.endTime.compare_exchange_weak(latestEnd, end, std::memory_order_relaxed));
+
+	if(task.remainingIndices.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		finishTask(item.task, queueIndex);
+	}
+}
+
+bool TaskGraph::findWork(WorkItem& result, std::size_t queueIndex, bool isCaller) {
+	if(isCaller && callerQueue.popBack(result)) return true;
+	if(queues[queueIndex].popBack(result)) return true;
+	for(std::size_t offset = 1; offset < runThreadCount; offset++) {
+		if(queues[(queueIndex + offset) % runThreadCount].popFront(result)) return true;
+	}
+	return false;
+}
+
+void TaskGraph::workerLoop(std::size_t queueIndex, bool isCaller) {
+	bool wasOnCallingThread = onCallingThread;
+	onCallingThread = isCaller;
+	std::size_t idleSpins = 0;
+	while(remainingTasks.load(std::memory_order_acquire) != 0) {
+		// read before looking for work, so work queued after the search has a newer version and the wait below doesn't miss it
+		std::uint64_t seenVersion = workVersion.load(std::memory_order_acquire);
+		WorkItem item;
+		if(findWork(item, queueIndex, isCaller)) {
+			idleSpins = 0;
+			runItem(item, queueIndex);
+		} else if(idleSpins < SPINS_BEFORE_WAIT) {
+			idleSpins++;
+			std::this_thread::yield();
+		} else {
+			std::unique_lock<std::mutex> lk(wakeLock);
+			wakeCondition.wait(lk, [this, seenVersion]() {
+				return workVersion.load(std::memory_order_acquire) != seenVersion || remainingTasks.load(std::memory_order_acquire) == 0;
+			});
+			idleSpins = 0;
+		}
+	}
+	onCallingThread = wasOnCallingThread;
+}
+
+void TaskGraph::run(ThreadPool* pool) {
+	runThreadCount = (pool != nullptr) ? pool->getThreadCount() : 1;
+	if(queueCount < runThreadCount) {
+		queues.reset(new WorkQueue[runThreadCount]);
+		queueCount = runThreadCount;
+	}
+
+	for(Task& task : tasks) {
+		task.remainingDependencies.store(task.dependencyCount, std::memory_order_relaxed);
+		task.startTime.store(0, std::memory_order_relaxed);
+		task.endTime.store(0, std::memory_order_relaxed);
+		task.lastCount = 0;
+	}
+	remainingTasks.store(tasks.size(), std::memory_order_relaxed);
+	firstException = nullptr;
+	runStartTime = now();
+
+	for(TaskID i = 0; i < tasks.size(); i++) {
+		if(tasks[i].dependencyCount == 0) {
+			makeReady(i, 0);
+		}
+	}
+
+	std::thread::id callingThread = std::this_thread::get_id();
+	if(pool != nullptr) {
+		// every thread stays in its loop until the graph is done, so the calling thread always gets one of the loops
+		pool->parallelFor(runThreadCount, [this, callingThread](std::size_t i) {
+			workerLoop(i, std::this_thread::get_id() == callingThread);
+		});
+	} else {
+		workerLoop(0, true);
+	}
+
+	profile.resize(tasks.size());
+	for(TaskID i = 0; i < tasks.size(); i++) {
+		const Task& task = tasks[i];
+		profile[i] = TaskProfile{task.name,
+			std::chrono::nanoseconds(task.startTime.load(std::memory_order_relaxed) - runStartTime),
+			std::chrono::nanoseconds(task.endTime.load(std::memory_order_relaxed) - runStartTime),
+			task.lastCount};
+	}
+
+	if(firstException != nullptr) {
+		std::exception_ptr exception = firstException;
+		firstException = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+};
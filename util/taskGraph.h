@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace Util {
+
+class ThreadPool;
+
+/*
+	A fixed graph of tasks which is run on the threads of a ThreadPool, every task starts once all tasks it depends on are done
+
+	Parallel tasks run func(i) for every i in [0, count()), count is only asked for when the task becomes ready,
+	so it may depend on the results of earlier tasks. Tasks that follow a parallel task wait for all of its indices
+
+	Every thread has its own deque of ready work: it takes the newest work from its own deque, and steals the oldest work from
+	the others when it runs out. Work which a finished task makes ready goes to the deque of the thread which finished it
+	Tasks added with runOnCaller only ever run on the thread which called run(), for work that isn't thread safe like profiler marks
+	A thread without work spins for a short while, then sleeps until a task becomes ready or the graph is done
+
+	The graph is built once and can be run any number of times, after the first run it doesn't allocate anymore as long as the counts don't grow
+	Within a task parallelFor of the pool runs serially, the graph itself is the source of parallelism
+*/
+class TaskGraph {
+public:
+	typedef std::size_t TaskID;
+
+	// timing of a task during the last run, relative to the start of that run
+	struct TaskProfile {
+		const char* name;
+		std::chrono::nanoseconds start;
+		std::chrono::nanoseconds end;
+		std::size_t count;
+	};
+
+private:
+	struct Task {
+		const char* name;
+		std::function<void()> func;
+		std::function<std::size_t()> count;
+		std::function<void(std::size_t)> parallelFunc;
+		bool runOnCaller;
+		std::vector<TaskID> successors;
+		std::size_t dependencyCount = 0;
+
+		std::atomic<std::size_t> remainingDependencies{0};
+		std::atomic<std::size_t> remainingIndices{0};
+		std::atomic<std::int64_t> startTime{0};
+		std::atomic<std::int64_t> endTime{0};
+		std::size_t lastCount = 0;
+
+		Task(const char* name, bool runOnCaller) : name(name), runOnCaller(runOnCaller) {}
+		Task(Task&& other) noexcept;
+	};
+	struct WorkItem {
+		TaskID task;
+		std::size_t index;
+	};
+	// deque of ready work, the owner pushes and pops at the back, thieves take from the front
+	struct WorkQueue {
+		std::mutex lock;
+		std::vector<WorkItem> items;
+		std::size_t front = 0;
+
+		void push(WorkItem item);
+		bool popBack(WorkItem& result);
+		bool popFront(WorkItem& result);
+	};
+
+	std::vector<Task> tasks;
+	// one per thread of the last run, kept to reuse the memory of their items
+	std::unique_ptr<WorkQueue[]> queues;
+	std::size_t queueCount = 0;
+	std::size_t runThreadCount = 1;
+	WorkQueue callerQueue;
+
+	std::atomic<std::size_t> remainingTasks{0};
+	// bumped under wakeLock whenever work is queued or the graph is done, idle threads wait on wakeCondition for it to change
+	std::atomic<std::uint64_t> workVersion{0};
+	std::mutex wakeLock;
+	std::condition_variable wakeCondition;
+	std::int64_t runStartTime = 0;
+	std::mutex exceptionLock;
+	std::exception_ptr firstException = nullptr;
+	std::vector<TaskProfile> profile;
+
+	void workerLoop(std::size_t queueIndex, bool isCaller);
+	void runItem(WorkItem item, std::size_t queueIndex);
+	void makeReady(TaskID task, std::size_t queueIndex);
+	void finishTask(TaskID task, std::size_t queueIndex);
+	bool findWork(WorkItem& result, std::size_t queueIndex, bool isCaller);
+	void wakeWaitingThreads();
+
+public:
+	TaskGraph() = default;
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	TaskID addTask(const char* name, std::function<void()> func, bool runOnCaller = false);
+	TaskID addParallelTask(const char* name, std::function<std::size_t()> count, std::function<void(std::size_t)> func);
+	// after only starts once before is done, before must have been added first, which keeps the graph free of cycles
+	void addDependency(TaskID before, TaskID after);
+
+	inline std::size_t size() const { return tasks.size(); }
+	inline bool empty() const { return tasks.empty(); }
+
+	/*
+		Runs all tasks on the threads of pool, or on the calling thread if pool is nullptr, and blocks until they are done
+		The first exception thrown by a task is rethrown here, after all other tasks have finished
+	*/
+	void run(ThreadPool* pool);
+
+	// true while inside a task run by the thread which called run()
+	static bool isOnCallingThread();
+
+	// one entry per task, in the order the tasks were added
+	inline const std::vector<TaskProfile>& getProfile() const { return profile; }
+};
+};
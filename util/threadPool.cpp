@@ -0,0 +1,103 @@
+#include "threadPool.h"
+
+namespace Util {
+
+static thread_local bool insideJob = false;
+
+bool ThreadPool::isInsideJob() {
+	return insideJob;
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount) {
+	if(threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	if(threadCount == 0) {
+		threadCount = 1;
+	}
+	workers.reserve(threadCount - 1);
+	for(std::size_t i = 0; i < threadCount - 1; i++) {
+		workers.emplace_back([this]() { this->workerLoop(); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lg(stateLock);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for(std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void ThreadPool::runAvailableIndices() {
+	bool wasInsideJob = insideJob;
+	insideJob = true;
+	while(true) {
+		std::size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+		if(index >= jobSize) break;
+		try {
+			jobFunc(job, index);
+		} catch(...) {
+			std::lock_guard<std::mutex> lg(stateLock);
+			if(firstException == nullptr) firstException = std::current_exception();
+		}
+	}
+	insideJob = wasInsideJob;
+}
+
+void ThreadPool::workerLoop() {
+	std::size_t seenGeneration = 0;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(stateLock);
+			wakeCondition.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+			if(stopping) return;
+			seenGeneration = generation;
+		}
+
+		runAvailableIndices();
+
+		{
+			std::lock_guard<std::mutex> lg(stateLock);
+			activeWorkers--;
+			if(activeWorkers == 0) doneCondition.notify_one();
+		}
+	}
+}
+
+void ThreadPool::dispatch(void(*jobFunc)(const void* job, std::size_t index), const void* job, std::size_t jobSize) {
+	std::lock_guard<std::mutex> dispatchGuard(dispatchLock);
+
+	{
+		std::lock_guard<std::mutex> lg(stateLock);
+		this->jobFunc = jobFunc;
+		this->job = job;
+		this->jobSize = jobSize;
+		this->nextIndex.store(0, std::memory_order_relaxed);
+		this->activeWorkers = workers.size();
+		this->firstException = nullptr;
+		this->generation++;
+	}
+	wakeCondition.notify_all();
+
+	runAvailableIndices();
+
+	std::exception_ptr exception;
+	{
+		std::unique_lock<std::mutex> lock(stateLock);
+		doneCondition.wait(lock, [this]() { return activeWorkers == 0; });
+		this->jobFunc = nullptr;
+		this->job = nullptr;
+		this->jobSize = 0;
+		exception = this->firstException;
+		this->firstException = nullptr;
+	}
+
+	if(exception != nullptr) {
+		std::rethrow_exception(exception);
+	}
+}
+};
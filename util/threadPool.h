@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <condition_variable>
+
+namespace Util {
+
+/*
+	A fixed set of worker threads which run index-based jobs
+
+	The calling thread always participates in the job, so a pool with threadCount 1 has no workers and runs everything inline
+	parallelFor may be called from within a job, in which case it simply runs serially on the current thread
+*/
+class ThreadPool {
+	std::vector<std::thread> workers;
+
+	std::mutex dispatchLock;
+	std::mutex stateLock;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	void(*jobFunc)(const void* job, std::size_t index) = nullptr;
+	const void* job = nullptr;
+	std::size_t jobSize = 0;
+	std::atomic<std::size_t> nextIndex{0};
+	std::size_t activeWorkers = 0;
+	std::size_t generation = 0;
+	bool stopping = false;
+	std::exception_ptr firstException = nullptr;
+
+	void workerLoop();
+	void runAvailableIndices();
+	void dispatch(void(*jobFunc)(const void* job, std::size_t index), const void* job, std::size_t jobSize);
+
+	static bool isInsideJob();
+public:
+	/*
+		threadCount is the total number of threads working on a job, including the caller
+		0 means std::thread::hardware_concurrency()
+	*/
+	explicit ThreadPool(std::size_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	inline std::size_t getThreadCount() const { return workers.size() + 1; }
+
+	/*
+		Calls func(i) for every i in [0, count), spread over all threads of this pool
+		Blocks until all indices have been processed, the first exception thrown by func is rethrown here
+	*/
+	template<typename Func>
+	void parallelFor(std::size_t count, const Func& func) {
+		if(workers.empty() || count <= 1 || isInsideJob()) {
+			for(std::size_t i = 0; i < count; i++) {
+				func(i);
+			}
+			return;
+		}
+		dispatch([](const void* f, std::size_t index) {
+			(*static_cast<const Func*>(f))(index);
+		}, &func, count);
+	}
+};
+};
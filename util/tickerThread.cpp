@@ -0,0 +1,79 @@
+#include "tickerThread.h"
+
+#include "log.h"
+
+namespace Util {
+
+using namespace std::chrono;
+TickerThread::TickerThread(double targetTPS, milliseconds tickSkipTimeout, std::function<void()> tickAction) {
+	this->TPS = targetTPS;
+	this->tickSkipTimeout = tickSkipTimeout;
+	this->tickAction = std::move(tickAction);
+}
+
+TickerThread::~TickerThread() {
+	this->stop();
+}
+
+void TickerThread::start() {
+	this->stopped = false;
+
+	this->thread = std::thread([this] () {
+		time_point<steady_clock> lastTime = steady_clock::now();
+		duration<double> accumulated(0.0);
+
+		while (!(this->stopped)) {
+			if (this->TPS <= 0.0) {
+				// unlimited, the accumulator is skipped and always counts as empty
+				this->tickAction();
+				lastTime = steady_clock::now();
+				accumulated = duration<double>(0.0);
+				this->accumulatorEmptyTime.store(duration_cast<nanoseconds>(lastTime.time_since_epoch()).count(), std::memory_order_relaxed);
+				continue;
+			}
+
+			duration<double> tickTime(1.0 / this->TPS);
+
+			time_point<steady_clock> curTime = steady_clock::now();
+			accumulated += (curTime - lastTime) * this->speed;
+			lastTime = curTime;
+
+			if (accumulated > this->tickSkipTimeout) {
+				// We're behind schedule
+				Log::warn("Can't keep up! Skipping %d ticks!", (int) (accumulated / tickTime) - 1);
+				accumulated = tickTime;
+			}
+
+			while (accumulated >= tickTime && !(this->stopped)) {
+				this->tickAction();
+				accumulated -= tickTime;
+			}
+
+			time_point<steady_clock> accumulatorEmpty = lastTime - duration_cast<steady_clock::duration>(accumulated / this->speed);
+			this->accumulatorEmptyTime.store(duration_cast<nanoseconds>(accumulatorEmpty.time_since_epoch()).count(), std::memory_order_relaxed);
+
+			std::this_thread::sleep_until(lastTime + duration_cast<steady_clock::duration>((tickTime - accumulated) / this->speed));
+		}
+		});
+}
+
+double TickerThread::getInterpolationAlpha() const {
+	if (this->stopped || this->TPS <= 0.0) return 1.0;
+
+	nanoseconds sinceEmpty = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()) - nanoseconds(this->accumulatorEmptyTime.load(std::memory_order_relaxed));
+	double alpha = duration<double>(sinceEmpty).count() * this->speed * this->TPS;
+	if (alpha < 0.0) return 0.0;
+	if (alpha > 1.0) return 1.0;
+	return alpha;
+}
+
+void TickerThread::runTick() {
+	this->tickAction();
+}
+
+void TickerThread::stop() {
+	this->stopped = true;
+	if (this->thread.joinable() && this->thread.get_id() != std::this_thread::get_id()) this->thread.join();
+}
+
+};
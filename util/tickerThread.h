@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+namespace Util {
+
+using namespace std::chrono;
+
+/*
+	Runs tickAction at a fixed rate of TPS * speed ticks per second
+
+	Real time is added to an accumulator, and a tick is run for every 1 / TPS seconds in it, so the simulation keeps a fixed step while the thread wakes up irregularly
+	When the accumulator holds more than tickSkipTimeout the excess ticks are dropped
+	getInterpolationAlpha gives how far real time has advanced towards the next tick, to render in between ticks with Part::getInterpolatedCFrame
+
+	With a TPS of 0 or less the ticks are run back to back, as fast as tickAction allows
+*/
+class TickerThread {
+private:
+	std::thread thread;
+	std::atomic<bool> stopped{false};
+	double TPS;
+	double speed = 1.0;
+	milliseconds tickSkipTimeout;
+	std::function<void()> tickAction;
+	// steady_clock time at which the accumulator was last empty, in nanoseconds since the clock's epoch
+	std::atomic<long long> accumulatorEmptyTime{0};
+public:
+	TickerThread() : thread(), TPS(0.0), tickSkipTimeout(0), tickAction() {};
+	TickerThread(double targetTPS, milliseconds tickSkipTimeout, std::function<void()> tickAction);
+	~TickerThread();
+
+	TickerThread& operator=(TickerThread&& rhs) noexcept {
+		this->thread = std::thread();
+		this->stopped = rhs.stopped.load();
+		this->TPS = rhs.TPS;
+		this->tickSkipTimeout = rhs.tickSkipTimeout;
+		this->tickAction = std::move(rhs.tickAction);
+
+		return *this;
+	}
+
+	TickerThread& operator=(const TickerThread&) = delete;
+
+	void start();
+	void stop();
+
+	// may be called from within tickAction, takes effect from the next tick on
+	void setTPS(double newTPS) { this->TPS = newTPS; }
+	double getTPS() const { return this->TPS; }
+
+	void setSpeed(double newSpeed) { this->speed = newSpeed; }
+	double getSpeed() { return this->speed; }
+
+	void runTick();
+
+	/*
+		Fraction of a tick that has passed since the last tick, between 0 and 1
+		Is 1 while stopped, so the latest state is shown
+	*/
+	double getInterpolationAlpha() const;
+};
+
+};